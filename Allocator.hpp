@@ -131,23 +131,39 @@ namespace IrStd
 		 */
 		void* operator new(size_t size) 
 		{
-			return T::allocate(size);
+			return allocate(size);
 		}
 
 		void operator delete(void* ptr)
 		{
-			T::deallocate(ptr);
+			T().deallocate(ptr);
 		}
 
 		void* operator new[](size_t size)
 		{
-			return T::allocate(size);
+			return allocate(size);
 		}
 
 		void operator delete[](void* ptr)
 		{
-			T::deallocate(ptr);
+			T().deallocate(ptr);
+		}
+
+	private:
+		static void* allocate(size_t size)
+		{
+			void* ptr = T().allocate(size);
+			if (!ptr)
+			{
+				throw std::bad_alloc();
+			}
+			return ptr;
 		}
 	};
 }
 
+// Extra implementation
+#include "Allocator/AllocatorPool.hpp"
+#include "Allocator/AllocatorArena.hpp"
+#include "Allocator/AllocatorLarge.hpp"
+#include "Allocator/ObjectPool.hpp"
@@ -0,0 +1,179 @@
+#include <new>
+#include <algorithm>
+
+#include "../Allocator.hpp"
+#include "../Memory.hpp"
+
+namespace
+{
+	constexpr size_t HEADER_SIZE = IrStd::AllocatorArena::ALIGNMENT;
+	constexpr uint32_t TAG_ARENA = 0x4172656e;
+	constexpr uint32_t TAG_HEAP = 0x48656170;
+
+	static_assert(HEADER_SIZE >= sizeof(uint32_t), "The header is too small");
+
+	thread_local IrStd::ArenaScope* pCurrentScope = nullptr;
+
+	uint32_t& getHeader(void* const ptr) noexcept
+	{
+		return *reinterpret_cast<uint32_t*>(static_cast<char*>(ptr) - HEADER_SIZE);
+	}
+
+	size_t alignSize(const size_t size) noexcept
+	{
+		return (size + IrStd::AllocatorArena::ALIGNMENT - 1) & ~(IrStd::AllocatorArena::ALIGNMENT - 1);
+	}
+}
+
+// ---- IrStd::ArenaScope -----------------------------------------------------
+
+constexpr size_t IrStd::ArenaScope::CHUNK_SIZE;
+
+IrStd::ArenaScope::ArenaScope(const size_t chunkSize) noexcept
+		: m_pPrevious(pCurrentScope)
+		, m_chunkSize(chunkSize)
+		, m_pChunk(nullptr)
+		, m_pCursor(nullptr)
+		, m_pEnd(nullptr)
+		, m_allocated(0)
+		, m_reserved(0)
+		, m_nbAllocations(0)
+{
+	pCurrentScope = this;
+}
+
+IrStd::ArenaScope::~ArenaScope()
+{
+	IRSTD_ASSERT(pCurrentScope == this, "Arena scopes must be destroyed in the reverse order of their creation");
+	pCurrentScope = m_pPrevious;
+
+	releaseChunks(m_pChunk);
+	Memory::getInstance().releaseArena(m_allocated, m_nbAllocations);
+}
+
+IrStd::ArenaScope* IrStd::ArenaScope::getCurrent() noexcept
+{
+	return pCurrentScope;
+}
+
+bool IrStd::ArenaScope::addChunk(const size_t size) noexcept
+{
+	const size_t headerSize = alignSize(sizeof(Chunk));
+	Chunk* const pChunk = static_cast<Chunk*>(::operator new(headerSize + size, std::nothrow));
+	if (!pChunk)
+	{
+		return false;
+	}
+	pChunk->m_pNext = m_pChunk;
+	pChunk->m_size = headerSize + size;
+	m_pChunk = pChunk;
+	m_pCursor = reinterpret_cast<char*>(pChunk) + headerSize;
+	m_pEnd = m_pCursor + size;
+	m_reserved += pChunk->m_size;
+	Memory::getInstance().reserveArena(static_cast<int64_t>(pChunk->m_size));
+
+	return true;
+}
+
+void IrStd::ArenaScope::releaseChunks(Chunk* pChunk) noexcept
+{
+	while (pChunk)
+	{
+		Chunk* const pNext = pChunk->m_pNext;
+		m_reserved -= pChunk->m_size;
+		Memory::getInstance().reserveArena(-static_cast<int64_t>(pChunk->m_size));
+		::operator delete(pChunk);
+		pChunk = pNext;
+	}
+}
+
+void* IrStd::ArenaScope::allocate(const size_t size) noexcept
+{
+	const size_t alignedSize = alignSize(size);
+	if (static_cast<size_t>(m_pEnd - m_pCursor) < alignedSize)
+	{
+		// Large allocations get their own chunk
+		if (!addChunk(std::max(alignedSize, m_chunkSize)))
+		{
+			return nullptr;
+		}
+	}
+
+	void* const ptr = m_pCursor;
+	m_pCursor += alignedSize;
+	m_allocated += size;
+	++m_nbAllocations;
+
+	return ptr;
+}
+
+void IrStd::ArenaScope::reset() noexcept
+{
+	if (m_pChunk)
+	{
+		releaseChunks(m_pChunk->m_pNext);
+		m_pChunk->m_pNext = nullptr;
+		m_pCursor = reinterpret_cast<char*>(m_pChunk) + alignSize(sizeof(Chunk));
+		m_pEnd = reinterpret_cast<char*>(m_pChunk) + m_pChunk->m_size;
+	}
+}
+
+size_t IrStd::ArenaScope::getAllocated() const noexcept
+{
+	return m_allocated;
+}
+
+size_t IrStd::ArenaScope::getReserved() const noexcept
+{
+	return m_reserved;
+}
+
+size_t IrStd::ArenaScope::getNbAllocations() const noexcept
+{
+	return m_nbAllocations;
+}
+
+// ---- IrStd::AllocatorArena -------------------------------------------------
+
+void* IrStd::AllocatorArena::allocateImpl(const size_t size) noexcept
+{
+	// Use the heap if there is no active scope
+	if (!pCurrentScope)
+	{
+		char* const pBlock = static_cast<char*>(::operator new(HEADER_SIZE + size, std::nothrow));
+		if (!pBlock)
+		{
+			return nullptr;
+		}
+		void* const ptr = pBlock + HEADER_SIZE;
+		getHeader(ptr) = TAG_HEAP;
+		return ptr;
+	}
+
+	char* const pBlock = static_cast<char*>(pCurrentScope->allocate(HEADER_SIZE + size));
+	if (!pBlock)
+	{
+		return nullptr;
+	}
+	void* const ptr = pBlock + HEADER_SIZE;
+	getHeader(ptr) = TAG_ARENA;
+	return ptr;
+}
+
+void IrStd::AllocatorArena::deallocateImpl(void* ptr) noexcept
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	const uint32_t tag = getHeader(ptr);
+	IRSTD_ASSERT(tag == TAG_ARENA || tag == TAG_HEAP, "Corrupted arena block "
+			<< static_cast<void*>(ptr) << ", it might have outlived its scope");
+
+	// Memory from the arena is released when the scope terminates
+	if (tag == TAG_HEAP)
+	{
+		::operator delete(static_cast<char*>(ptr) - HEADER_SIZE);
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace IrStd
+{
+	/**
+	 * \brief Monotonic memory region bound to the current thread
+	 *
+	 * While an ArenaScope is alive, all the allocations made through
+	 * \ref AllocatorArena on this thread are served by bumping a pointer into
+	 * chunks owned by the scope. Individual deallocations are no-ops, all the
+	 * memory is released at once when the scope is destroyed.
+	 *
+	 * Scopes can be nested, the innermost one is used.
+	 *
+	 * \note The memory allocated within a scope must not outlive it.
+	 *
+	 * Warning this class is not thread safe, a scope must be created and
+	 * destroyed by the same thread.
+	 */
+	class ArenaScope
+	{
+	public:
+		/**
+		 * Default size of the chunks reserved by the arena
+		 */
+		static constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+		explicit ArenaScope(const size_t chunkSize = CHUNK_SIZE) noexcept;
+		~ArenaScope();
+
+		ArenaScope(const ArenaScope&) = delete;
+		ArenaScope& operator=(const ArenaScope&) = delete;
+
+		/**
+		 * \brief Allocate memory from the arena
+		 *
+		 * \return nullptr if the memory is exhausted.
+		 */
+		void* allocate(const size_t size) noexcept;
+
+		/**
+		 * \brief Release all the memory allocated so far,
+		 * only the most recent chunk is kept for later use.
+		 */
+		void reset() noexcept;
+
+		/**
+		 * \brief Amount of memory served by this arena (in bytes)
+		 */
+		size_t getAllocated() const noexcept;
+
+		/**
+		 * \brief Amount of memory currently reserved by this arena (in bytes)
+		 */
+		size_t getReserved() const noexcept;
+
+		/**
+		 * \brief Number of allocations served by this arena
+		 */
+		size_t getNbAllocations() const noexcept;
+
+		/**
+		 * \brief Get the innermost scope of the current thread
+		 *
+		 * \return nullptr if there is no active scope.
+		 */
+		static ArenaScope* getCurrent() noexcept;
+
+	private:
+		struct Chunk
+		{
+			Chunk* m_pNext;
+			size_t m_size;
+		};
+
+		bool addChunk(const size_t size) noexcept;
+		void releaseChunks(Chunk* pChunk) noexcept;
+
+		ArenaScope* m_pPrevious;
+		const size_t m_chunkSize;
+		Chunk* m_pChunk;
+		char* m_pCursor;
+		char* m_pEnd;
+		size_t m_allocated;
+		size_t m_reserved;
+		size_t m_nbAllocations;
+	};
+
+	/**
+	 * \brief Allocator using the current \ref ArenaScope
+	 *
+	 * If no scope is active on the current thread, the memory is taken from
+	 * the heap and released normally.
+	 */
+	class AllocatorArena : public Allocator
+	{
+	public:
+		/**
+		 * Alignment guaranteed for all the allocations
+		 */
+		static constexpr size_t ALIGNMENT = 16;
+
+		void* allocate(size_t size) noexcept
+		{
+			return allocateImpl(size);
+		}
+
+		void deallocate(void* ptr)
+		{
+			deallocateImpl(ptr);
+		}
+
+	private:
+		static void* allocateImpl(const size_t size) noexcept;
+		static void deallocateImpl(void* ptr) noexcept;
+	};
+
+	/**
+	 * String which memory is taken from the current arena
+	 */
+	typedef std::basic_string<char, std::char_traits<char>, AllocatorObj<char, AllocatorArena>> ArenaString;
+}
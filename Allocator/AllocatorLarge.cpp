@@ -0,0 +1,239 @@
+#include <atomic>
+#include <cstdlib>
+
+#include "../Allocator.hpp"
+#include "../Assert.hpp"
+#include "../Compiler.hpp"
+#include "../Memory.hpp"
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+#endif
+
+namespace
+{
+	constexpr size_t HEADER_SIZE = IrStd::AllocatorLarge::ALIGNMENT;
+	constexpr uint32_t TAG_HEAP = 0x48656170;
+	constexpr uint32_t TAG_MMAP = 0x4d6d6170;
+	constexpr uint32_t FLAG_HUGETLB = 1;
+	// Accounted by IrStd::Memory, like the blocks from new
+	constexpr uint32_t FLAG_RECORDED = 2;
+
+	// Memory policy from linux/mempolicy.h, pages are taken from other nodes if the preferred one is full
+	constexpr int POLICY_PREFERRED = 1;
+
+	struct Header
+	{
+		uint32_t m_tag;
+		uint32_t m_flags;
+		void* m_pBase;
+		size_t m_mappedSize;
+	};
+
+	static_assert(HEADER_SIZE >= sizeof(Header), "The header is too small");
+
+	thread_local int currentNode = -1;
+
+	std::atomic<size_t> mapped(0);
+	std::atomic<size_t> nbMappings(0);
+	std::atomic<size_t> nbHugeTLBMappings(0);
+	std::atomic<size_t> nbBindFailures(0);
+
+	Header& getHeader(void* const ptr) noexcept
+	{
+		return *reinterpret_cast<Header*>(static_cast<char*>(ptr) - HEADER_SIZE);
+	}
+
+	size_t alignSize(const size_t size, const size_t alignment) noexcept
+	{
+		return (size + alignment - 1) & ~(alignment - 1);
+	}
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	void* mapPages(const size_t size, size_t& mappedSize, uint32_t& flags) noexcept
+	{
+		constexpr int PROTECTION = PROT_READ | PROT_WRITE;
+		constexpr int MAP_FLAGS = MAP_PRIVATE | MAP_ANONYMOUS;
+
+		if (size < IrStd::AllocatorLarge::HUGE_PAGE_SIZE)
+		{
+			mappedSize = alignSize(size, static_cast<size_t>(::sysconf(_SC_PAGESIZE)));
+			void* const pBase = ::mmap(nullptr, mappedSize, PROTECTION, MAP_FLAGS, -1, 0);
+			return (pBase == MAP_FAILED) ? nullptr : pBase;
+		}
+
+		mappedSize = alignSize(size, IrStd::AllocatorLarge::HUGE_PAGE_SIZE);
+
+		// Explicit huge pages, only available if the system reserved some
+		{
+			void* const pBase = ::mmap(nullptr, mappedSize, PROTECTION, MAP_FLAGS | MAP_HUGETLB, -1, 0);
+			if (pBase != MAP_FAILED)
+			{
+				flags |= FLAG_HUGETLB;
+				return pBase;
+			}
+		}
+
+		// Transparent huge pages, the mapping must be aligned on a huge page boundary
+		char* const pBase = static_cast<char*>(::mmap(nullptr, mappedSize + IrStd::AllocatorLarge::HUGE_PAGE_SIZE,
+				PROTECTION, MAP_FLAGS, -1, 0));
+		if (pBase == MAP_FAILED)
+		{
+			return nullptr;
+		}
+		char* const pAligned = reinterpret_cast<char*>(alignSize(reinterpret_cast<size_t>(pBase),
+				IrStd::AllocatorLarge::HUGE_PAGE_SIZE));
+		const size_t head = static_cast<size_t>(pAligned - pBase);
+		// The head is below a huge page, so there is always a tail to release
+		if (head)
+		{
+			::munmap(pBase, head);
+		}
+		::munmap(pAligned + mappedSize, IrStd::AllocatorLarge::HUGE_PAGE_SIZE - head);
+		// Only a hint, this fails if transparent huge pages are disabled
+		::madvise(pAligned, mappedSize, MADV_HUGEPAGE);
+
+		return pAligned;
+	}
+
+	/**
+	 * Must be called before the pages are touched
+	 */
+	void bindToNode(void* const pBase, const size_t size, const int node) noexcept
+	{
+		unsigned long nodeMask = 0;
+		if (node < 0 || static_cast<size_t>(node) >= sizeof(nodeMask) * 8)
+		{
+			nbBindFailures.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		nodeMask = 1UL << node;
+		// Call the system directly rather than depending on libnuma
+		if (::syscall(SYS_mbind, pBase, size, POLICY_PREFERRED, &nodeMask, sizeof(nodeMask) * 8 + 1, 0) != 0)
+		{
+			nbBindFailures.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+#endif
+}
+
+// ---- IrStd::AllocatorLarge -------------------------------------------------
+
+constexpr size_t IrStd::AllocatorLarge::ALIGNMENT;
+constexpr size_t IrStd::AllocatorLarge::MMAP_THRESHOLD;
+constexpr size_t IrStd::AllocatorLarge::HUGE_PAGE_SIZE;
+
+void IrStd::AllocatorLarge::setNode(const int node) noexcept
+{
+	currentNode = node;
+}
+
+int IrStd::AllocatorLarge::getNode() noexcept
+{
+	return currentNode;
+}
+
+size_t IrStd::AllocatorLarge::getMapped() noexcept
+{
+	return mapped.load(std::memory_order_relaxed);
+}
+
+size_t IrStd::AllocatorLarge::getNbMappings() noexcept
+{
+	return nbMappings.load(std::memory_order_relaxed);
+}
+
+size_t IrStd::AllocatorLarge::getNbHugeTLBMappings() noexcept
+{
+	return nbHugeTLBMappings.load(std::memory_order_relaxed);
+}
+
+size_t IrStd::AllocatorLarge::getNbBindFailures() noexcept
+{
+	return nbBindFailures.load(std::memory_order_relaxed);
+}
+
+void* IrStd::AllocatorLarge::allocateImpl(const size_t size) noexcept
+{
+	const size_t totalSize = size + HEADER_SIZE;
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	if (size >= MMAP_THRESHOLD)
+	{
+		size_t mappedSize = 0;
+		uint32_t flags = 0;
+		void* const pBase = mapPages(totalSize, mappedSize, flags);
+		if (!pBase)
+		{
+			return nullptr;
+		}
+		if (currentNode != -1)
+		{
+			bindToNode(pBase, mappedSize, currentNode);
+		}
+
+		mapped.fetch_add(mappedSize, std::memory_order_relaxed);
+		nbMappings.fetch_add(1, std::memory_order_relaxed);
+		if (flags & FLAG_HUGETLB)
+		{
+			nbHugeTLBMappings.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		return record(static_cast<char*>(pBase) + HEADER_SIZE, size, TAG_MMAP, flags, pBase, mappedSize);
+	}
+#endif
+
+	void* pBase = nullptr;
+	if (::posix_memalign(&pBase, ALIGNMENT, totalSize) != 0)
+	{
+		return nullptr;
+	}
+	return record(static_cast<char*>(pBase) + HEADER_SIZE, size, TAG_HEAP, 0, pBase, 0);
+}
+
+void* IrStd::AllocatorLarge::record(void* const ptr, const size_t size, const uint32_t tag, uint32_t flags,
+		void* const pBase, const size_t mappedSize) noexcept
+{
+	// Accounted as if allocated with new, these blocks can be the largest of the process
+	if (Memory::isRecording())
+	{
+		flags |= FLAG_RECORDED;
+		Memory::getInstance().recordAlloc(ptr, size);
+	}
+	getHeader(ptr) = Header{tag, flags, pBase, mappedSize};
+	return ptr;
+}
+
+void IrStd::AllocatorLarge::deallocateImpl(void* ptr) noexcept
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	const Header header = getHeader(ptr);
+	IRSTD_ASSERT(header.m_tag == TAG_HEAP || header.m_tag == TAG_MMAP,
+			"Pointer " << ptr << " was not allocated by AllocatorLarge");
+	if (header.m_flags & FLAG_RECORDED)
+	{
+		Memory::getInstance().recordFree(ptr);
+	}
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	if (header.m_tag == TAG_MMAP)
+	{
+		::munmap(header.m_pBase, header.m_mappedSize);
+		mapped.fetch_sub(header.m_mappedSize, std::memory_order_relaxed);
+		nbMappings.fetch_sub(1, std::memory_order_relaxed);
+		if (header.m_flags & FLAG_HUGETLB)
+		{
+			nbHugeTLBMappings.fetch_sub(1, std::memory_order_relaxed);
+		}
+		return;
+	}
+#endif
+
+	std::free(header.m_pBase);
+}
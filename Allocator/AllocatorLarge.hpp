@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace IrStd
+{
+	/**
+	 * \brief Allocator for large and long-lived buffers
+	 *
+	 * Allocations of at least \ref MMAP_THRESHOLD bytes are mapped directly with
+	 * mmap. Those of at least \ref HUGE_PAGE_SIZE bytes are first tried on
+	 * explicit huge pages (MAP_HUGETLB), and otherwise aligned on a huge page
+	 * boundary and advised for transparent huge pages. This reduces the TLB
+	 * misses when walking through very large buffers.
+	 *
+	 * If a NUMA node is set for the current thread (see \ref setNode), the
+	 * mapping is bound to this node with a preferred policy, so that the
+	 * kernel falls back to other nodes when it is full. Without a node,
+	 * pages are placed on the node of the thread touching them first.
+	 *
+	 * Smaller allocations are taken from the heap.
+	 *
+	 * The blocks are accounted by \ref Memory as if allocated with new: they
+	 * are part of the statistics, the budgets and the leak report.
+	 */
+	class AllocatorLarge : public Allocator
+	{
+	public:
+		/**
+		 * Alignment guaranteed for all the allocations
+		 */
+		static constexpr size_t ALIGNMENT = 64;
+
+		/**
+		 * Allocations from this size are mapped directly
+		 */
+		static constexpr size_t MMAP_THRESHOLD = 256 * 1024;
+
+		/**
+		 * Allocations from this size use huge pages
+		 *
+		 * \note Each block is preceded by a header of \ref ALIGNMENT bytes, in the
+		 * same mapping. A request of exactly n huge pages therefore maps n + 1
+		 * of them, sizing buffers a header below a multiple of this size avoids it.
+		 */
+		static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+		void* allocate(size_t size) noexcept
+		{
+			return allocateImpl(size);
+		}
+
+		void deallocate(void* ptr)
+		{
+			deallocateImpl(ptr);
+		}
+
+		/**
+		 * \brief Set the NUMA node of the next mappings of this thread
+		 *
+		 * \param node The node index, or -1 to use the default policy.
+		 */
+		static void setNode(const int node) noexcept;
+		static int getNode() noexcept;
+
+		/**
+		 * \brief Memory currently mapped by this allocator (in bytes)
+		 */
+		static size_t getMapped() noexcept;
+
+		/**
+		 * \brief Number of live mappings, and how many use explicit huge pages
+		 */
+		static size_t getNbMappings() noexcept;
+		static size_t getNbHugeTLBMappings() noexcept;
+
+		/**
+		 * \brief Number of mappings that could not be bound to their NUMA node
+		 */
+		static size_t getNbBindFailures() noexcept;
+
+	private:
+		static void* allocateImpl(const size_t size) noexcept;
+		static void deallocateImpl(void* ptr) noexcept;
+
+		/**
+		 * Write the header of a block and account it in the memory statistics
+		 */
+		static void* record(void* const ptr, const size_t size, const uint32_t tag, uint32_t flags,
+				void* const pBase, const size_t mappedSize) noexcept;
+	};
+}
@@ -0,0 +1,321 @@
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#include "../Allocator.hpp"
+
+namespace
+{
+	constexpr size_t HEADER_SIZE = IrStd::AllocatorPool::ALIGNMENT;
+	constexpr uint32_t CLASS_LARGE = 0xffffffff;
+	constexpr size_t CLASS_SIZE_LIST[] = {16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768,
+			1024, 1536, 2048, 3072, 4096};
+	constexpr size_t NB_CLASSES = sizeof(CLASS_SIZE_LIST) / sizeof(CLASS_SIZE_LIST[0]);
+
+	/**
+	 * Amount of memory a thread can cache per class before releasing
+	 * half of it to the shared list
+	 */
+	constexpr size_t CACHE_MAX_SIZE = 64 * 1024;
+	constexpr size_t CACHE_MIN_BLOCKS = 8;
+
+	static_assert(CLASS_SIZE_LIST[NB_CLASSES - 1] == IrStd::AllocatorPool::MAX_SIZE,
+			"The last class must match the maximum size");
+	static_assert(HEADER_SIZE >= sizeof(uint32_t), "The header is too small");
+
+	struct FreeBlock
+	{
+		FreeBlock* m_pNext;
+	};
+
+	uint32_t& getHeader(void* const ptr) noexcept
+	{
+		return *reinterpret_cast<uint32_t*>(static_cast<char*>(ptr) - HEADER_SIZE);
+	}
+
+	/**
+	 * Classes are spaced by 16 bytes up to 64 bytes, then by 2 classes per power of 2
+	 */
+	size_t getClassIndex(const size_t size) noexcept
+	{
+		if (size <= 64)
+		{
+			return (size) ? (size - 1) / 16 : 0;
+		}
+		const size_t log2 = 63 - static_cast<size_t>(__builtin_clzll(static_cast<unsigned long long>(size - 1)));
+		const size_t halfStep = (static_cast<size_t>(1) << log2) + (static_cast<size_t>(1) << (log2 - 1));
+		return 2 * (log2 - 6) + ((size <= halfStep) ? 4 : 5);
+	}
+
+	size_t getCacheMaxBlocks(const size_t classIndex) noexcept
+	{
+		const size_t nbBlocks = CACHE_MAX_SIZE / CLASS_SIZE_LIST[classIndex];
+		return (nbBlocks < CACHE_MIN_BLOCKS) ? CACHE_MIN_BLOCKS : nbBlocks;
+	}
+
+	// ---- Shared lists ------------------------------------------------------
+
+	class Central
+	{
+	public:
+		Central() noexcept
+				: m_reserved(0)
+		{
+		}
+
+		/**
+		 * Take up to nbBlocks from the shared list of a class, carve a new slab if empty.
+		 *
+		 * \return The number of blocks taken, 0 if the memory is exhausted.
+		 */
+		size_t take(const size_t classIndex, const size_t nbBlocks, FreeBlock*& pHead) noexcept
+		{
+			auto& list = m_listList[classIndex];
+			std::lock_guard<std::mutex> lock(list.m_mutex);
+			if (!list.m_pHead && !carve(classIndex))
+			{
+				return 0;
+			}
+			size_t nbTaken = 0;
+			while (list.m_pHead && nbTaken < nbBlocks)
+			{
+				FreeBlock* const pBlock = list.m_pHead;
+				list.m_pHead = pBlock->m_pNext;
+				pBlock->m_pNext = pHead;
+				pHead = pBlock;
+				++nbTaken;
+			}
+			return nbTaken;
+		}
+
+		/**
+		 * Give a list of blocks back to the shared list of a class
+		 */
+		void give(const size_t classIndex, FreeBlock* const pHead, FreeBlock* const pTail) noexcept
+		{
+			auto& list = m_listList[classIndex];
+			std::lock_guard<std::mutex> lock(list.m_mutex);
+			pTail->m_pNext = list.m_pHead;
+			list.m_pHead = pHead;
+		}
+
+		size_t getReserved() const noexcept
+		{
+			return m_reserved.load();
+		}
+
+	private:
+		/**
+		 * Cut a new slab into blocks of a class, the list lock must be held.
+		 */
+		bool carve(const size_t classIndex) noexcept
+		{
+			// Never released, see ObjectPoolImpl::Registry::getInstance()
+			char* const pSlab = static_cast<char*>(std::malloc(IrStd::AllocatorPool::SLAB_SIZE));
+			if (!pSlab)
+			{
+				return false;
+			}
+			m_reserved.fetch_add(IrStd::AllocatorPool::SLAB_SIZE);
+
+			auto& list = m_listList[classIndex];
+			const size_t stride = HEADER_SIZE + CLASS_SIZE_LIST[classIndex];
+			for (size_t offset = 0; offset + stride <= IrStd::AllocatorPool::SLAB_SIZE; offset += stride)
+			{
+				void* const ptr = pSlab + offset + HEADER_SIZE;
+				getHeader(ptr) = static_cast<uint32_t>(classIndex);
+				FreeBlock* const pBlock = static_cast<FreeBlock*>(ptr);
+				pBlock->m_pNext = list.m_pHead;
+				list.m_pHead = pBlock;
+			}
+			return true;
+		}
+
+		struct alignas(64) List
+		{
+			List() noexcept
+					: m_pHead(nullptr)
+			{
+			}
+			std::mutex m_mutex;
+			FreeBlock* m_pHead;
+		};
+
+		List m_listList[NB_CLASSES];
+		std::atomic<size_t> m_reserved;
+	};
+
+	/**
+	 * Never destroyed, same as the object pool registry (see ObjectPool.cpp)
+	 */
+	Central& getCentral() noexcept
+	{
+		alignas(Central) static char buffer[sizeof(Central)];
+		static Central* const pCentral = new (buffer) Central();
+		return *pCentral;
+	}
+
+	// ---- Thread cache ------------------------------------------------------
+
+	struct ThreadCache
+	{
+		FreeBlock* m_pHead[NB_CLASSES];
+		size_t m_nbBlocks[NB_CLASSES];
+	};
+
+	thread_local ThreadCache threadCache;
+	thread_local bool isThreadCacheRegistered = false;
+	// Set once the thread cache has been flushed at thread exit
+	thread_local bool isThreadCacheTerminated = false;
+
+	/**
+	 * Release the first nbBlocks of the thread cache to the shared list
+	 */
+	void releaseFromCache(const size_t classIndex, size_t nbBlocks) noexcept
+	{
+		FreeBlock* const pHead = threadCache.m_pHead[classIndex];
+		if (!pHead || !nbBlocks)
+		{
+			return;
+		}
+		FreeBlock* pTail = pHead;
+		size_t nbReleased = 1;
+		while (pTail->m_pNext && nbReleased < nbBlocks)
+		{
+			pTail = pTail->m_pNext;
+			++nbReleased;
+		}
+		threadCache.m_pHead[classIndex] = pTail->m_pNext;
+		threadCache.m_nbBlocks[classIndex] -= nbReleased;
+		getCentral().give(classIndex, pHead, pTail);
+	}
+
+	void registerThreadCache() noexcept
+	{
+		class Release
+		{
+		public:
+			~Release()
+			{
+				IrStd::AllocatorPool::flushThreadCache();
+				isThreadCacheTerminated = true;
+			}
+		};
+		static thread_local Release release;
+		(void) release;
+		isThreadCacheRegistered = true;
+	}
+}
+
+// ---- IrStd::AllocatorPool --------------------------------------------------
+
+size_t IrStd::AllocatorPool::getNbClasses() noexcept
+{
+	return NB_CLASSES;
+}
+
+size_t IrStd::AllocatorPool::getClassSize(const size_t classIndex) noexcept
+{
+	return (classIndex < NB_CLASSES) ? CLASS_SIZE_LIST[classIndex] : 0;
+}
+
+size_t IrStd::AllocatorPool::getReservedMemory() noexcept
+{
+	return getCentral().getReserved();
+}
+
+void IrStd::AllocatorPool::flushThreadCache() noexcept
+{
+	for (size_t classIndex = 0; classIndex < NB_CLASSES; ++classIndex)
+	{
+		releaseFromCache(classIndex, threadCache.m_nbBlocks[classIndex]);
+	}
+}
+
+void* IrStd::AllocatorPool::allocateImpl(const size_t size) noexcept
+{
+	// Large allocations
+	if (size > MAX_SIZE)
+	{
+		char* const pBlock = static_cast<char*>(::operator new(HEADER_SIZE + size, std::nothrow));
+		if (!pBlock)
+		{
+			return nullptr;
+		}
+		void* const ptr = pBlock + HEADER_SIZE;
+		getHeader(ptr) = CLASS_LARGE;
+		return ptr;
+	}
+
+	const size_t classIndex = getClassIndex(size);
+
+	// The thread is terminating, use directly the shared list
+	if (isThreadCacheTerminated)
+	{
+		FreeBlock* pBlock = nullptr;
+		return (getCentral().take(classIndex, 1, pBlock)) ? pBlock : nullptr;
+	}
+
+	if (!isThreadCacheRegistered)
+	{
+		registerThreadCache();
+	}
+
+	// Refill the thread cache if needed
+	if (!threadCache.m_pHead[classIndex])
+	{
+		const size_t nbTaken = getCentral().take(classIndex, getCacheMaxBlocks(classIndex) / 2,
+				threadCache.m_pHead[classIndex]);
+		if (!nbTaken)
+		{
+			return nullptr;
+		}
+		threadCache.m_nbBlocks[classIndex] += nbTaken;
+	}
+
+	FreeBlock* const pBlock = threadCache.m_pHead[classIndex];
+	threadCache.m_pHead[classIndex] = pBlock->m_pNext;
+	--threadCache.m_nbBlocks[classIndex];
+
+	return pBlock;
+}
+
+void IrStd::AllocatorPool::deallocateImpl(void* ptr) noexcept
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	const uint32_t classIndex = getHeader(ptr);
+	if (classIndex == CLASS_LARGE)
+	{
+		::operator delete(static_cast<char*>(ptr) - HEADER_SIZE);
+		return;
+	}
+
+	FreeBlock* const pBlock = static_cast<FreeBlock*>(ptr);
+
+	// The thread is terminating, use directly the shared list
+	if (isThreadCacheTerminated)
+	{
+		getCentral().give(classIndex, pBlock, pBlock);
+		return;
+	}
+
+	if (!isThreadCacheRegistered)
+	{
+		registerThreadCache();
+	}
+
+	pBlock->m_pNext = threadCache.m_pHead[classIndex];
+	threadCache.m_pHead[classIndex] = pBlock;
+
+	// Release half of the cache if it is full
+	const size_t maxBlocks = getCacheMaxBlocks(classIndex);
+	if (++threadCache.m_nbBlocks[classIndex] > maxBlocks)
+	{
+		releaseFromCache(classIndex, maxBlocks / 2);
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace IrStd
+{
+	/**
+	 * \brief Size-class pool allocator
+	 *
+	 * Small allocations (up to \ref MAX_SIZE bytes) are rounded up to a size class
+	 * and served from a thread-local cache of free blocks. When the cache of a
+	 * class is empty, a batch of blocks is taken from a shared list protected by
+	 * a per-class lock, which is itself refilled by carving slabs of
+	 * \ref SLAB_SIZE bytes. Larger allocations go directly to the heap.
+	 *
+	 * Every block is preceded by a small header holding its size class,
+	 * this is needed as \ref Allocator::deallocate does not provide the size.
+	 *
+	 * \note Slabs are never returned to the system, the memory is kept by the pool
+	 * for later reuse.
+	 */
+	class AllocatorPool : public Allocator
+	{
+	public:
+		/**
+		 * Largest allocation size handled by the pool
+		 */
+		static constexpr size_t MAX_SIZE = 4096;
+
+		/**
+		 * Size of a slab, this is the granularity at which the pool reserves memory
+		 */
+		static constexpr size_t SLAB_SIZE = 64 * 1024;
+
+		/**
+		 * Alignment guaranteed for all the allocations
+		 */
+		static constexpr size_t ALIGNMENT = 16;
+
+		void* allocate(size_t size) noexcept
+		{
+			return allocateImpl(size);
+		}
+
+		void deallocate(void* ptr)
+		{
+			deallocateImpl(ptr);
+		}
+
+		/**
+		 * \brief Number of size classes
+		 */
+		static size_t getNbClasses() noexcept;
+
+		/**
+		 * \brief Size of the blocks of a specific class
+		 */
+		static size_t getClassSize(const size_t classIndex) noexcept;
+
+		/**
+		 * \brief Amount of memory reserved by the pool (in bytes)
+		 */
+		static size_t getReservedMemory() noexcept;
+
+		/**
+		 * \brief Return the blocks cached by the current thread to the shared lists
+		 */
+		static void flushThreadCache() noexcept;
+
+	private:
+		static void* allocateImpl(const size_t size) noexcept;
+		static void deallocateImpl(void* ptr) noexcept;
+	};
+}
@@ -0,0 +1,502 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include <cxxabi.h>
+
+#include "../Allocator.hpp"
+
+namespace
+{
+	constexpr size_t HEADER_SIZE = IrStd::ObjectPoolBase::ALIGNMENT;
+
+	/**
+	 * Number of objects a thread can cache per pool before releasing
+	 * half of them to the shared list
+	 */
+	constexpr size_t CACHE_MAX_BLOCKS = 128;
+
+	static_assert(HEADER_SIZE >= sizeof(IrStd::ObjectPoolBase*), "The header is too small");
+
+	typedef IrStd::ObjectPoolImpl::FreeBlock FreeBlock;
+
+	/**
+	 * The header holds the pool owning the block, nullptr for heap allocations
+	 */
+	IrStd::ObjectPoolBase*& getHeader(void* const ptr) noexcept
+	{
+		return *reinterpret_cast<IrStd::ObjectPoolBase**>(static_cast<char*>(ptr) - HEADER_SIZE);
+	}
+
+	size_t alignSize(const size_t size) noexcept
+	{
+		return (size + IrStd::ObjectPoolBase::ALIGNMENT - 1) & ~(IrStd::ObjectPoolBase::ALIGNMENT - 1);
+	}
+
+	// ---- Thread cache ------------------------------------------------------
+
+	/**
+	 * Counters are only written by their owner thread and read
+	 * while holding the registry lock.
+	 */
+	struct ThreadCache
+	{
+		FreeBlock* m_pHead;
+		size_t m_nbBlocks;
+		std::atomic<int64_t> m_nbInUse;
+		std::atomic<uint64_t> m_nbAllocations;
+		std::atomic<uint64_t> m_nbHits;
+	};
+
+	struct ThreadCacheList
+	{
+		ThreadCache m_cacheList[IrStd::ObjectPoolBase::MAX_POOLS];
+		ThreadCacheList* m_pPrevious;
+		ThreadCacheList* m_pNext;
+	};
+
+	thread_local ThreadCacheList threadCacheList;
+	thread_local bool isThreadCacheRegistered = false;
+	// Set once the thread cache has been flushed at thread exit
+	thread_local bool isThreadCacheTerminated = false;
+
+	void increment(std::atomic<uint64_t>& counter) noexcept
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	void add(std::atomic<int64_t>& counter, const int64_t value) noexcept
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+}
+
+// ---- IrStd::ObjectPoolImpl::Registry ---------------------------------------
+
+/**
+ * Keep track of the pools and of the thread caches
+ */
+class IrStd::ObjectPoolImpl::Registry
+{
+public:
+	Registry() noexcept
+			: m_pThreadList(nullptr)
+			, m_pPoolList(nullptr)
+			, m_nbPools(0)
+	{
+		for (auto& pPool : m_poolList)
+		{
+			pPool.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * The registry is never destroyed, as thread caches can be flushed
+	 * after the static objects are destroyed. The same goes for the pools,
+	 * and for the shared lists of AllocatorPool. Their slabs are taken with
+	 * malloc, so that they do not show in the memory leak report.
+	 */
+	static Registry& getInstance() noexcept
+	{
+		alignas(Registry) static char buffer[sizeof(Registry)];
+		static Registry* const pRegistry = new (buffer) Registry();
+		return *pRegistry;
+	}
+
+	size_t reserveIndex() noexcept
+	{
+		return m_nbPools.fetch_add(1);
+	}
+
+	/**
+	 * Make a fully constructed pool visible
+	 */
+	void addPool(ObjectPoolBase* const pPool) noexcept
+	{
+		if (pPool->m_index < ObjectPoolBase::MAX_POOLS)
+		{
+			m_poolList[pPool->m_index].store(pPool);
+		}
+		pPool->m_pNext = m_pPoolList.load();
+		while (!m_pPoolList.compare_exchange_weak(pPool->m_pNext, pPool))
+		{
+		}
+	}
+
+	ObjectPoolBase* getPoolList() const noexcept
+	{
+		return m_pPoolList.load();
+	}
+
+	/**
+	 * Called the first time a thread uses a pool with a cache
+	 */
+	void registerThread() noexcept
+	{
+		class Release
+		{
+		public:
+			~Release()
+			{
+				Registry::getInstance().unregisterThread();
+			}
+		};
+		static thread_local Release release;
+		(void) release;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			threadCacheList.m_pPrevious = nullptr;
+			threadCacheList.m_pNext = m_pThreadList;
+			if (m_pThreadList)
+			{
+				m_pThreadList->m_pPrevious = &threadCacheList;
+			}
+			m_pThreadList = &threadCacheList;
+		}
+		isThreadCacheRegistered = true;
+	}
+
+	/**
+	 * Return the cache of the current thread to the pools and account its counters
+	 */
+	void unregisterThread() noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t index = 0; index < getNbPoolsWithCache(); ++index)
+		{
+			ObjectPoolBase* const pPool = m_poolList[index].load();
+			if (!pPool)
+			{
+				continue;
+			}
+			auto& cache = threadCacheList.m_cacheList[index];
+			pPool->releaseFromCache(cache.m_nbBlocks);
+			pPool->m_retiredNbInUse.fetch_add(cache.m_nbInUse.load(std::memory_order_relaxed));
+			pPool->m_retiredNbAllocations.fetch_add(cache.m_nbAllocations.load(std::memory_order_relaxed));
+			pPool->m_retiredNbHits.fetch_add(cache.m_nbHits.load(std::memory_order_relaxed));
+		}
+
+		if (threadCacheList.m_pPrevious)
+		{
+			threadCacheList.m_pPrevious->m_pNext = threadCacheList.m_pNext;
+		}
+		else
+		{
+			m_pThreadList = threadCacheList.m_pNext;
+		}
+		if (threadCacheList.m_pNext)
+		{
+			threadCacheList.m_pNext->m_pPrevious = threadCacheList.m_pPrevious;
+		}
+		isThreadCacheTerminated = true;
+	}
+
+	void getStatistics(const ObjectPoolBase& pool, ObjectPoolBase::Statistics& stats) noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		stats.m_nbInUse = pool.m_retiredNbInUse.load();
+		stats.m_nbAllocations = pool.m_retiredNbAllocations.load();
+		stats.m_nbHits = pool.m_retiredNbHits.load();
+		if (pool.m_index < ObjectPoolBase::MAX_POOLS)
+		{
+			for (auto pCur = m_pThreadList; pCur; pCur = pCur->m_pNext)
+			{
+				const auto& cache = pCur->m_cacheList[pool.m_index];
+				stats.m_nbInUse += cache.m_nbInUse.load(std::memory_order_relaxed);
+				stats.m_nbAllocations += cache.m_nbAllocations.load(std::memory_order_relaxed);
+				stats.m_nbHits += cache.m_nbHits.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	size_t getNbPoolsWithCache() const noexcept
+	{
+		const size_t nbPools = m_nbPools.load();
+		return (nbPools < ObjectPoolBase::MAX_POOLS) ? nbPools : ObjectPoolBase::MAX_POOLS;
+	}
+
+	ObjectPoolBase* getPool(const size_t index) const noexcept
+	{
+		return m_poolList[index].load();
+	}
+
+private:
+	std::mutex m_mutex;
+	ThreadCacheList* m_pThreadList;
+	std::atomic<ObjectPoolBase*> m_pPoolList;
+	std::atomic<size_t> m_nbPools;
+	std::atomic<ObjectPoolBase*> m_poolList[ObjectPoolBase::MAX_POOLS];
+};
+
+// ---- IrStd::ObjectPoolBase -------------------------------------------------
+
+constexpr size_t IrStd::ObjectPoolBase::SLAB_SIZE;
+constexpr size_t IrStd::ObjectPoolBase::MIN_OBJECTS_PER_SLAB;
+constexpr size_t IrStd::ObjectPoolBase::ALIGNMENT;
+constexpr size_t IrStd::ObjectPoolBase::MAX_POOLS;
+
+IrStd::ObjectPoolBase::ObjectPoolBase(const char* const pTypeName, const size_t objectSize) noexcept
+		: m_objectSize(objectSize)
+		, m_nbObjectsPerSlab(std::max(MIN_OBJECTS_PER_SLAB, SLAB_SIZE / (HEADER_SIZE + alignSize(objectSize))))
+		, m_index(ObjectPoolImpl::Registry::getInstance().reserveIndex())
+		, m_pNext(nullptr)
+		, m_pShared(nullptr)
+		, m_nbSlabs(0)
+		, m_retiredNbInUse(0)
+		, m_retiredNbAllocations(0)
+		, m_retiredNbHits(0)
+{
+	int status = 0;
+	char* const pDemangled = abi::__cxa_demangle(pTypeName, nullptr, nullptr, &status);
+	std::strncpy(m_name, (pDemangled) ? pDemangled : pTypeName, sizeof(m_name) - 1);
+	m_name[sizeof(m_name) - 1] = '\0';
+	std::free(pDemangled);
+
+	ObjectPoolImpl::Registry::getInstance().addPool(this);
+}
+
+const char* IrStd::ObjectPoolBase::getName() const noexcept
+{
+	return m_name;
+}
+
+IrStd::ObjectPoolBase::Statistics IrStd::ObjectPoolBase::getStatistics() const noexcept
+{
+	Statistics stats;
+	stats.m_objectSize = m_objectSize;
+	stats.m_nbSlabs = m_nbSlabs.load();
+	stats.m_nbObjects = stats.m_nbSlabs * m_nbObjectsPerSlab;
+	ObjectPoolImpl::Registry::getInstance().getStatistics(*this, stats);
+	return stats;
+}
+
+void IrStd::ObjectPoolBase::each(const std::function<void(const ObjectPoolBase&)>& callback)
+{
+	for (auto pPool = ObjectPoolImpl::Registry::getInstance().getPoolList(); pPool; pPool = pPool->m_pNext)
+	{
+		callback(*pPool);
+	}
+}
+
+void IrStd::ObjectPoolBase::flushThreadCache() noexcept
+{
+	if (!isThreadCacheRegistered || isThreadCacheTerminated)
+	{
+		return;
+	}
+	auto& registry = ObjectPoolImpl::Registry::getInstance();
+	for (size_t index = 0; index < registry.getNbPoolsWithCache(); ++index)
+	{
+		ObjectPoolBase* const pPool = registry.getPool(index);
+		if (pPool)
+		{
+			pPool->releaseFromCache(threadCacheList.m_cacheList[index].m_nbBlocks);
+		}
+	}
+}
+
+IrStd::ObjectPoolImpl::FreeBlock* IrStd::ObjectPoolBase::carve(size_t& nbBlocks) noexcept
+{
+	const size_t stride = HEADER_SIZE + alignSize(m_objectSize);
+	// Never released, see ObjectPoolImpl::Registry::getInstance()
+	char* const pSlab = static_cast<char*>(std::malloc(stride * m_nbObjectsPerSlab));
+	if (!pSlab)
+	{
+		return nullptr;
+	}
+	m_nbSlabs.fetch_add(1);
+
+	FreeBlock* pHead = nullptr;
+	for (size_t offset = 0; offset < stride * m_nbObjectsPerSlab; offset += stride)
+	{
+		void* const ptr = pSlab + offset + HEADER_SIZE;
+		getHeader(ptr) = this;
+		FreeBlock* const pBlock = static_cast<FreeBlock*>(ptr);
+		pBlock->m_pNext = pHead;
+		pHead = pBlock;
+	}
+	nbBlocks = m_nbObjectsPerSlab;
+	return pHead;
+}
+
+void IrStd::ObjectPoolBase::give(FreeBlock* const pHead, FreeBlock* const pTail) noexcept
+{
+	pTail->m_pNext = m_pShared.load();
+	while (!m_pShared.compare_exchange_weak(pTail->m_pNext, pHead))
+	{
+	}
+}
+
+IrStd::ObjectPoolImpl::FreeBlock* IrStd::ObjectPoolBase::takeAll(size_t& nbBlocks) noexcept
+{
+	FreeBlock* const pHead = m_pShared.exchange(nullptr);
+	nbBlocks = 0;
+	for (auto pCur = pHead; pCur; pCur = pCur->m_pNext)
+	{
+		++nbBlocks;
+	}
+	return pHead;
+}
+
+void IrStd::ObjectPoolBase::releaseFromCache(size_t nbBlocks) noexcept
+{
+	auto& cache = threadCacheList.m_cacheList[m_index];
+	FreeBlock* const pHead = cache.m_pHead;
+	if (!pHead || !nbBlocks)
+	{
+		return;
+	}
+	FreeBlock* pTail = pHead;
+	size_t nbReleased = 1;
+	while (pTail->m_pNext && nbReleased < nbBlocks)
+	{
+		pTail = pTail->m_pNext;
+		++nbReleased;
+	}
+	cache.m_pHead = pTail->m_pNext;
+	cache.m_nbBlocks -= nbReleased;
+	give(pHead, pTail);
+}
+
+void* IrStd::ObjectPoolBase::allocateShared() noexcept
+{
+	size_t nbBlocks = 0;
+	bool isHit = true;
+	FreeBlock* pHead = takeAll(nbBlocks);
+	if (!pHead)
+	{
+		pHead = carve(nbBlocks);
+		isHit = false;
+		if (!pHead)
+		{
+			return nullptr;
+		}
+	}
+
+	// Keep the first one and give the others back
+	FreeBlock* const pBlock = pHead;
+	if (pBlock->m_pNext)
+	{
+		FreeBlock* pTail = pBlock->m_pNext;
+		while (pTail->m_pNext)
+		{
+			pTail = pTail->m_pNext;
+		}
+		give(pBlock->m_pNext, pTail);
+	}
+
+	m_retiredNbInUse.fetch_add(1);
+	m_retiredNbAllocations.fetch_add(1);
+	if (isHit)
+	{
+		m_retiredNbHits.fetch_add(1);
+	}
+	return pBlock;
+}
+
+void* IrStd::ObjectPoolBase::allocate(const size_t size) noexcept
+{
+	// Larger objects are taken from the heap
+	if (size > m_objectSize)
+	{
+		char* const pBlock = static_cast<char*>(::operator new(HEADER_SIZE + size, std::nothrow));
+		if (!pBlock)
+		{
+			return nullptr;
+		}
+		void* const ptr = pBlock + HEADER_SIZE;
+		getHeader(ptr) = nullptr;
+		return ptr;
+	}
+
+	// The thread is terminating or the pool has no cache, use directly the shared list
+	if (m_index >= MAX_POOLS || isThreadCacheTerminated)
+	{
+		return allocateShared();
+	}
+
+	if (!isThreadCacheRegistered)
+	{
+		ObjectPoolImpl::Registry::getInstance().registerThread();
+	}
+
+	// Refill the thread cache if needed
+	auto& cache = threadCacheList.m_cacheList[m_index];
+	if (!cache.m_pHead)
+	{
+		size_t nbBlocks = 0;
+		cache.m_pHead = takeAll(nbBlocks);
+		if (!cache.m_pHead)
+		{
+			cache.m_pHead = carve(nbBlocks);
+			if (!cache.m_pHead)
+			{
+				return nullptr;
+			}
+		}
+		else
+		{
+			increment(cache.m_nbHits);
+		}
+		cache.m_nbBlocks += nbBlocks;
+	}
+	else
+	{
+		increment(cache.m_nbHits);
+	}
+
+	FreeBlock* const pBlock = cache.m_pHead;
+	cache.m_pHead = pBlock->m_pNext;
+	--cache.m_nbBlocks;
+	increment(cache.m_nbAllocations);
+	add(cache.m_nbInUse, 1);
+
+	return pBlock;
+}
+
+void IrStd::ObjectPoolBase::deallocate(void* ptr) noexcept
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	ObjectPoolBase* const pPool = getHeader(ptr);
+	if (!pPool)
+	{
+		::operator delete(static_cast<char*>(ptr) - HEADER_SIZE);
+		return;
+	}
+	pPool->deallocateBlock(static_cast<FreeBlock*>(ptr));
+}
+
+void IrStd::ObjectPoolBase::deallocateBlock(FreeBlock* const pBlock) noexcept
+{
+	// The thread is terminating or the pool has no cache, use directly the shared list
+	if (m_index >= MAX_POOLS || isThreadCacheTerminated)
+	{
+		give(pBlock, pBlock);
+		m_retiredNbInUse.fetch_sub(1);
+		return;
+	}
+
+	if (!isThreadCacheRegistered)
+	{
+		ObjectPoolImpl::Registry::getInstance().registerThread();
+	}
+
+	// Release half of the cache if it grows too large, the block released is kept as it is hot
+	auto& cache = threadCacheList.m_cacheList[m_index];
+	if (cache.m_nbBlocks >= CACHE_MAX_BLOCKS)
+	{
+		releaseFromCache(CACHE_MAX_BLOCKS / 2);
+	}
+
+	pBlock->m_pNext = cache.m_pHead;
+	cache.m_pHead = pBlock;
+	++cache.m_nbBlocks;
+	add(cache.m_nbInUse, -1);
+}
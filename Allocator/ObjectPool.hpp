@@ -0,0 +1,228 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace IrStd
+{
+	namespace ObjectPoolImpl
+	{
+		struct FreeBlock
+		{
+			FreeBlock* m_pNext;
+		};
+
+		class Registry;
+	}
+
+	/**
+	 * \brief Recycle the memory of objects of a fixed size
+	 *
+	 * Released objects are kept in a thread-local cache and re-used by the
+	 * next allocations of the same thread. When a cache grows too large, half
+	 * of it is moved to a shared lock-free free list, from which the other
+	 * threads refill their cache. New slabs of about \ref SLAB_SIZE bytes
+	 * are reserved only if both are empty.
+	 *
+	 * Allocations larger than the object size (from a derived class for
+	 * example) go directly to the heap.
+	 *
+	 * \note Slabs are never returned to the system.
+	 */
+	class ObjectPoolBase
+	{
+	public:
+		struct Statistics
+		{
+			/**
+			 * Size of the objects managed by the pool
+			 */
+			size_t m_objectSize;
+			/**
+			 * Number of slabs reserved, and the number of objects they contain
+			 */
+			uint64_t m_nbSlabs;
+			uint64_t m_nbObjects;
+			/**
+			 * Number of objects currently in use
+			 */
+			int64_t m_nbInUse;
+			/**
+			 * Number of allocations, and those served without reserving a new slab
+			 */
+			uint64_t m_nbAllocations;
+			uint64_t m_nbHits;
+		};
+
+		static constexpr size_t SLAB_SIZE = 4 * 1024;
+		static constexpr size_t MIN_OBJECTS_PER_SLAB = 8;
+		static constexpr size_t ALIGNMENT = 16;
+
+		/**
+		 * Maximum number of pools having a thread cache, the others use the shared list only
+		 */
+		static constexpr size_t MAX_POOLS = 64;
+
+		ObjectPoolBase(const ObjectPoolBase&) = delete;
+		ObjectPoolBase& operator=(const ObjectPoolBase&) = delete;
+
+		void* allocate(const size_t size) noexcept;
+		static void deallocate(void* ptr) noexcept;
+
+		/**
+		 * \brief Demangled name of the type of the objects
+		 */
+		const char* getName() const noexcept;
+
+		Statistics getStatistics() const noexcept;
+
+		/**
+		 * \brief Iterate through all the pools created so far
+		 */
+		static void each(const std::function<void(const ObjectPoolBase&)>& callback);
+
+		/**
+		 * \brief Return the objects cached by the current thread to the shared lists
+		 */
+		static void flushThreadCache() noexcept;
+
+	protected:
+		ObjectPoolBase(const char* const pTypeName, const size_t objectSize) noexcept;
+
+	private:
+		friend ObjectPoolImpl::Registry;
+		typedef ObjectPoolImpl::FreeBlock FreeBlock;
+
+		/**
+		 * Cut a new slab into blocks
+		 *
+		 * \return The list of blocks, nullptr if the memory is exhausted.
+		 */
+		FreeBlock* carve(size_t& nbBlocks) noexcept;
+
+		/**
+		 * Give a list of blocks back to the shared list
+		 */
+		void give(FreeBlock* const pHead, FreeBlock* const pTail) noexcept;
+
+		/**
+		 * Take all the blocks of the shared list, taking them all at once avoids the ABA problem
+		 */
+		FreeBlock* takeAll(size_t& nbBlocks) noexcept;
+
+		/**
+		 * Used by the threads without cache for this pool
+		 */
+		void* allocateShared() noexcept;
+
+		void deallocateBlock(FreeBlock* const pBlock) noexcept;
+
+		/**
+		 * Release the first nbBlocks of the cache of the current thread to the shared list
+		 */
+		void releaseFromCache(size_t nbBlocks) noexcept;
+
+
+		char m_name[128];
+		const size_t m_objectSize;
+		const size_t m_nbObjectsPerSlab;
+		const size_t m_index;
+		ObjectPoolBase* m_pNext;
+
+		// Shared free list, blocks are pushed one chain at a time and popped all at once
+		std::atomic<FreeBlock*> m_pShared;
+		std::atomic<uint64_t> m_nbSlabs;
+
+		// Counters of the terminated threads, and of the pools without thread cache
+		std::atomic<int64_t> m_retiredNbInUse;
+		std::atomic<uint64_t> m_retiredNbAllocations;
+		std::atomic<uint64_t> m_retiredNbHits;
+	};
+
+	/**
+	 * \brief Pool of objects of type T
+	 *
+	 * Objects can be created through the pool, or a class can recycle all its
+	 * instances by deriving from AllocatorImpl<AllocatorObjectPool<T>>.
+	 */
+	template<class T>
+	class ObjectPool : public ObjectPoolBase
+	{
+	public:
+		/**
+		 * Never destroyed, see ObjectPoolImpl::Registry::getInstance()
+		 */
+		static ObjectPool& getInstance() noexcept
+		{
+			alignas(ObjectPool) static char buffer[sizeof(ObjectPool)];
+			static ObjectPool* const pPool = new (buffer) ObjectPool();
+			return *pPool;
+		}
+
+		template<class ... Args>
+		T* create(Args&& ... args)
+		{
+			void* const ptr = allocate(sizeof(T));
+			if (!ptr)
+			{
+				throw std::bad_alloc();
+			}
+			try
+			{
+				return ::new (ptr) T(std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				deallocate(ptr);
+				throw;
+			}
+		}
+
+		void destroy(T* const pObject) noexcept
+		{
+			if (pObject)
+			{
+				pObject->~T();
+				deallocate(pObject);
+			}
+		}
+
+	private:
+		ObjectPool() noexcept
+				: ObjectPoolBase(typeid(T).name(), sizeof(T))
+		{
+		}
+	};
+
+	/**
+	 * \brief Allocator using the pool of objects of type T
+	 */
+	template<class T>
+	class AllocatorObjectPool : public Allocator
+	{
+	public:
+		void* allocate(size_t size) noexcept
+		{
+			return ObjectPool<T>::getInstance().allocate(size);
+		}
+
+		void deallocate(void* ptr)
+		{
+			ObjectPoolBase::deallocate(ptr);
+		}
+	};
+}
+
+#define IRSTD_OBJECTPOOL_STATISTICS_STREAM(stats) \
+		std::dec << "size=" << (stats).m_objectSize \
+		<< ", slabs=" << (stats).m_nbSlabs \
+		<< ", objects=" << (stats).m_nbObjects \
+		<< ", in.use=" << (stats).m_nbInUse \
+		<< ", nb.alloc=" << (stats).m_nbAllocations \
+		<< ", hit.rate=" << (((stats).m_nbAllocations) ? (100 * (stats).m_nbHits / (stats).m_nbAllocations) : 100) << "%"
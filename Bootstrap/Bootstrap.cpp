@@ -26,6 +26,7 @@
 #include "../Memory.hpp"
 
 #define SIGNAL_THREAD SIGUSR2
+#define SIGNAL_HEAP_PROFILE SIGUSR1
 
 IRSTD_TOPIC_REGISTER(IrStd, Bootstrap);
 IRSTD_TOPIC_USE_ALIAS(IrStdBootstrap, IrStd, Bootstrap);
@@ -174,7 +175,8 @@ void IrStd::Bootstrap::sigHandlerThread(int sig, siginfo_t* info, void* secret)
 {
 	if (sig == SIGNAL_THREAD)
 	{
-		auto pThread = IrStd::Threads::getInstance().getNoLock(std::this_thread::get_id());
+		// The registry might be locked by the interrupted code
+		auto pThread = IrStd::Thread::getCurrent();
 		IRSTD_ASSERT(pThread, "Only threads from IrStd::Thread should go through this path");
 
 		std::cerr << std::endl << "Callstack (" << *pThread << "):" << std::endl;
@@ -189,6 +191,13 @@ void IrStd::Bootstrap::sigHandlerThread(int sig, siginfo_t* info, void* secret)
 
 void IrStd::Bootstrap::sigHandler(int sig, siginfo_t* info, void* /*secret*/)
 {
+	// Write the heap profile if the profiler is running, this does not terminate the process
+	if (sig == SIGNAL_HEAP_PROFILE && IrStd::Memory::getInstance().isProfiling())
+	{
+		IrStd::Memory::getInstance().requestProfileDump();
+		return;
+	}
+
 	static std::mutex mutex;
 	// Ignore the sign handler if it is called concurrently. This can happen if
 	// it is called within the exception handler.
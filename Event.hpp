@@ -1,9 +1,13 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
+#include <functional>
+#include <utility>
+#include <vector>
 
 #include "Logger.hpp"
 #include "Topic.hpp"
@@ -12,6 +16,11 @@ IRSTD_TOPIC_USE(IrStd, Event);
 
 namespace IrStd
 {
+	namespace EventImpl
+	{
+		class WaitSet;
+	}
+
 	/**
 	 * \defgroup IrStd-Event
 	 * \brief Event mutex
@@ -21,6 +30,7 @@ namespace IrStd
 	class Event
 	{
 	public:
+		static constexpr size_t DEFAULT_MAX_SPINS = 4000;
 
 		/**
 		 * \brief Create an event of a specified name
@@ -28,6 +38,44 @@ namespace IrStd
 		 * \param pName (optional) The name of the event
 		 */
 		Event(const char* const pName = nullptr);
+		~Event();
+
+		/**
+		 * \brief Spin before waiting for a trigger
+		 * \ingroup IrStd-Event
+		 *
+		 * Waiting threads first poll the counter, and only sleep if the event
+		 * is not triggered within the spins. The number of spins adapts to how
+		 * long the previous waits took, up to the maximum. This is meant for
+		 * hand-offs of a few microseconds between threads running on their
+		 * own core.
+		 *
+		 * Spinning is off by default. When the threads share a core, it delays
+		 * the thread about to trigger and makes the round-trips slower (see
+		 * testAdaptive), so it is ignored on a single-core machine.
+		 *
+		 * \param maxSpins The maximum number of spins, 0 to always sleep right away.
+		 */
+		void setAdaptive(const size_t maxSpins = DEFAULT_MAX_SPINS) noexcept;
+
+		/**
+		 * \brief File descriptor readable once the event is triggered
+		 * \ingroup IrStd-Event
+		 *
+		 * This lets I/O loops wait for sockets and events with a single call to
+		 * poll or epoll. The descriptor is created at the first call, only the
+		 * triggers from then on make it readable; it stays readable until
+		 * \ref clearFd is called. It is owned by the event.
+		 *
+		 * \note This uses an eventfd on Linux, a pipe elsewhere.
+		 */
+		int getFd();
+
+		/**
+		 * \brief Consume the triggers signaled on the file descriptor
+		 * \ingroup IrStd-Event
+		 */
+		void clearFd() noexcept;
 
 		/**
 		 * \brief Get the current count of the event
@@ -71,95 +119,149 @@ namespace IrStd
 		size_t waitForAtLeast(const size_t nbEvents, const uint64_t timeoutMs) noexcept;
 		size_t waitForAtLeast(const size_t nbEvents) noexcept;
 
+		/**
+		 * \brief Call a function once, at the next trigger
+		 * \ingroup IrStd-Event
+		 *
+		 * The function is called by the thread triggering the event, with the
+		 * counter after the trigger. It must be short and must not throw.
+		 */
+		void onNext(const std::function<void(size_t)>& fct);
+
 		/**
 		 * \brief Wait until all the events passed into argument are triggered
 		 * \ingroup IrStd-Event
 		 *
+		 * The calling thread is registered on all the events at once, and woken up
+		 * only when the last one is triggered.
+		 *
 		 * \param timeoutMs The maximum timeout in ms
 		 * \param events The events
 		 *
 		 * \return nullptr if all the events are triggered on time. Otherwise a pointer
 		 *         on the event that triggered the timeout, hence a non-null value means
-		 *         it has reached the timeout.
+		 *         it has reached the timeout. An event reset meanwhile ends the wait,
+		 *         it is reported the same way.
 		 */
 		template<class ...Events>
-		static Event* waitForNexts(const uint64_t timeoutMs, Events&... events)
+		static Event* waitForNexts(const uint64_t timeoutMs, Event& event, Events&... events)
 		{
-			const std::array<Event* const, sizeof...(Events)> eventList{{&events...}};
-			std::array<size_t, sizeof...(Events)> initialCounterList;
-			return waitForNextsInternal(timeoutMs, eventList, initialCounterList.data());
+			const std::array<Event* const, sizeof...(Events) + 1> eventList{{&event, &events...}};
+			return waitForNexts(timeoutMs, eventList);
 		}
 
 		template<class T>
 		static Event* waitForNexts(const uint64_t timeoutMs, const T& eventList)
 		{
-			std::vector<size_t> initialCounterList(eventList.size());
-			return waitForNextsInternal(timeoutMs, eventList, initialCounterList.data());
+			const std::vector<Event*> pointerList(eventList.begin(), eventList.end());
+			const auto firedList = waitForInternal(pointerList, pointerList.size(), timeoutMs, /*hasTimeout*/true);
+			for (size_t i=0; i<pointerList.size(); ++i)
+			{
+				if (!firedList[i])
+				{
+					IRSTD_LOG_TRACE(IRSTD_TOPIC(IrStd, Event), "Timeout (" << timeoutMs
+							<< "ms) for event '" << pointerList[i]->getName() << "'");
+					return pointerList[i];
+				}
+			}
+			return nullptr;
 		}
 
 		/**
-		 * \brief Return the name associated with this event.
+		 * \brief Wait until at least one of the events passed into argument is triggered
 		 * \ingroup IrStd-Event
 		 *
-		 * \return The name of the event.
+		 * The calling thread is registered on all the events at once, and woken up
+		 * by the first one triggered.
+		 *
+		 * \param timeoutMs (Optional) Timeout in ms, 0 to wait without timeout
+		 * \param events The events
+		 *
+		 * \return The index of the events triggered, in the order they are passed.
+		 *         Empty if the timeout has been reached, if one of the events was
+		 *         reset meanwhile, or if the list is empty.
 		 */
-		const char* getName() const noexcept;
-
-	private:
+		template<class ...Events>
+		static std::vector<size_t> waitForAny(const uint64_t timeoutMs, Event& event, Events&... events)
+		{
+			const std::array<Event* const, sizeof...(Events) + 1> eventList{{&event, &events...}};
+			return waitForAny(timeoutMs, eventList);
+		}
 
 		template<class T>
-		static Event* waitForNextsInternal(const uint64_t timeoutMs, const T& eventList, size_t* pInitialCounterList)
+		static std::vector<size_t> waitForAny(const uint64_t timeoutMs, const T& eventList)
 		{
-			// This operation is not atomic, but it does not matter as during the call itself
-			// a counter change can happen.
-			for (size_t i=0; i<eventList.size(); ++i)
+			const std::vector<Event*> pointerList(eventList.begin(), eventList.end());
+			// Nothing would ever wake up the thread
+			if (pointerList.empty())
 			{
-				pInitialCounterList[i] = eventList[i]->getCounter();
+				return std::vector<size_t>();
 			}
-
-			// Monitor and make sure the next event will happen
-			auto timeoutLeft = std::chrono::milliseconds(timeoutMs);
-			for (size_t i=0; i<eventList.size(); ++i)
+			const auto firedList = waitForInternal(pointerList, 1, timeoutMs, /*hasTimeout*/timeoutMs != 0);
+			std::vector<size_t> indexList;
+			for (size_t i=0; i<firedList.size(); ++i)
 			{
-				Event* const pEvent = eventList[i];
-
-				if (pInitialCounterList[i] == pEvent->getCounter())
+				if (firedList[i])
 				{
-					const auto timeStart = std::chrono::system_clock::now().time_since_epoch();
-					const auto isTimeout = !pEvent->waitForNextInternal(pInitialCounterList[i], timeoutLeft);
-					const auto timeSpent = std::chrono::system_clock::now().time_since_epoch() - timeStart;
-
-					// Update the remaining timeout
-					if (isTimeout || pEvent->m_counter <= pInitialCounterList[i] || timeoutLeft <= timeSpent)
-					{
-						IRSTD_LOG_TRACE(IRSTD_TOPIC(IrStd, Event), "Timeout (" << timeoutMs
-								<< "ms) for event '" << *pEvent << "'");
-						return pEvent;
-					}
-					timeoutLeft = std::chrono::duration_cast<std::chrono::milliseconds>(timeoutLeft - timeSpent);
+					indexList.push_back(i);
 				}
 			}
-
-			return nullptr;
+			return indexList;
 		}
 
+		/**
+		 * \brief Return the name associated with this event.
+		 * \ingroup IrStd-Event
+		 *
+		 * \return The name of the event.
+		 */
+		const char* getName() const noexcept;
+
+	private:
+
+		/**
+		 * Wait until a number of events are triggered
+		 *
+		 * \return Which events were triggered.
+		 */
+		static std::vector<bool> waitForInternal(const std::vector<Event*>& eventList, const size_t nbNeeded,
+				const uint64_t timeoutMs, const bool hasTimeout);
+
+		/**
+		 * Register a wait set, notified at the next trigger. It is notified right away
+		 * if the counter does not match.
+		 */
+		void attach(EventImpl::WaitSet& waitSet, const size_t index, const size_t curCounter) noexcept;
+		void detach(const EventImpl::WaitSet& waitSet) noexcept;
+
 		template<class Rep, class Period>
 		size_t waitForNextInternal(const size_t curCounter,
 				const std::chrono::duration<Rep, Period>& timeout) const noexcept
 		{
+			if (spin(curCounter))
+			{
+				return (m_counter <= curCounter) ? 0 : m_counter.load();
+			}
 			{
 				std::unique_lock<std::mutex> lock(m_lock);
 				if (m_counter == curCounter)
 				{
-					auto status = m_cv.wait_for(lock, timeout);
-					if (status == std::cv_status::timeout)
+					// A trigger notifies after incrementing the counter, the
+					// notification might be for a count already seen
+					const size_t nbResets = m_nbResets;
+					m_nbWaiters.fetch_add(1, std::memory_order_seq_cst);
+					const bool isTriggered = m_cv.wait_for(lock, timeout, [&]() {
+						return (m_counter != curCounter || m_nbResets != nbResets);
+					});
+					m_nbWaiters.fetch_sub(1, std::memory_order_relaxed);
+					if (!isTriggered)
 					{
 						return 0;
 					}
 					if (m_counter <= curCounter)
 					{
 						IRSTD_LOG_TRACE(IRSTD_TOPIC(IrStd, Event), "Event (" << getName()
-								<< ") was reset, returning from wait state. counter=" << m_counter);
+								<< ") was reset, returning from wait state. counter=" << m_counter.load());
 						return 0;
 					}
 					return m_counter;
@@ -168,12 +270,31 @@ namespace IrStd
 			return m_counter;
 		}
 
+		/**
+		 * Poll the counter in adaptive mode, true if it changed
+		 */
+		bool spin(const size_t curCounter) const noexcept;
+
 		size_t waitForNextInternal(const size_t curCounter) const noexcept;
 
 		mutable std::mutex m_lock;
 		mutable std::condition_variable m_cv;
-		size_t m_counter;
+		std::atomic<size_t> m_counter;
 		const char* const m_pName;
+		std::vector<std::function<void(size_t)>> m_callbackList;
+		// Wait sets registered, with the index of this event in each
+		std::vector<std::pair<EventImpl::WaitSet*, size_t>> m_waitSetList;
+		// Incremented by reset, under the lock
+		size_t m_nbResets;
+		// Threads sleeping, callbacks and wait sets registered, a trigger without any
+		// skips the lock, and the file descriptor unless it is created
+		mutable std::atomic<size_t> m_nbWaiters;
+		std::atomic<size_t> m_maxSpins;
+		// Readable end of the file descriptor, and the end written by the triggers
+		std::atomic<int> m_readFd;
+		int m_writeFd;
+		// Spins of the recent waits, used as the next spin limit
+		mutable std::atomic<size_t> m_nbSpins;
 	};
 }
 
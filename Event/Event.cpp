@@ -1,17 +1,175 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+
 #include "../Event.hpp"
 #include "../Thread.hpp"
+#include "../Compiler.hpp"
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	#include <sys/eventfd.h>
+#endif
 
 IRSTD_TOPIC_REGISTER(IrStd, Event);
 IRSTD_TOPIC_USE_ALIAS(IrStdEvent, IrStd, Event);
 
+namespace
+{
+	// Spins between two reads of the counter
+	inline void cpuRelax() noexcept
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#endif
+	}
+}
+
+// ---- IrStd::EventImpl::WaitSet ---------------------------------------------
+
+/**
+ * Waiter shared by several events, each trigger marks its event as fired
+ */
+class IrStd::EventImpl::WaitSet
+{
+public:
+	WaitSet(const size_t nbEvents, const size_t nbNeeded)
+			: m_firedList(nbEvents, false)
+			, m_nbFired(0)
+			, m_nbNeeded(nbNeeded)
+			, m_isReset(false)
+	{
+	}
+
+	void notify(const size_t index) noexcept
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (m_isReset || m_firedList[index])
+		{
+			return;
+		}
+		m_firedList[index] = true;
+		// Wake up the waiter once only
+		if (++m_nbFired == m_nbNeeded)
+		{
+			m_cv.notify_one();
+		}
+	}
+
+	/**
+	 * An event was reset, the wait ends without it being fired
+	 */
+	void notifyReset() noexcept
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_isReset = true;
+		m_cv.notify_one();
+	}
+
+	std::vector<bool> wait(const uint64_t timeoutMs, const bool hasTimeout)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		const auto isDone = [this]() {
+			return (m_isReset || m_nbFired >= m_nbNeeded);
+		};
+		if (hasTimeout)
+		{
+			m_cv.wait_for(lock, std::chrono::milliseconds(timeoutMs), isDone);
+		}
+		else
+		{
+			m_cv.wait(lock, isDone);
+		}
+		return m_firedList;
+	}
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::vector<bool> m_firedList;
+	size_t m_nbFired;
+	const size_t m_nbNeeded;
+	bool m_isReset;
+};
+
 // ---- IrStd::Event ----------------------------------------------------------
 
+constexpr size_t IrStd::Event::DEFAULT_MAX_SPINS;
+
 IrStd::Event::Event(const char* const pName)
 		: m_counter(0)
 		, m_pName(pName)
+		, m_nbResets(0)
+		, m_nbWaiters(0)
+		, m_maxSpins(0)
+		, m_readFd(-1)
+		, m_writeFd(-1)
+		, m_nbSpins(0)
 {
 }
 
+IrStd::Event::~Event()
+{
+	if (m_readFd != -1)
+	{
+		::close(m_readFd);
+	}
+	if (m_writeFd != -1 && m_writeFd != m_readFd)
+	{
+		::close(m_writeFd);
+	}
+}
+
+int IrStd::Event::getFd()
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	if (m_readFd == -1)
+	{
+#if IRSTD_IS_PLATFORM(LINUX)
+		const int fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		IRSTD_THROW_ASSERT(IrStdEvent, fd != -1, "eventfd: code=" << errno << ", str=" << ::strerror(errno));
+		m_writeFd = fd;
+		m_readFd = fd;
+#else
+		int fds[2];
+		IRSTD_THROW_ASSERT(IrStdEvent, ::pipe(fds) == 0, "pipe: code=" << errno << ", str=" << ::strerror(errno));
+		for (const int fd : fds)
+		{
+			::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+			::fcntl(fd, F_SETFD, FD_CLOEXEC);
+		}
+		m_writeFd = fds[1];
+		m_readFd = fds[0];
+#endif
+		// Counted as a waiter, so that the triggers signal it
+		m_nbWaiters.fetch_add(1, std::memory_order_seq_cst);
+	}
+	return m_readFd;
+}
+
+void IrStd::Event::clearFd() noexcept
+{
+	const int fd = m_readFd;
+	if (fd == -1)
+	{
+		return;
+	}
+	// Reading an eventfd resets it, a pipe is read until empty
+	uint64_t buffer[8];
+	while (::read(fd, buffer, sizeof(buffer)) > 0)
+	{
+	}
+}
+
+void IrStd::Event::setAdaptive(const size_t maxSpins) noexcept
+{
+	const size_t nbSpins = (std::thread::hardware_concurrency() > 1) ? maxSpins : 0;
+	m_maxSpins.store(nbSpins, std::memory_order_relaxed);
+	m_nbSpins.store(nbSpins / 2, std::memory_order_relaxed);
+}
+
 size_t IrStd::Event::getCounter() const noexcept
 {
 	return m_counter;
@@ -19,15 +177,60 @@ size_t IrStd::Event::getCounter() const noexcept
 
 void IrStd::Event::reset() noexcept
 {
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		++m_nbResets;
+		// Reported as not triggered, the trigger below does not count for them
+		for (const auto& item : m_waitSetList)
+		{
+			item.first->notifyReset();
+		}
+	}
 	trigger();
 	m_counter = 0;
 }
 
 void IrStd::Event::trigger() noexcept
+{
+	const size_t counter = m_counter.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+	// Nobody to wake up, waiters register before checking the counter
+	if (!m_nbWaiters.load(std::memory_order_seq_cst))
+	{
+		return;
+	}
+
+	std::vector<std::function<void(size_t)>> callbackList;
+	int writeFd;
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		writeFd = m_writeFd;
+		m_cv.notify_all();
+		for (const auto& item : m_waitSetList)
+		{
+			item.first->notify(item.second);
+		}
+		callbackList.swap(m_callbackList);
+		m_nbWaiters.fetch_sub(callbackList.size(), std::memory_order_relaxed);
+	}
+	if (writeFd != -1)
+	{
+		// If it fails, the descriptor is already readable
+		const uint64_t value = 1;
+		const auto ret = ::write(writeFd, &value, sizeof(value));
+		(void) ret;
+	}
+	for (const auto& fct : callbackList)
+	{
+		fct(counter);
+	}
+}
+
+void IrStd::Event::onNext(const std::function<void(size_t)>& fct)
 {
 	std::unique_lock<std::mutex> lock(m_lock);
-	m_counter++;
-	m_cv.notify_all();
+	m_callbackList.push_back(fct);
+	m_nbWaiters.fetch_add(1, std::memory_order_seq_cst);
 }
 
 size_t IrStd::Event::waitForNext(const uint64_t timeoutMs) const noexcept
@@ -48,7 +251,7 @@ size_t IrStd::Event::waitForAtLeast(const size_t nbMinEvents, const uint64_t tim
 	}
 
 	auto timeoutLeft = std::chrono::milliseconds(timeoutMs);
-	auto curCounter = m_counter;
+	size_t curCounter = m_counter;
 	while (curCounter < nbMinEvents)
 	{
 		const auto timeStart = std::chrono::system_clock::now().time_since_epoch();
@@ -67,7 +270,7 @@ size_t IrStd::Event::waitForAtLeast(const size_t nbMinEvents, const uint64_t tim
 
 size_t IrStd::Event::waitForAtLeast(const size_t nbMinEvents) noexcept
 {
-	auto curCounter = m_counter;
+	size_t curCounter = m_counter;
 	while (curCounter < nbMinEvents)
 	{
 		curCounter = waitForNextInternal(curCounter);
@@ -79,17 +282,106 @@ size_t IrStd::Event::waitForAtLeast(const size_t nbMinEvents) noexcept
 	return m_counter;
 }
 
+void IrStd::Event::attach(EventImpl::WaitSet& waitSet, const size_t index, const size_t curCounter) noexcept
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_waitSetList.push_back(std::make_pair(&waitSet, index));
+	m_nbWaiters.fetch_add(1, std::memory_order_seq_cst);
+	// Triggered since the counter was read
+	if (m_counter != curCounter)
+	{
+		waitSet.notify(index);
+	}
+}
+
+void IrStd::Event::detach(const EventImpl::WaitSet& waitSet) noexcept
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	for (auto it = m_waitSetList.begin(); it != m_waitSetList.end(); ++it)
+	{
+		if (it->first == &waitSet)
+		{
+			m_waitSetList.erase(it);
+			m_nbWaiters.fetch_sub(1, std::memory_order_relaxed);
+			return;
+		}
+	}
+}
+
+std::vector<bool> IrStd::Event::waitForInternal(const std::vector<Event*>& eventList, const size_t nbNeeded,
+		const uint64_t timeoutMs, const bool hasTimeout)
+{
+	// The events triggered from now on count
+	std::vector<size_t> initialCounterList;
+	initialCounterList.reserve(eventList.size());
+	for (const auto pEvent : eventList)
+	{
+		initialCounterList.push_back(pEvent->getCounter());
+	}
+
+	EventImpl::WaitSet waitSet(eventList.size(), nbNeeded);
+	for (size_t i=0; i<eventList.size(); ++i)
+	{
+		eventList[i]->attach(waitSet, i, initialCounterList[i]);
+	}
+	const auto firedList = waitSet.wait(timeoutMs, hasTimeout);
+	for (const auto pEvent : eventList)
+	{
+		pEvent->detach(waitSet);
+	}
+	return firedList;
+}
+
+bool IrStd::Event::spin(const size_t curCounter) const noexcept
+{
+	const size_t maxSpins = m_maxSpins.load(std::memory_order_relaxed);
+	if (!maxSpins)
+	{
+		return false;
+	}
+
+	// Spin a bit longer than the recent waits needed
+	const size_t nbSpinsMax = std::min(maxSpins, m_nbSpins.load(std::memory_order_relaxed) * 2 + 10);
+	size_t nbSpins = 0;
+	bool isChanged = false;
+	for (; nbSpins < nbSpinsMax; ++nbSpins)
+	{
+		if (m_counter.load(std::memory_order_acquire) != curCounter)
+		{
+			isChanged = true;
+			break;
+		}
+		cpuRelax();
+	}
+
+	// Moving average of the spins that paid off, spinning in vain lowers it
+	const size_t sample = (isChanged) ? nbSpins : 0;
+	const size_t average = m_nbSpins.load(std::memory_order_relaxed);
+	m_nbSpins.store(average + sample / 8 - average / 8, std::memory_order_relaxed);
+
+	return isChanged;
+}
+
 size_t IrStd::Event::waitForNextInternal(const size_t curCounter) const noexcept
 {
+	if (spin(curCounter))
+	{
+		return (m_counter <= curCounter) ? 0 : m_counter.load();
+	}
 	{
 		std::unique_lock<std::mutex> lock(m_lock);
 		if (curCounter == m_counter)
 		{
-			m_cv.wait(lock);
+			const size_t nbResets = m_nbResets;
+			m_nbWaiters.fetch_add(1, std::memory_order_seq_cst);
+			m_cv.wait(lock, [&]() {
+				return (m_counter != curCounter || m_nbResets != nbResets);
+			});
+			m_nbWaiters.fetch_sub(1, std::memory_order_relaxed);
 			if (m_counter <= curCounter)
 			{
 				IRSTD_LOG_TRACE(IrStdEvent, "Event (" << getName()
-						<< ") was reset, returning from wait state. counter=" << m_counter);
+						<< ") was reset, returning from wait state. counter=" << m_counter.load());
 				return 0;
 			}
 		}
@@ -116,6 +116,24 @@ namespace IrStd
 
 		static void callStack(std::ostream& out, const size_t skipFirstNb = 1) noexcept;
 
+		/**
+		 * \brief Capture the return addresses of the current call stack
+		 *
+		 * This does not resolve any symbol and is therefore cheap enough to be
+		 * used on hot paths.
+		 *
+		 * \return The number of addresses captured.
+		 */
+		static size_t callStack(void** pAddressList, const size_t maxNb, const size_t skipFirstNb = 1) noexcept;
+
+		/**
+		 * \brief Print the name of the function containing an address
+		 *
+		 * Unlike \ref callStack, the source file is not resolved. If the symbol
+		 * cannot be found, the address is printed instead.
+		 */
+		static void functionName(std::ostream& out, void* const pAddress) noexcept;
+
 		/**
 		 * \brief Print the exception or the chainned exception
 		 */
@@ -132,6 +150,12 @@ namespace IrStd
 		static void rethrowRetry();
 
 	private:
+		/**
+		 * Split a symbol returned by backtrace_symbols into its components,
+		 * the symbol string is modified in place.
+		 */
+		static void parseSymbol(char* pSymbol, const char*& pSourcePath, const char*& pFunction,
+				const char*& pOffset) noexcept;
 		static bool demangle(char* pBuffer, const size_t size, const char* const pSymbol) noexcept;
 		static bool addressToFileInfo(char* pBuffer, const size_t size, const void* address, const char* executablePath = nullptr) noexcept;
 
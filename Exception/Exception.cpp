@@ -230,55 +230,101 @@ bool IrStd::Exception::addressToFileInfo(char* pBuffer, const size_t size, const
 	return false;
 }
 
-void IrStd::Exception::callStack(std::ostream& out, const size_t skipFirstNb) noexcept
+void IrStd::Exception::parseSymbol(char* pSymbol, const char*& pSourcePath, const char*& pFunction,
+		const char*& pOffset) noexcept
 {
-	constexpr size_t MAX_STACK_LEVEL = 64;
-	void* addresses[MAX_STACK_LEVEL];
+	pSourcePath = nullptr;
+	pFunction = nullptr;
+	pOffset = nullptr;
 
-	const int nbLevels = ::backtrace(addresses, MAX_STACK_LEVEL);
-	const std::unique_ptr<char*, decltype(&std::free)> symbols(::backtrace_symbols(addresses, nbLevels), &std::free);
-
-	for(int level = static_cast<int>(skipFirstNb); level < nbLevels; ++level)
+	// Look for the source path
 	{
-		char* pSymbol = symbols.get()[level];
-		const char* pSourcePath = nullptr;
-		const char* pFunction = nullptr;
-		const char* pOffset = nullptr;
-
-		// Look for the source path
+		const auto pEnd = std::strchr(pSymbol, '(');
+		if (pEnd)
 		{
-			const auto pEnd = std::strchr(pSymbol, '(');
-			if (pEnd)
-			{
-				*pEnd = '\0';
-				pSourcePath = pSymbol;
-				pSymbol = pEnd + 1;
-			}
+			*pEnd = '\0';
+			pSourcePath = pSymbol;
+			pSymbol = pEnd + 1;
 		}
+	}
 
-		// Look for the function
-		if (pSourcePath)
+	// Look for the function
+	if (pSourcePath)
+	{
+		const auto pEnd = std::strchr(pSymbol, '+');
+		if (pEnd)
 		{
-			const auto pEnd = std::strchr(pSymbol, '+');
-			if (pEnd)
-			{
-				*pEnd = '\0';
-				pFunction = pSymbol;
-				pSymbol = pEnd + 1;
-			}
+			*pEnd = '\0';
+			pFunction = pSymbol;
+			pSymbol = pEnd + 1;
 		}
+	}
 
-		// Look for the offset
-		if (pFunction)
+	// Look for the offset
+	if (pFunction)
+	{
+		const auto pEnd = std::strchr(pSymbol, ')');
+		if (pEnd)
 		{
-			const auto pEnd = std::strchr(pSymbol, ')');
-			if (pEnd)
-			{
-				*pEnd = '\0';
-				pOffset = pSymbol;
-				pSymbol = pEnd + 1;
-			}
+			*pEnd = '\0';
+			pOffset = pSymbol;
 		}
+	}
+}
+
+size_t IrStd::Exception::callStack(void** pAddressList, const size_t maxNb, const size_t skipFirstNb) noexcept
+{
+	constexpr size_t MAX_STACK_LEVEL = 64;
+	void* addresses[MAX_STACK_LEVEL];
+
+	const int nbLevels = ::backtrace(addresses, MAX_STACK_LEVEL);
+	size_t nb = 0;
+	for (int level = static_cast<int>(skipFirstNb); level < nbLevels && nb < maxNb; ++level)
+	{
+		pAddressList[nb++] = addresses[level];
+	}
+	return nb;
+}
+
+void IrStd::Exception::functionName(std::ostream& out, void* const pAddress) noexcept
+{
+	void* addresses[1] = {pAddress};
+	const std::unique_ptr<char*, decltype(&std::free)> symbols(::backtrace_symbols(addresses, 1), &std::free);
+
+	const char* pSourcePath = nullptr;
+	const char* pFunction = nullptr;
+	const char* pOffset = nullptr;
+	if (symbols)
+	{
+		parseSymbol(symbols.get()[0], pSourcePath, pFunction, pOffset);
+	}
+
+	char pBuffer[1024];
+	if (pFunction && *pFunction && demangle(pBuffer, sizeof(pBuffer), pFunction))
+	{
+		pBuffer[sizeof(pBuffer) - 1] = '\0';
+		out << pBuffer;
+	}
+	else
+	{
+		out << "0x" << std::hex << reinterpret_cast<uint64_t>(pAddress) << std::dec;
+	}
+}
+
+void IrStd::Exception::callStack(std::ostream& out, const size_t skipFirstNb) noexcept
+{
+	constexpr size_t MAX_STACK_LEVEL = 64;
+	void* addresses[MAX_STACK_LEVEL];
+
+	const int nbLevels = ::backtrace(addresses, MAX_STACK_LEVEL);
+	const std::unique_ptr<char*, decltype(&std::free)> symbols(::backtrace_symbols(addresses, nbLevels), &std::free);
+
+	for(int level = static_cast<int>(skipFirstNb); level < nbLevels; ++level)
+	{
+		const char* pSourcePath;
+		const char* pFunction;
+		const char* pOffset;
+		parseSymbol(symbols.get()[level], pSourcePath, pFunction, pOffset);
 
 		// Print stack trace number and memory address
 		out << "#" << std::dec << std::left << std::setfill(' ')
@@ -39,13 +39,16 @@
 #include "Main.hpp"
 #include "Memory.hpp"
 #include "Rand.hpp"
+#include "Rcu.hpp"
 #include "RWLock.hpp"
 #include "Server.hpp"
 #include "Server/ServerHTTP.hpp"
 #include "Server/ServerREST.hpp"
 #include "Scope.hpp"
+#include "SeqLock.hpp"
 #include "Streambuf.hpp"
 #include "Thread.hpp"
+#include "Timer.hpp"
 #include "Topic.hpp"
 #include "Type.hpp"
 #include "Utils.hpp"
@@ -11,6 +11,7 @@
 #include <mutex>
 
 #include "Bootstrap.hpp"
+#include "Rcu.hpp"
 #include "Utils.hpp"
 #include "Topic.hpp"
 #include "Scope.hpp"
@@ -152,16 +153,15 @@ namespace IrStd
 			}
 
 			Filter(const Filter& filter)
+					: m_minLevel(filter.m_minLevel)
+					, m_topics(*filter.m_topics.read())
 			{
-				*this = filter;
 			}
 
 			void operator=(const Filter& filter)
 			{
-				std::lock_guard<std::mutex> lock1(m_mutex);
-				std::lock_guard<std::mutex> lock2(filter.m_mutex);
 				m_minLevel = filter.m_minLevel;
-				m_topics = filter.m_topics;
+				m_topics.publish(*filter.m_topics.read());
 			}
 
 			void setLevel(const Level minLevel) noexcept
@@ -174,8 +174,7 @@ namespace IrStd
 				// Cannot print any logs as it make use of the logger which is currenlty
 				// deleting all its topics. Accessing 
 				IRSTD_SCOPE(scope, IrStd::Flag::IrStdMemoryNoTrace);
-				std::lock_guard<std::mutex> lock(m_mutex);
-				m_topics.clear();
+				m_topics.publish(TopicMap());
 			}
 
 			void addTopic(const TopicImpl& topic, const Level minLevel) noexcept
@@ -183,8 +182,9 @@ namespace IrStd
 				// Cannot print any logs as it make use of the logger which is locked
 				// as it is currenlty accessing the filter object
 				IRSTD_SCOPE(scope, IrStd::Flag::IrStdMemoryNoTrace);
-				std::lock_guard<std::mutex> lock(m_mutex);
-				m_topics.insert({topic.getRef(), minLevel});
+				m_topics.update([&](TopicMap& topics) {
+					topics.insert({topic.getRef(), minLevel});
+				});
 			}
 
 			bool isIgnored(const Level level, const TopicImpl& topic) noexcept
@@ -196,16 +196,16 @@ namespace IrStd
 					return false;
 				}
 
-				// Filter on topics
-				if (!m_topics.empty())
+				// Filter on topics, read without lock as it is done for every log
 				{
-					const auto* pTopic = &topic;
-					while (pTopic)
+					const auto topics = m_topics.read();
+					if (!topics->empty())
 					{
-						std::lock_guard<std::mutex> lock(m_mutex);
+						const auto* pTopic = &topic;
+						while (pTopic)
 						{
-							const auto it = m_topics.find(pTopic->getRef());
-							if (it != m_topics.end())
+							const auto it = topics->find(pTopic->getRef());
+							if (it != topics->end())
 							{
 								if (it->second <= level)
 								{
@@ -213,8 +213,8 @@ namespace IrStd
 								}
 								return true;
 							}
+							pTopic = pTopic->getParent();
 						}
-						pTopic = pTopic->getParent();
 					}
 				}
 
@@ -233,9 +233,10 @@ namespace IrStd
 				return true;
 			}
 		private:
+			typedef std::map<TopicImpl::Ref, Level> TopicMap;
+
 			Level m_minLevel;
-			std::map<TopicImpl::Ref, Level> m_topics;
-			mutable std::mutex m_mutex;
+			Rcu<TopicMap> m_topics;
 		};
 
 		/**
@@ -276,7 +277,10 @@ namespace IrStd
 
 		typedef std::vector<Stream> StreamList;
 
-		class OutputStream
+		/**
+		 * One stream is created per log entry, their memory is recycled by a pool
+		 */
+		class OutputStream : public IrStd::AllocatorImpl<IrStd::AllocatorObjectPool<OutputStream>>
 		{
 		public:
 			OutputStream() = delete;
@@ -32,6 +32,17 @@ int IrStd::Main::call(int (*mainFct)(int argc, char* argv[]), int argc, char* ar
 
 IrStd::Main::~Main()
 {
+	if (IrStd::Memory::getInstance().isLeakReport())
+	{
+		std::cerr << "Memory still allocated at exit: ";
+		IrStd::Memory::getInstance().dumpLeaks(std::cerr);
+	}
+	if (IrStd::Memory::getInstance().isObjectPoolReport())
+	{
+		IrStd::Memory::getInstance().eachObjectPool([](const char* const pName, const IrStd::Memory::ObjectPoolStatistics& stats) {
+			std::cout << "Object pool " << pName << ": " << IRSTD_OBJECTPOOL_STATISTICS_STREAM(stats) << std::endl;
+		});
+	}
 #if IRSTD_IS_DEBUG
 	std::cout << "Memory allocation statistics: " << IRSTD_MEMORY_DUMP_STREAM() << std::endl;
 #endif
@@ -1,14 +1,19 @@
 #pragma once
 
-#include <map>
 #include <atomic>
-#include <mutex>
+#include <functional>
+#include <thread>
 
 #include "Allocator.hpp"
 #include "Utils.hpp"
 #include "Bootstrap.hpp"
 #include "Assert.hpp"
 #include "Type/Memory.hpp"
+#include "Memory/AllocMap.hpp"
+#include "Memory/Budget.hpp"
+#include "Memory/HeapProfiler.hpp"
+#include "Memory/Sampler.hpp"
+#include "Memory/Snapshot.hpp"
 
 #define IRSTD_MEMORY_DUMP_STREAM() \
 		IRSTD_MEMORY_STATISTICS_STREAM(IrStd::Memory::getInstance().getStatistics())
@@ -24,73 +29,152 @@ namespace IrStd
 	class Memory : public SingletonImpl<Memory>
 	{
 	public:
+		/**
+		 * \brief Allocation statistics
+		 *
+		 * Allocations are accounted in per-thread counters, the statistics are
+		 * only aggregated when the values are read. The peak is refreshed every
+		 * time the statistics are read and every time a thread allocates more than
+		 * \ref PEAK_GRANULARITY bytes, hence its precision is bounded by the number
+		 * of threads times this granularity.
+		 */
 		class Statistics
 		{
 		public:
 			Statistics() noexcept
+					: m_isLive(false)
 			{
 				reset();
 			}
 
 			IrStd::Type::Memory getStatCurrent() const noexcept
 			{
-				const int64_t value = m_allocCurrent.load();
+				const int64_t value = getStatCurrentRaw();
 				const auto max = std::max(static_cast<int64_t>(0), value);
 				return max;
 			}
 			IrStd::Type::Memory getStatPeak() const noexcept
 			{
-				const int64_t value = m_allocPeak.load();
+				const int64_t value = getStatPeakRaw();
 				const auto max = std::max(static_cast<int64_t>(0), value);
 				return max;
 			}
 			size_t getStatNbNew() const noexcept
 			{
-				const int64_t value = m_allocNbNew.load();
+				const int64_t value = getStatNbNewRaw();
 				const auto max = std::max(static_cast<int64_t>(0), value);
 				return static_cast<size_t>(max);
 			}
 			size_t getStatNbDelete() const noexcept
 			{
-				const int64_t value = m_allocNbDelete.load();
+				const int64_t value = getStatNbDeleteRaw();
 				const auto max = std::max(static_cast<int64_t>(0), value);
 				return static_cast<size_t>(max);
 			}
 
 			int64_t getStatCurrentRaw() const noexcept
 			{
+				update();
 				return m_allocCurrent.load();
 			}
 			int64_t getStatPeakRaw() const noexcept
 			{
+				update();
 				return m_allocPeak.load();
 			}
 			int64_t getStatNbNewRaw() const noexcept
 			{
+				update();
 				return m_allocNbNew.load();
 			}
 			int64_t getStatNbDeleteRaw() const noexcept
 			{
+				update();
 				return m_allocNbDelete.load();
 			}
 
+			/**
+			 * \brief Limits on the current memory of these statistics
+			 */
+			MemoryImpl::Budget& getBudget() noexcept
+			{
+				return m_budget;
+			}
+			const MemoryImpl::Budget& getBudget() const noexcept
+			{
+				return m_budget;
+			}
+
 		private:
 			friend Memory;
 
+			struct Counters
+			{
+				int64_t m_current;
+				int64_t m_nbNew;
+				int64_t m_nbDelete;
+			};
+
 			void reset() noexcept
 			{
+				m_base = Counters{0, 0, 0};
 				m_allocPeak.store(0);
 				m_allocCurrent.store(0);
 				m_allocNbNew.store(0);
 				m_allocNbDelete.store(0);
 			}
 
-			std::atomic<int64_t> m_allocPeak;
-			std::atomic<int64_t> m_allocCurrent;
-			std::atomic<int64_t> m_allocNbNew;
-			std::atomic<int64_t> m_allocNbDelete;
+			/**
+			 * Start accounting the allocations from this point
+			 */
+			void start(const Counters& base) noexcept
+			{
+				reset();
+				m_base = base;
+				m_isLive.store(true);
+			}
+
+			/**
+			 * Freeze the statistics to their current value
+			 */
+			void stop() noexcept
+			{
+				update();
+				m_isLive.store(false);
+			}
+
+			/**
+			 * Set the statistics with a fixed snapshot
+			 */
+			void set(const Counters& counters, const int64_t peak) noexcept
+			{
+				m_isLive.store(false);
+				m_allocCurrent.store(counters.m_current);
+				m_allocNbNew.store(counters.m_nbNew);
+				m_allocNbDelete.store(counters.m_nbDelete);
+				m_allocPeak.store(peak);
+			}
+
+			/**
+			 * Aggregate the per-thread counters (only if the statistics are live)
+			 */
+			void update() const noexcept;
+
+			Counters m_base;
+			std::atomic<bool> m_isLive;
+			mutable std::atomic<int64_t> m_allocPeak;
+			mutable std::atomic<int64_t> m_allocCurrent;
+			mutable std::atomic<int64_t> m_allocNbNew;
+			mutable std::atomic<int64_t> m_allocNbDelete;
+			MemoryImpl::Budget m_budget;
 		};
 
+		/**
+		 * The peak and the budgets are refreshed each time a thread allocated
+		 * or released this amount of bytes
+		 */
+		static constexpr int64_t PEAK_GRANULARITY = 64 * 1024;
+
 		Statistics& getStatistics() const noexcept;
 
 		IrStd::Type::Memory getStatCurrent() const noexcept;
@@ -98,6 +182,129 @@ namespace IrStd
 		size_t getStatNbNew() const noexcept;
 		size_t getStatNbDelete() const noexcept;
 
+		/**
+		 * \brief Iterate through the statistics of each thread that allocated memory
+		 *
+		 * The statistics passed to the callback are a snapshot of the thread counters.
+		 * Note that the current memory of a thread can be negative if it released
+		 * memory allocated by other threads.
+		 */
+		void eachThread(const std::function<void(const std::thread::id, const Statistics&)>& callback) const;
+
+		/**
+		 * \brief Get the statistics of a specific thread
+		 *
+		 * \return false if the thread is unknown.
+		 */
+		bool getThreadStatistics(const std::thread::id id, Statistics& stats) const noexcept;
+
+		/**
+		 * \brief Memory budget
+		 *
+		 * Soft and hard limits on the memory currently allocated, with callbacks
+		 * called when a limit is crossed (in both directions). The global budget
+		 * applies to all allocations, a budget can also be set on a
+		 * \ref StatisticsScope to only account the allocations of this scope.
+		 *
+		 * The budgets are evaluated every time a thread allocated or released
+		 * \ref PEAK_GRANULARITY bytes, or explicitly with \ref checkBudget.
+		 *
+		 * \note The budgets rely on the memory monitoring, they are only
+		 * evaluated in debug or if IRSTD_MEMORY_MONITOR is set.
+		 */
+		typedef MemoryImpl::Budget Budget;
+		Budget& getBudget() noexcept;
+		void setBudget(const IrStd::Type::Memory soft, const IrStd::Type::Memory hard) noexcept;
+		Budget::Level getBudgetLevel() const noexcept;
+		void checkBudget() noexcept;
+
+		/**
+		 * \brief Sampling heap profiler
+		 *
+		 * Once started, one allocation every sampleInterval bytes (on average) is
+		 * sampled with its call stack. The live memory per call stack can then
+		 * be dumped with \ref dumpProfile, or to a file by sending
+		 * SIGUSR1 to the process (see \ref Bootstrap).
+		 *
+		 * \note The profiler relies on the memory monitoring, it is only
+		 * available in debug or if IRSTD_MEMORY_MONITOR is set.
+		 */
+		typedef MemoryImpl::HeapProfiler::Format ProfileFormat;
+		bool startProfiling(const size_t sampleInterval = MemoryImpl::HeapProfiler::DEFAULT_SAMPLE_INTERVAL,
+				const char* const pDumpPrefix = nullptr) noexcept;
+		void stopProfiling() noexcept;
+		bool isProfiling() const noexcept;
+		void dumpProfile(std::ostream& out, const ProfileFormat format = ProfileFormat::PPROF) const;
+
+		/**
+		 * \brief Snapshot of the live allocations
+		 *
+		 * The allocations are grouped by call stack and size. Two snapshots
+		 * taken some time apart can be compared with \ref Snapshot::dumpDiff
+		 * to find slow leaks.
+		 *
+		 * \note Only the allocations sampled by the profiler come with a call
+		 * stack, start it with a sample interval of 1 to trace all of them.
+		 */
+		typedef MemoryImpl::Snapshot Snapshot;
+		void takeSnapshot(Snapshot& snapshot) const;
+
+		/**
+		 * \brief Report the allocations still alive when \ref Main terminates
+		 *
+		 * The report is written before the static objects created ahead of
+		 * \ref Main are destroyed. The pool slabs and the per-thread records,
+		 * which live until the process exits, are allocated outside of the
+		 * monitored heap and are not listed.
+		 *
+		 * \param traceAll Start the profiler on every allocation, so that all
+		 *        the blocks allocated from now on come with their call stack.
+		 *        The blocks allocated before, such as the singletons, are then
+		 *        left out of the report.
+		 */
+		void enableLeakReport(const bool traceAll = true) noexcept;
+		bool isLeakReport() const noexcept;
+		void dumpLeaks(std::ostream& out, const size_t maxGroups = Snapshot::DEFAULT_MAX_GROUPS) const;
+
+		/**
+		 * \brief Iterate through the statistics of the object pools (see \ref ObjectPool)
+		 */
+		typedef ObjectPoolBase::Statistics ObjectPoolStatistics;
+		void eachObjectPool(const std::function<void(const char* const pName, const ObjectPoolStatistics&)>& callback) const;
+
+		/**
+		 * \brief Print the statistics of the object pools when \ref Main terminates
+		 */
+		void enableObjectPoolReport() noexcept;
+		bool isObjectPoolReport() const noexcept;
+
+		/**
+		 * Arena information (see \ref ArenaScope)
+		 */
+		IrStd::Type::Memory getArenaReserved() const noexcept;
+		IrStd::Type::Memory getArenaAllocated() const noexcept;
+		size_t getArenaNbAllocations() const noexcept;
+		size_t getArenaNbScopes() const noexcept;
+
+		/**
+		 * \brief Process and system memory usage
+		 *
+		 * The values are sampled at most once per interval (see \ref setSamplingInterval),
+		 * reading them between 2 samples is lock-free and does not involve any system call.
+		 */
+		typedef MemoryImpl::Sampler::Sample Sample;
+		Sample getSample() const noexcept;
+
+		/**
+		 * \brief Set the minimum time between 2 samples, 0 to sample on every read
+		 */
+		void setSamplingInterval(const uint64_t intervalMs) noexcept;
+
+		/**
+		 * \brief Get the latest samples, from the oldest to the latest
+		 */
+		void getSampleHistory(std::vector<Sample>& sampleList) const;
+
 		/**
 		 * Virtual memory information
 		 */
@@ -137,11 +344,20 @@ namespace IrStd
 				return m_localStatistics;
 			}
 
+			/**
+			 * \brief Budget of the allocations made while this scope is monitoring
+			 */
+			Budget& getBudget() noexcept
+			{
+				return m_localStatistics.getBudget();
+			}
+
 			void startMonitoring() noexcept
 			{
 				IRSTD_ASSERT(m_prevStatistics == nullptr, "Monitoring is already activated");
-				m_localStatistics.reset();
-				m_prevStatistics = Memory::getInstance().m_pStatistics.exchange(&m_localStatistics);
+				auto& memory = Memory::getInstance();
+				m_localStatistics.start(memory.getCounters());
+				m_prevStatistics = memory.m_pStatistics.exchange(&m_localStatistics);
 			}
 
 			void stopMonitoring() noexcept
@@ -150,15 +366,7 @@ namespace IrStd
 
 				Memory::getInstance().m_pStatistics.store(m_prevStatistics);
 				m_prevStatistics = nullptr;
-
-				// Update the statistics
-				{
-					auto& stats = Memory::getInstance().getStatistics();
-					stats.m_allocCurrent.store(m_localStatistics.getStatCurrentRaw());
-					stats.m_allocNbNew += m_localStatistics.getStatNbNewRaw();
-					stats.m_allocNbDelete += m_localStatistics.getStatNbDeleteRaw();
-					stats.m_allocPeak.store(std::max(stats.getStatPeakRaw(), m_localStatistics.getStatPeakRaw()));
-				}
+				m_localStatistics.stop();
 			}
 
 		private:
@@ -169,10 +377,12 @@ namespace IrStd
 	private:
 		friend void* ::operator new(size_t);
 		friend void* ::operator new(size_t, const std::nothrow_t&) noexcept;
-		friend void ::operator delete(void* ptr);
+		friend void ::operator delete(void* ptr) noexcept;
 		friend SingletonImpl<Memory>;
 		friend Bootstrap;
 		friend StatisticsScope;
+		friend ArenaScope;
+		friend AllocatorLarge;
 
 		Memory();
 
@@ -185,15 +395,67 @@ namespace IrStd
 		void* newImpl(size_t size) noexcept;
 		void deleteImpl(void* ptr) noexcept;
 
-		template<typename Key, typename T>
-		using MapAllocBypass = std::map<Key, T, std::less<Key>, IrStd::AllocatorObj<std::pair<const Key, T>, AllocatorRaw>>;
-		MapAllocBypass<void*, size_t> m_allocMap;
+		/**
+		 * Account a block in the statistics, the budgets, the profiler and the leak
+		 * report. Used by new/delete, and by the allocators bypassing them (see
+		 * \ref AllocatorLarge), when \ref isRecording is true.
+		 */
+		static bool isRecording() noexcept;
+		void recordAlloc(void* ptr, size_t size) noexcept;
+		void recordFree(void* ptr) noexcept;
 
-		std::mutex m_mutexAllocMap;
+		/**
+		 * Per-thread allocation counters
+		 */
+		class ThreadCounters;
+		ThreadCounters* getThreadCounters() noexcept;
+		void releaseThreadCounters(ThreadCounters* pCounters) noexcept;
+
+		/**
+		 * Sum of all the thread counters
+		 */
+		Statistics::Counters getCounters() const noexcept;
+
+		/**
+		 * Refresh the peak of the live statistics and evaluate their budget
+		 */
+		void updatePeak() noexcept;
+
+		/**
+		 * Arena accounting, the allocations are only reported when a scope terminates
+		 */
+		void reserveArena(const int64_t size) noexcept;
+		void releaseArena(const size_t allocated, const size_t nbAllocations) noexcept;
+
+		/**
+		 * Write the heap profile to a file from a separate thread, this is async-signal-safe
+		 */
+		void requestProfileDump() noexcept;
+
+		MemoryImpl::AllocMap m_allocMap;
+		MemoryImpl::HeapProfiler m_profiler;
+		mutable MemoryImpl::Sampler m_sampler;
+		std::atomic<bool> m_isLeakReport;
+		// Only the blocks allocated once the report is enabled are listed
+		std::atomic<bool> m_isLeakTraceAll;
+		std::atomic<bool> m_isObjectPoolReport;
 
 		Statistics m_statistics;
 		std::atomic<Statistics*> m_pStatistics;
 
+		// List of all thread counters ever created, they are re-used once the thread terminates
+		std::atomic<ThreadCounters*> m_pThreadCountersList;
+		// Counters of terminated threads and of threads which local storage is destroyed
+		std::atomic<int64_t> m_retiredCurrent;
+		std::atomic<int64_t> m_retiredNbNew;
+		std::atomic<int64_t> m_retiredNbDelete;
+
+		// Arena related
+		std::atomic<int64_t> m_arenaReserved;
+		std::atomic<uint64_t> m_arenaAllocated;
+		std::atomic<uint64_t> m_arenaNbAllocations;
+		std::atomic<uint64_t> m_arenaNbScopes;
+
 		static bool m_enable;
 	};
 }
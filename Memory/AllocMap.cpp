@@ -0,0 +1,272 @@
+#include <cstdlib>
+#include <thread>
+
+#include "AllocMap.hpp"
+
+namespace
+{
+	constexpr size_t INITIAL_CAPACITY = 256;
+	// Spin this number of times before yielding
+	constexpr size_t SPIN_BEFORE_YIELD = 64;
+
+	void* const EMPTY = nullptr;
+	void* const TOMBSTONE = reinterpret_cast<void*>(static_cast<uintptr_t>(1));
+
+	// The shard is selected with the highest bits of the hash,
+	// and the slot within a shard with the following ones.
+	size_t getShardIndex(const uint64_t hash) noexcept
+	{
+		return static_cast<size_t>(hash >> 58);
+	}
+	size_t getSlotHash(const uint64_t hash) noexcept
+	{
+		return static_cast<size_t>(hash >> 16);
+	}
+}
+
+// ---- IrStd::MemoryImpl::AllocMap -------------------------------------------
+
+uint64_t IrStd::MemoryImpl::AllocMap::hash(const void* const ptr) noexcept
+{
+	// Allocations are at least 8-byte aligned, discard the lowest bits
+	// and mix the rest (Fibonacci hashing)
+	const uint64_t value = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr)) >> 3;
+	return value * 0x9e3779b97f4a7c15ull;
+}
+
+bool IrStd::MemoryImpl::AllocMap::insert(void* const ptr, const size_t size) noexcept
+{
+	const auto h = hash(ptr);
+	return m_shardList[getShardIndex(h)].insert(ptr, getSlotHash(h), size);
+}
+
+bool IrStd::MemoryImpl::AllocMap::erase(void* const ptr, size_t& size) noexcept
+{
+	const auto h = hash(ptr);
+	return m_shardList[getShardIndex(h)].erase(ptr, getSlotHash(h), size);
+}
+
+bool IrStd::MemoryImpl::AllocMap::find(void* const ptr, size_t& size) const noexcept
+{
+	const auto h = hash(ptr);
+	return m_shardList[getShardIndex(h)].find(ptr, getSlotHash(h), size);
+}
+
+void IrStd::MemoryImpl::AllocMap::each(const std::function<void(void* const ptr, const size_t size)>& callback) const
+{
+	for (const auto& shard : m_shardList)
+	{
+		shard.each(callback);
+	}
+}
+
+size_t IrStd::MemoryImpl::AllocMap::size() const noexcept
+{
+	size_t total = 0;
+	for (const auto& shard : m_shardList)
+	{
+		total += shard.size();
+	}
+	return total;
+}
+
+void IrStd::MemoryImpl::AllocMap::clear() noexcept
+{
+	for (auto& shard : m_shardList)
+	{
+		shard.clear();
+	}
+}
+
+// ---- IrStd::MemoryImpl::AllocMap::Shard ------------------------------------
+
+IrStd::MemoryImpl::AllocMap::Shard::Shard() noexcept
+		: m_pTable(nullptr)
+		, m_capacity(0)
+		, m_size(0)
+		, m_nbTombstones(0)
+{
+	m_lock.clear();
+}
+
+IrStd::MemoryImpl::AllocMap::Shard::~Shard()
+{
+	std::free(m_pTable);
+}
+
+void IrStd::MemoryImpl::AllocMap::Shard::lock() const noexcept
+{
+	size_t counter = 0;
+	while (m_lock.test_and_set(std::memory_order_acquire))
+	{
+		if (++counter % SPIN_BEFORE_YIELD == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void IrStd::MemoryImpl::AllocMap::Shard::unlock() const noexcept
+{
+	m_lock.clear(std::memory_order_release);
+}
+
+size_t IrStd::MemoryImpl::AllocMap::Shard::size() const noexcept
+{
+	return m_size.load(std::memory_order_relaxed);
+}
+
+void IrStd::MemoryImpl::AllocMap::Shard::clear() noexcept
+{
+	lock();
+	std::free(m_pTable);
+	m_pTable = nullptr;
+	m_capacity = 0;
+	m_nbTombstones = 0;
+	m_size.store(0, std::memory_order_relaxed);
+	unlock();
+}
+
+bool IrStd::MemoryImpl::AllocMap::Shard::rehash(const size_t capacity) noexcept
+{
+	// The capacity must be a power of 2
+	Entry* const pTable = static_cast<Entry*>(std::calloc(capacity, sizeof(Entry)));
+	if (pTable == nullptr)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < m_capacity; ++i)
+	{
+		const Entry& entry = m_pTable[i];
+		if (entry.m_ptr != EMPTY && entry.m_ptr != TOMBSTONE)
+		{
+			size_t index = getSlotHash(hash(entry.m_ptr)) & (capacity - 1);
+			while (pTable[index].m_ptr != EMPTY)
+			{
+				index = (index + 1) & (capacity - 1);
+			}
+			pTable[index] = entry;
+		}
+	}
+
+	std::free(m_pTable);
+	m_pTable = pTable;
+	m_capacity = capacity;
+	m_nbTombstones = 0;
+
+	return true;
+}
+
+bool IrStd::MemoryImpl::AllocMap::Shard::insert(void* const ptr, const size_t h, const size_t size) noexcept
+{
+	lock();
+
+	// Keep the load factor (including tombstones) below 75%
+	const size_t nbUsed = m_size.load(std::memory_order_relaxed) + m_nbTombstones + 1;
+	if (nbUsed * 4 > m_capacity * 3)
+	{
+		// Grow only if the table is really full, otherwise clean the tombstones
+		const size_t capacity = (m_capacity == 0) ? INITIAL_CAPACITY
+				: ((m_size.load(std::memory_order_relaxed) + 1) * 2 > m_capacity) ? m_capacity * 2 : m_capacity;
+		if (!rehash(capacity))
+		{
+			unlock();
+			return false;
+		}
+	}
+
+	size_t index = h & (m_capacity - 1);
+	Entry* pTombstone = nullptr;
+	while (m_pTable[index].m_ptr != EMPTY)
+	{
+		if (m_pTable[index].m_ptr == ptr)
+		{
+			unlock();
+			return false;
+		}
+		if (m_pTable[index].m_ptr == TOMBSTONE && pTombstone == nullptr)
+		{
+			pTombstone = &m_pTable[index];
+		}
+		index = (index + 1) & (m_capacity - 1);
+	}
+
+	// Re-use a tombstone if any was found on the way
+	Entry* const pEntry = (pTombstone) ? pTombstone : &m_pTable[index];
+	if (pTombstone)
+	{
+		--m_nbTombstones;
+	}
+	pEntry->m_ptr = ptr;
+	pEntry->m_size = size;
+	m_size.fetch_add(1, std::memory_order_relaxed);
+
+	unlock();
+	return true;
+}
+
+bool IrStd::MemoryImpl::AllocMap::Shard::erase(void* const ptr, const size_t h, size_t& size) noexcept
+{
+	lock();
+
+	if (m_capacity)
+	{
+		size_t index = h & (m_capacity - 1);
+		while (m_pTable[index].m_ptr != EMPTY)
+		{
+			if (m_pTable[index].m_ptr == ptr)
+			{
+				size = m_pTable[index].m_size;
+				m_pTable[index].m_ptr = TOMBSTONE;
+				++m_nbTombstones;
+				m_size.fetch_sub(1, std::memory_order_relaxed);
+				unlock();
+				return true;
+			}
+			index = (index + 1) & (m_capacity - 1);
+		}
+	}
+
+	unlock();
+	return false;
+}
+
+bool IrStd::MemoryImpl::AllocMap::Shard::find(void* const ptr, const size_t h, size_t& size) const noexcept
+{
+	lock();
+
+	if (m_capacity)
+	{
+		size_t index = h & (m_capacity - 1);
+		while (m_pTable[index].m_ptr != EMPTY)
+		{
+			if (m_pTable[index].m_ptr == ptr)
+			{
+				size = m_pTable[index].m_size;
+				unlock();
+				return true;
+			}
+			index = (index + 1) & (m_capacity - 1);
+		}
+	}
+
+	unlock();
+	return false;
+}
+
+void IrStd::MemoryImpl::AllocMap::Shard::each(const std::function<void(void* const ptr, const size_t size)>& callback) const
+{
+	lock();
+
+	for (size_t i = 0; i < m_capacity; ++i)
+	{
+		const Entry& entry = m_pTable[i];
+		if (entry.m_ptr != EMPTY && entry.m_ptr != TOMBSTONE)
+		{
+			callback(entry.m_ptr, entry.m_size);
+		}
+	}
+
+	unlock();
+}
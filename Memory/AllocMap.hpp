@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace IrStd
+{
+	namespace MemoryImpl
+	{
+		/**
+		 * \brief Keep track of the live allocations and their size.
+		 *
+		 * Pointers are distributed over several shards, each shard being a small
+		 * open-addressing hash table protected by its own spin lock. Threads
+		 * allocating concurrently will most likely hit different shards and
+		 * therefore never contend on the same lock.
+		 *
+		 * \note The tables are allocated with malloc directly, so that the map
+		 * can be used from within the new/delete operators.
+		 */
+		class AllocMap
+		{
+		public:
+			// Must match the number of bits used to select the shard
+			static constexpr size_t NB_SHARDS = 64;
+
+			AllocMap() = default;
+			AllocMap(const AllocMap&) = delete;
+			AllocMap& operator=(const AllocMap&) = delete;
+
+			/**
+			 * \brief Record a new allocation
+			 *
+			 * \return false if the entry already exists or if the table
+			 *         could not be extended.
+			 */
+			bool insert(void* const ptr, const size_t size) noexcept;
+
+			/**
+			 * \brief Remove an allocation
+			 *
+			 * \param ptr The pointer to remove
+			 * \param size Set with the size of the allocation
+			 *
+			 * \return false if the entry does not exists.
+			 */
+			bool erase(void* const ptr, size_t& size) noexcept;
+
+			/**
+			 * \brief Look for an allocation
+			 *
+			 * \return false if the entry does not exists.
+			 */
+			bool find(void* const ptr, size_t& size) const noexcept;
+
+			/**
+			 * \brief Iterate through all the entries
+			 *
+			 * \note The callback is called while a shard is locked, it must not
+			 * allocate memory through the new operator.
+			 */
+			void each(const std::function<void(void* const ptr, const size_t size)>& callback) const;
+
+			/**
+			 * \brief Number of live allocations recorded
+			 */
+			size_t size() const noexcept;
+
+			/**
+			 * \brief Remove all the entries and release the tables
+			 */
+			void clear() noexcept;
+
+		private:
+			struct Entry
+			{
+				void* m_ptr;
+				size_t m_size;
+			};
+
+			// Shards are aligned on a cache line to avoid false sharing
+			class alignas(64) Shard
+			{
+			public:
+				Shard() noexcept;
+				~Shard();
+
+				bool insert(void* const ptr, const size_t hash, const size_t size) noexcept;
+				bool erase(void* const ptr, const size_t hash, size_t& size) noexcept;
+				bool find(void* const ptr, const size_t hash, size_t& size) const noexcept;
+				void each(const std::function<void(void* const ptr, const size_t size)>& callback) const;
+				size_t size() const noexcept;
+				void clear() noexcept;
+
+			private:
+				void lock() const noexcept;
+				void unlock() const noexcept;
+
+				/**
+				 * Resize the table, this also gets rid of the tombstones
+				 */
+				bool rehash(const size_t capacity) noexcept;
+
+				// Spin lock protecting the table
+				mutable std::atomic_flag m_lock;
+				Entry* m_pTable;
+				size_t m_capacity;
+				std::atomic<size_t> m_size;
+				size_t m_nbTombstones;
+			};
+
+			static uint64_t hash(const void* const ptr) noexcept;
+
+			Shard m_shardList[NB_SHARDS];
+		};
+	}
+}
@@ -0,0 +1,128 @@
+#include <algorithm>
+
+#include "Budget.hpp"
+
+// ---- IrStd::MemoryImpl::Budget ---------------------------------------------
+
+IrStd::MemoryImpl::Budget::Budget() noexcept
+		: m_soft(0)
+		, m_hard(0)
+		, m_level(Level::NORMAL)
+		, m_nextId(0)
+{
+}
+
+bool& IrStd::MemoryImpl::Budget::isBusy() noexcept
+{
+	static thread_local bool isBusy = false;
+	return isBusy;
+}
+
+void IrStd::MemoryImpl::Budget::set(const IrStd::Type::Memory soft, const IrStd::Type::Memory hard) noexcept
+{
+	m_soft.store(static_cast<uint64_t>(soft), std::memory_order_relaxed);
+	m_hard.store(static_cast<uint64_t>(hard), std::memory_order_relaxed);
+}
+
+IrStd::Type::Memory IrStd::MemoryImpl::Budget::getSoft() const noexcept
+{
+	return m_soft.load(std::memory_order_relaxed);
+}
+
+IrStd::Type::Memory IrStd::MemoryImpl::Budget::getHard() const noexcept
+{
+	return m_hard.load(std::memory_order_relaxed);
+}
+
+size_t IrStd::MemoryImpl::Budget::addCallback(const Callback& callback)
+{
+	// Can be called from a callback
+	const bool wasBusy = isBusy();
+	isBusy() = true;
+	size_t id;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		id = m_nextId++;
+		m_callbackList.emplace_back(id, callback);
+	}
+	isBusy() = wasBusy;
+	return id;
+}
+
+void IrStd::MemoryImpl::Budget::removeCallback(const size_t id)
+{
+	const bool wasBusy = isBusy();
+	isBusy() = true;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_callbackList.erase(std::remove_if(m_callbackList.begin(), m_callbackList.end(),
+				[id](const std::pair<size_t, Callback>& item) { return item.first == id; }),
+				m_callbackList.end());
+	}
+	isBusy() = wasBusy;
+}
+
+void IrStd::MemoryImpl::Budget::check(const int64_t current) noexcept
+{
+	if (isBusy())
+	{
+		return;
+	}
+
+	const uint64_t value = static_cast<uint64_t>(std::max(static_cast<int64_t>(0), current));
+	const uint64_t soft = m_soft.load(std::memory_order_relaxed);
+	const uint64_t hard = m_hard.load(std::memory_order_relaxed);
+	const Level level = (hard && value >= hard) ? Level::HARD
+			: ((soft && value >= soft) ? Level::SOFT : Level::NORMAL);
+
+	// Only the thread changing the level notifies the callbacks
+	Level previous = m_level.load(std::memory_order_relaxed);
+	if (previous == level || !m_level.compare_exchange_strong(previous, level))
+	{
+		return;
+	}
+
+	isBusy() = true;
+	// Callbacks are called without the lock, they can add or remove callbacks
+	std::vector<std::pair<size_t, Callback>> callbackList;
+	try
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		callbackList = m_callbackList;
+	}
+	catch (...)
+	{
+		// Out of memory, the level change cannot be notified
+	}
+	for (const auto& item : callbackList)
+	{
+		try
+		{
+			item.second(level, value);
+		}
+		catch (...)
+		{
+			// Callbacks are called from the allocator, errors cannot be propagated
+		}
+	}
+	isBusy() = false;
+}
+
+std::ostream& operator<<(std::ostream& os, const IrStd::MemoryImpl::Budget::Level level)
+{
+	switch (level)
+	{
+	case IrStd::MemoryImpl::Budget::Level::NORMAL:
+		os << "NORMAL";
+		break;
+	case IrStd::MemoryImpl::Budget::Level::SOFT:
+		os << "SOFT";
+		break;
+	case IrStd::MemoryImpl::Budget::Level::HARD:
+		os << "HARD";
+		break;
+	default:
+		os << "UNKNOWN";
+	}
+	return os;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "../Type/Memory.hpp"
+
+namespace IrStd
+{
+	namespace MemoryImpl
+	{
+		/**
+		 * \brief Soft and hard limits on the memory allocated
+		 *
+		 * The current level is re-evaluated with \ref check, the callbacks are
+		 * called each time the level changes, from the thread that detected
+		 * the change. They are meant to shed load (drop caches, reject new
+		 * connections, flush buffers...) before the process runs out of memory.
+		 *
+		 * \note Allocating or releasing memory from a callback is allowed, but
+		 * the budget is not re-evaluated until the callbacks return. Callbacks
+		 * can add or remove callbacks, the change applies to the next level
+		 * change.
+		 */
+		class Budget
+		{
+		public:
+			enum class Level
+			{
+				/**
+				 * Below the soft limit, or no limit set
+				 */
+				NORMAL = 0,
+				/**
+				 * Above the soft limit, memory should be released when possible
+				 */
+				SOFT,
+				/**
+				 * Above the hard limit, no new work should be accepted
+				 */
+				HARD
+			};
+
+			typedef std::function<void(const Level level, const IrStd::Type::Memory current)> Callback;
+
+			Budget() noexcept;
+
+			Budget(const Budget&) = delete;
+			Budget& operator=(const Budget&) = delete;
+
+			/**
+			 * \brief Set the limits, 0 disables a limit
+			 */
+			void set(const IrStd::Type::Memory soft, const IrStd::Type::Memory hard) noexcept;
+
+			IrStd::Type::Memory getSoft() const noexcept;
+			IrStd::Type::Memory getHard() const noexcept;
+
+			bool isEnabled() const noexcept
+			{
+				return m_soft.load(std::memory_order_relaxed) || m_hard.load(std::memory_order_relaxed);
+			}
+
+			Level getLevel() const noexcept
+			{
+				return m_level.load(std::memory_order_relaxed);
+			}
+
+			/**
+			 * \brief Register a callback called on every level change
+			 *
+			 * \return An identifier to be used with \ref removeCallback.
+			 */
+			size_t addCallback(const Callback& callback);
+			void removeCallback(const size_t id);
+
+			/**
+			 * \brief Re-evaluate the level with the current memory allocated
+			 *
+			 * This is cheap unless the level changes.
+			 */
+			void check(const int64_t current) noexcept;
+
+		private:
+			/**
+			 * Set while the current thread is running callbacks or updating the
+			 * list, to prevent re-entering from the allocator.
+			 */
+			static bool& isBusy() noexcept;
+
+			std::atomic<uint64_t> m_soft;
+			std::atomic<uint64_t> m_hard;
+			std::atomic<Level> m_level;
+
+			std::mutex m_lock;
+			size_t m_nextId;
+			std::vector<std::pair<size_t, Callback>> m_callbackList;
+		};
+	}
+}
+
+std::ostream& operator<<(std::ostream& os, const IrStd::MemoryImpl::Budget::Level level);
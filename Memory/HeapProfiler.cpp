@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include <semaphore.h>
+
+#include "HeapProfiler.hpp"
+#include "../Exception.hpp"
+#include "../Logger.hpp"
+#include "../Topic.hpp"
+
+IRSTD_TOPIC_USE_ALIAS(IrStdMemory, IrStd, Memory);
+
+namespace
+{
+	// Skip the frames of the profiler and of the allocator
+	constexpr size_t SKIP_FRAMES = 3;
+	// Stacks are not created anymore past this limit, they are accounted in the overflow entry
+	constexpr size_t MAX_STACKS_USED = IrStd::MemoryImpl::HeapProfiler::MAX_STACKS * 3 / 4;
+	constexpr size_t OVERFLOW_INDEX = IrStd::MemoryImpl::HeapProfiler::MAX_STACKS;
+
+	static_assert((IrStd::MemoryImpl::HeapProfiler::MAX_STACKS & (IrStd::MemoryImpl::HeapProfiler::MAX_STACKS - 1)) == 0,
+			"The maximum number of stacks must be a power of 2");
+
+	thread_local int64_t bytesUntilSample = 0;
+	thread_local uint64_t randomState = 0;
+	// Set while a sample is being recorded, to ignore the allocations made meanwhile
+	thread_local bool isSampling = false;
+
+	sem_t dumpSemaphore;
+
+	/**
+	 * Distance to the next sample, following an exponential distribution
+	 */
+	int64_t getNextSampleDistance(const size_t sampleInterval) noexcept
+	{
+		if (!randomState)
+		{
+			randomState = reinterpret_cast<uintptr_t>(&randomState) ^ static_cast<uint64_t>(
+					std::chrono::steady_clock::now().time_since_epoch().count()) ^ 0x9e3779b97f4a7c15ull;
+		}
+		// xorshift64*
+		randomState ^= randomState >> 12;
+		randomState ^= randomState << 25;
+		randomState ^= randomState >> 27;
+		const uint64_t value = randomState * 0x2545f4914f6cdd1dull;
+
+		// Uniform value in ]0, 1]
+		const double uniform = static_cast<double>((value >> 11) + 1) / static_cast<double>(1ull << 53);
+		const double distance = -std::log(uniform) * static_cast<double>(sampleInterval);
+		return std::max(static_cast<int64_t>(1), static_cast<int64_t>(distance));
+	}
+
+	uint64_t hashStack(void* const* pAddressList, const size_t depth) noexcept
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (size_t i = 0; i < depth; ++i)
+		{
+			hash ^= static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pAddressList[i]));
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+}
+
+// ---- IrStd::MemoryImpl::HeapProfiler ---------------------------------------
+
+constexpr size_t IrStd::MemoryImpl::HeapProfiler::SAMPLED_FLAG;
+constexpr size_t IrStd::MemoryImpl::HeapProfiler::DEFAULT_SAMPLE_INTERVAL;
+constexpr size_t IrStd::MemoryImpl::HeapProfiler::MAX_DEPTH;
+constexpr size_t IrStd::MemoryImpl::HeapProfiler::MAX_STACKS;
+constexpr size_t IrStd::MemoryImpl::HeapProfiler::NO_STACK;
+
+IrStd::MemoryImpl::HeapProfiler::HeapProfiler() noexcept
+		: m_isActive(false)
+		, m_sampleInterval(DEFAULT_SAMPLE_INTERVAL)
+		, m_generation(0)
+		, m_pStackList(nullptr)
+		, m_nbStacks(0)
+		, m_nbDumps(0)
+		, m_isDumpThread(false)
+{
+	m_lock.clear();
+	m_dumpPrefix[0] = '\0';
+}
+
+IrStd::MemoryImpl::HeapProfiler::~HeapProfiler()
+{
+	m_isActive.store(false);
+	std::free(m_pStackList);
+}
+
+void IrStd::MemoryImpl::HeapProfiler::lock() const noexcept
+{
+	while (m_lock.test_and_set(std::memory_order_acquire))
+	{
+		std::this_thread::yield();
+	}
+}
+
+void IrStd::MemoryImpl::HeapProfiler::unlock() const noexcept
+{
+	m_lock.clear(std::memory_order_release);
+}
+
+bool IrStd::MemoryImpl::HeapProfiler::start(const size_t sampleInterval, const char* const pDumpPrefix) noexcept
+{
+	m_isActive.store(false);
+
+	lock();
+	if (!m_pStackList)
+	{
+		m_pStackList = static_cast<Stack*>(std::calloc(MAX_STACKS + 1, sizeof(Stack)));
+		if (!m_pStackList)
+		{
+			unlock();
+			return false;
+		}
+	}
+	else
+	{
+		std::memset(m_pStackList, 0, (MAX_STACKS + 1) * sizeof(Stack));
+	}
+	m_nbStacks = 0;
+	m_sampleInterval = std::max(static_cast<size_t>(1), sampleInterval);
+	++m_generation;
+	std::strncpy(m_dumpPrefix, (pDumpPrefix) ? pDumpPrefix : "heap", sizeof(m_dumpPrefix) - 1);
+	m_dumpPrefix[sizeof(m_dumpPrefix) - 1] = '\0';
+	unlock();
+
+	m_sampleMap.clear();
+
+	// The first call to backtrace might allocate memory, do it now
+	{
+		void* pAddress;
+		Exception::callStack(&pAddress, 1);
+	}
+
+	// Start the thread writing the profiles on request
+	bool expected = false;
+	if (m_isDumpThread.compare_exchange_strong(expected, true))
+	{
+		::sem_init(&dumpSemaphore, 0, 0);
+		std::thread([this]() {
+			for (;;)
+			{
+				while (::sem_wait(&dumpSemaphore) == -1 && errno == EINTR)
+				{
+				}
+				dumpToFile();
+			}
+		}).detach();
+	}
+
+	m_isActive.store(true);
+
+	return true;
+}
+
+void IrStd::MemoryImpl::HeapProfiler::stop() noexcept
+{
+	m_isActive.store(false);
+}
+
+bool IrStd::MemoryImpl::HeapProfiler::mustSample(const size_t size) noexcept
+{
+	if (isSampling)
+	{
+		return false;
+	}
+	if (!randomState)
+	{
+		bytesUntilSample = getNextSampleDistance(m_sampleInterval);
+	}
+	bytesUntilSample -= static_cast<int64_t>(size);
+	if (bytesUntilSample > 0)
+	{
+		return false;
+	}
+	bytesUntilSample = getNextSampleDistance(m_sampleInterval);
+	return true;
+}
+
+int64_t IrStd::MemoryImpl::HeapProfiler::getScaledSize(const size_t size) const noexcept
+{
+	// Probability for an allocation of this size to be sampled
+	const double probability = 1. - std::exp(-static_cast<double>(size) / static_cast<double>(m_sampleInterval));
+	return (probability > 0.) ? static_cast<int64_t>(static_cast<double>(size) / probability) : 0;
+}
+
+size_t IrStd::MemoryImpl::HeapProfiler::getStackIndex(void* const* pAddressList, const size_t depth) noexcept
+{
+	const uint64_t hash = hashStack(pAddressList, depth);
+	size_t index = static_cast<size_t>(hash) & (MAX_STACKS - 1);
+	while (m_pStackList[index].m_totalCount)
+	{
+		const Stack& stack = m_pStackList[index];
+		if (stack.m_hash == hash && stack.m_depth == depth
+				&& std::memcmp(stack.m_addressList, pAddressList, depth * sizeof(void*)) == 0)
+		{
+			return index;
+		}
+		index = (index + 1) & (MAX_STACKS - 1);
+	}
+
+	// Create a new entry
+	if (m_nbStacks >= MAX_STACKS_USED || !depth)
+	{
+		return OVERFLOW_INDEX;
+	}
+	Stack& stack = m_pStackList[index];
+	stack.m_hash = hash;
+	stack.m_depth = depth;
+	std::memcpy(stack.m_addressList, pAddressList, depth * sizeof(void*));
+	++m_nbStacks;
+
+	return index;
+}
+
+void IrStd::MemoryImpl::HeapProfiler::recordAlloc(void* const ptr, const size_t size) noexcept
+{
+	isSampling = true;
+
+	void* addressList[MAX_DEPTH];
+	const size_t depth = Exception::callStack(addressList, MAX_DEPTH, SKIP_FRAMES);
+
+	lock();
+	if (!m_pStackList)
+	{
+		unlock();
+		isSampling = false;
+		return;
+	}
+	const size_t index = getStackIndex(addressList, depth);
+	Stack& stack = m_pStackList[index];
+	++stack.m_liveCount;
+	stack.m_liveBytes += static_cast<int64_t>(size);
+	stack.m_liveBytesScaled += getScaledSize(size);
+	++stack.m_totalCount;
+	stack.m_totalBytes += size;
+	const uint64_t value = (static_cast<uint64_t>(m_generation) << 32) | index;
+	unlock();
+
+	m_sampleMap.insert(ptr, static_cast<size_t>(value));
+
+	isSampling = false;
+}
+
+void IrStd::MemoryImpl::HeapProfiler::recordFree(void* const ptr, const size_t size) noexcept
+{
+	size_t value;
+	if (!m_sampleMap.erase(ptr, value))
+	{
+		return;
+	}
+	const uint32_t generation = static_cast<uint32_t>(static_cast<uint64_t>(value) >> 32);
+	const size_t index = static_cast<size_t>(value & 0xffffffff);
+
+	lock();
+	if (generation == m_generation && index <= OVERFLOW_INDEX)
+	{
+		Stack& stack = m_pStackList[index];
+		--stack.m_liveCount;
+		stack.m_liveBytes -= static_cast<int64_t>(size);
+		stack.m_liveBytesScaled -= getScaledSize(size);
+	}
+	unlock();
+}
+
+size_t IrStd::MemoryImpl::HeapProfiler::findStack(void* const ptr) const noexcept
+{
+	size_t value;
+	if (!m_sampleMap.find(ptr, value))
+	{
+		return NO_STACK;
+	}
+	const uint32_t generation = static_cast<uint32_t>(static_cast<uint64_t>(value) >> 32);
+	const size_t index = static_cast<size_t>(value & 0xffffffff);
+
+	lock();
+	const bool isValid = (generation == m_generation && index < MAX_STACKS);
+	unlock();
+
+	return (isValid) ? index : NO_STACK;
+}
+
+size_t IrStd::MemoryImpl::HeapProfiler::copyStack(const size_t index, void** pAddressList) const noexcept
+{
+	size_t depth = 0;
+	lock();
+	if (m_pStackList && index < MAX_STACKS)
+	{
+		const Stack& stack = m_pStackList[index];
+		depth = stack.m_depth;
+		std::memcpy(pAddressList, stack.m_addressList, depth * sizeof(void*));
+	}
+	unlock();
+	return depth;
+}
+
+void IrStd::MemoryImpl::HeapProfiler::dump(std::ostream& out, const Format format) const
+{
+	// Copy the stacks first, the output stream might allocate memory
+	Stack* const pStackList = static_cast<Stack*>(std::malloc((MAX_STACKS + 1) * sizeof(Stack)));
+	if (!pStackList)
+	{
+		return;
+	}
+	lock();
+	if (m_pStackList)
+	{
+		std::memcpy(pStackList, m_pStackList, (MAX_STACKS + 1) * sizeof(Stack));
+	}
+	else
+	{
+		std::memset(pStackList, 0, (MAX_STACKS + 1) * sizeof(Stack));
+	}
+	const size_t sampleInterval = m_sampleInterval;
+	unlock();
+
+	switch (format)
+	{
+	case Format::PPROF:
+		{
+			int64_t liveCount = 0;
+			int64_t liveBytes = 0;
+			uint64_t totalCount = 0;
+			uint64_t totalBytes = 0;
+			for (size_t i = 0; i <= MAX_STACKS; ++i)
+			{
+				liveCount += pStackList[i].m_liveCount;
+				liveBytes += pStackList[i].m_liveBytes;
+				totalCount += pStackList[i].m_totalCount;
+				totalBytes += pStackList[i].m_totalBytes;
+			}
+
+			out << std::dec << "heap profile: " << liveCount << ": " << liveBytes
+					<< " [" << totalCount << ": " << totalBytes << "] @ heap_v2/" << sampleInterval << "\n";
+			for (size_t i = 0; i <= MAX_STACKS; ++i)
+			{
+				const Stack& stack = pStackList[i];
+				// Stacks in overflow cannot be represented in this format
+				if (!stack.m_totalCount || !stack.m_depth)
+				{
+					continue;
+				}
+				out << std::dec << stack.m_liveCount << ": " << stack.m_liveBytes
+						<< " [" << stack.m_totalCount << ": " << stack.m_totalBytes << "] @";
+				for (size_t level = 0; level < stack.m_depth; ++level)
+				{
+					out << " 0x" << std::hex << std::setfill('0') << std::setw(16)
+							<< reinterpret_cast<uint64_t>(stack.m_addressList[level]);
+				}
+				out << std::dec << "\n";
+			}
+
+			// The memory mapping is needed to resolve the symbols
+			out << "\nMAPPED_LIBRARIES:\n";
+			std::ifstream maps("/proc/self/maps");
+			out << maps.rdbuf();
+		}
+		break;
+
+	case Format::FLAMEGRAPH:
+		for (size_t i = 0; i <= MAX_STACKS; ++i)
+		{
+			const Stack& stack = pStackList[i];
+			if (stack.m_liveBytesScaled <= 0)
+			{
+				continue;
+			}
+			if (!stack.m_depth)
+			{
+				out << "[overflow]";
+			}
+			// Frames are printed from the root to the leaf
+			for (size_t level = stack.m_depth; level > 0; --level)
+			{
+				Exception::functionName(out, stack.m_addressList[level - 1]);
+				out << ((level > 1) ? ";" : "");
+			}
+			out << " " << std::dec << stack.m_liveBytesScaled << "\n";
+		}
+		break;
+
+	default:
+		IRSTD_UNREACHABLE();
+	}
+
+	std::free(pStackList);
+}
+
+void IrStd::MemoryImpl::HeapProfiler::requestDump() noexcept
+{
+	if (m_isDumpThread.load())
+	{
+		::sem_post(&dumpSemaphore);
+	}
+}
+
+void IrStd::MemoryImpl::HeapProfiler::dumpToFile() const
+{
+	std::stringstream pathStream;
+	pathStream << m_dumpPrefix << "." << std::setfill('0') << std::setw(4) << (++m_nbDumps) << ".heap";
+	const std::string path = pathStream.str();
+
+	std::ofstream file(path);
+	if (!file)
+	{
+		IRSTD_LOG_ERROR(IrStdMemory, "Cannot open heap profile file '" << path << "'");
+		return;
+	}
+	dump(file, Format::PPROF);
+	IRSTD_LOG_INFO(IrStdMemory, "Heap profile written to '" << path << "'");
+}
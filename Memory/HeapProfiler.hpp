@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "AllocMap.hpp"
+
+namespace IrStd
+{
+	namespace MemoryImpl
+	{
+		/**
+		 * \brief Sampling heap profiler
+		 *
+		 * On average one allocation is sampled every \ref m_sampleInterval bytes
+		 * (the distance between two samples follows an exponential distribution,
+		 * so that the result is not biased by periodic allocation patterns).
+		 * The call stack of each sampled allocation is captured and the live
+		 * bytes are aggregated per call stack.
+		 *
+		 * Only the sampled allocations are tracked, hence the overhead stays low
+		 * even with a high allocation rate.
+		 *
+		 * \note The tables are allocated with malloc directly, so that the profiler
+		 * can be used from within the new/delete operators.
+		 */
+		class HeapProfiler
+		{
+		public:
+			enum class Format
+			{
+				/**
+				 * Legacy heap profile format, readable by pprof
+				 */
+				PPROF,
+				/**
+				 * Collapsed stacks, readable by flamegraph.pl
+				 */
+				FLAMEGRAPH
+			};
+
+			/**
+			 * Flag set on the size of the sampled allocations in the allocation map
+			 */
+			static constexpr size_t SAMPLED_FLAG = static_cast<size_t>(1) << (sizeof(size_t) * 8 - 1);
+
+			static constexpr size_t DEFAULT_SAMPLE_INTERVAL = 512 * 1024;
+			static constexpr size_t MAX_DEPTH = 32;
+			static constexpr size_t MAX_STACKS = 2048;
+
+			/**
+			 * Returned by \ref findStack if the allocation has no call stack
+			 */
+			static constexpr size_t NO_STACK = static_cast<size_t>(-1);
+
+			HeapProfiler() noexcept;
+			~HeapProfiler();
+
+			HeapProfiler(const HeapProfiler&) = delete;
+			HeapProfiler& operator=(const HeapProfiler&) = delete;
+
+			/**
+			 * \brief Start sampling, this discards the previous samples
+			 *
+			 * \param sampleInterval Average number of bytes between two samples.
+			 * \param pDumpPrefix Prefix of the files written on \ref requestDump.
+			 */
+			bool start(const size_t sampleInterval, const char* const pDumpPrefix) noexcept;
+
+			/**
+			 * \brief Stop sampling, the samples are kept until the next start
+			 */
+			void stop() noexcept;
+
+			bool isActive() const noexcept
+			{
+				return m_isActive.load(std::memory_order_relaxed);
+			}
+
+			/**
+			 * \brief Account an allocation in the current thread
+			 *
+			 * \return true if the allocation must be sampled.
+			 */
+			bool mustSample(const size_t size) noexcept;
+
+			/**
+			 * \brief Record a sampled allocation with the current call stack
+			 */
+			void recordAlloc(void* const ptr, const size_t size) noexcept;
+
+			/**
+			 * \brief Release a sampled allocation
+			 */
+			void recordFree(void* const ptr, const size_t size) noexcept;
+
+			/**
+			 * \brief Index of the call stack of a sampled allocation
+			 *
+			 * \return The index, or \ref NO_STACK if the allocation was not
+			 *         sampled during the current session.
+			 */
+			size_t findStack(void* const ptr) const noexcept;
+
+			/**
+			 * \brief Copy the return addresses of a call stack
+			 *
+			 * \param pAddressList Must be able to contain \ref MAX_DEPTH addresses.
+			 *
+			 * \return The depth of the stack.
+			 */
+			size_t copyStack(const size_t index, void** pAddressList) const noexcept;
+
+			/**
+			 * \brief Write the live allocations sampled
+			 */
+			void dump(std::ostream& out, const Format format) const;
+
+			/**
+			 * \brief Ask for a profile to be written to a file by a dedicated thread
+			 *
+			 * \note This function is async-signal-safe.
+			 */
+			void requestDump() noexcept;
+
+		private:
+			struct Stack
+			{
+				uint64_t m_hash;
+				size_t m_depth;
+				void* m_addressList[MAX_DEPTH];
+				int64_t m_liveCount;
+				int64_t m_liveBytes;
+				// Estimation of the real number of bytes, taking the sampling into account
+				int64_t m_liveBytesScaled;
+				uint64_t m_totalCount;
+				uint64_t m_totalBytes;
+			};
+
+			void lock() const noexcept;
+			void unlock() const noexcept;
+
+			/**
+			 * Find or create the entry of a stack, the lock must be held
+			 */
+			size_t getStackIndex(void* const* pAddressList, const size_t depth) noexcept;
+
+			int64_t getScaledSize(const size_t size) const noexcept;
+
+			void dumpToFile() const;
+
+			std::atomic<bool> m_isActive;
+			size_t m_sampleInterval;
+			// Incremented on each start, to ignore samples from a previous session
+			uint32_t m_generation;
+
+			mutable std::atomic_flag m_lock;
+			Stack* m_pStackList;
+			size_t m_nbStacks;
+
+			// Sampled pointers and the index of their stack
+			AllocMap m_sampleMap;
+
+			char m_dumpPrefix[256];
+			mutable std::atomic<size_t> m_nbDumps;
+			std::atomic<bool> m_isDumpThread;
+		};
+	}
+}
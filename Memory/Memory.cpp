@@ -11,11 +11,6 @@
 #include "../Compiler.hpp"
 #include "../Utils.hpp"
 
-#if IRSTD_IS_PLATFORM(LINUX)
-	#include <sys/types.h>
-	#include <sys/sysinfo.h>
-#endif
-
 IRSTD_TOPIC_REGISTER(IrStd, Memory);
 IRSTD_TOPIC_USE_ALIAS(IrStdMemory, IrStd, Memory);
 IRSTD_SCOPE_LOCALTHREAD_REGISTER(IrStdMemoryNoTrace);
@@ -56,14 +51,398 @@ void operator delete(void* ptr) noexcept
 bool IrStd::Memory::m_enable = true;
 
 IrStd::Memory::Memory()
-		: m_statistics()
+		: m_isLeakReport(false)
+		, m_isLeakTraceAll(false)
+		, m_isObjectPoolReport(false)
+		, m_statistics()
 		, m_pStatistics(&m_statistics)
+		, m_pThreadCountersList(nullptr)
+		, m_retiredCurrent(0)
+		, m_retiredNbNew(0)
+		, m_retiredNbDelete(0)
+		, m_arenaReserved(0)
+		, m_arenaAllocated(0)
+		, m_arenaNbAllocations(0)
+		, m_arenaNbScopes(0)
+{
+	m_statistics.start(Statistics::Counters{0, 0, 0});
+}
+
+// ---- IrStd::Memory::ThreadCounters -----------------------------------------
+
+/**
+ * Counters are only written by their owner thread, so relaxed load/store
+ * operations are enough and no cache line is shared between threads.
+ */
+class alignas(64) IrStd::Memory::ThreadCounters
+{
+public:
+	ThreadCounters() noexcept
+			: m_current(0)
+			, m_peak(0)
+			, m_nbNew(0)
+			, m_nbDelete(0)
+			, m_untilPeakUpdate(PEAK_GRANULARITY)
+			, m_threadId(std::thread::id())
+			, m_isUsed(false)
+			, m_pNext(nullptr)
+	{
+	}
+
+	/**
+	 * \return true if the peak of the statistics must be refreshed
+	 */
+	bool add(const int64_t size) noexcept
+	{
+		const auto current = m_current.load(std::memory_order_relaxed) + size;
+		m_current.store(current, std::memory_order_relaxed);
+		m_nbNew.store(m_nbNew.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		if (current > m_peak.load(std::memory_order_relaxed))
+		{
+			m_peak.store(current, std::memory_order_relaxed);
+		}
+		m_untilPeakUpdate -= size;
+		if (m_untilPeakUpdate <= 0)
+		{
+			m_untilPeakUpdate = PEAK_GRANULARITY;
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * \return true if the statistics must be refreshed
+	 */
+	bool remove(const int64_t size) noexcept
+	{
+		m_current.store(m_current.load(std::memory_order_relaxed) - size, std::memory_order_relaxed);
+		m_nbDelete.store(m_nbDelete.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		m_untilPeakUpdate -= size;
+		if (m_untilPeakUpdate <= 0)
+		{
+			m_untilPeakUpdate = PEAK_GRANULARITY;
+			return true;
+		}
+		return false;
+	}
+
+	void clear() noexcept
+	{
+		m_current.store(0, std::memory_order_relaxed);
+		m_peak.store(0, std::memory_order_relaxed);
+		m_nbNew.store(0, std::memory_order_relaxed);
+		m_nbDelete.store(0, std::memory_order_relaxed);
+		m_untilPeakUpdate = PEAK_GRANULARITY;
+	}
+
+	IrStd::Memory::Statistics::Counters getCounters() const noexcept
+	{
+		return IrStd::Memory::Statistics::Counters{
+				m_current.load(std::memory_order_relaxed),
+				m_nbNew.load(std::memory_order_relaxed),
+				m_nbDelete.load(std::memory_order_relaxed)};
+	}
+
+	std::atomic<int64_t> m_current;
+	std::atomic<int64_t> m_peak;
+	std::atomic<int64_t> m_nbNew;
+	std::atomic<int64_t> m_nbDelete;
+	int64_t m_untilPeakUpdate;
+	// Read by other threads while the counters are used
+	std::atomic<std::thread::id> m_threadId;
+	std::atomic<bool> m_isUsed;
+	ThreadCounters* m_pNext;
+};
+
+IrStd::Memory::ThreadCounters* IrStd::Memory::getThreadCounters() noexcept
+{
+	static thread_local ThreadCounters* pCounters = nullptr;
+	static thread_local bool isTerminated = false;
+
+	if (pCounters || isTerminated)
+	{
+		return pCounters;
+	}
+
+	// Re-use the counters of a terminated thread if any
+	for (auto pCur = m_pThreadCountersList.load(); pCur; pCur = pCur->m_pNext)
+	{
+		bool expected = false;
+		if (!pCur->m_isUsed.load(std::memory_order_relaxed)
+				&& pCur->m_isUsed.compare_exchange_strong(expected, true))
+		{
+			pCounters = pCur;
+			break;
+		}
+	}
+
+	// Otherwise create new ones, bypassing the monitored allocator
+	if (!pCounters)
+	{
+		void* ptr = nullptr;
+		if (::posix_memalign(&ptr, alignof(ThreadCounters), sizeof(ThreadCounters)) != 0)
+		{
+			return nullptr;
+		}
+		pCounters = new (ptr) ThreadCounters();
+		pCounters->m_isUsed.store(true);
+		pCounters->m_pNext = m_pThreadCountersList.load();
+		while (!m_pThreadCountersList.compare_exchange_weak(pCounters->m_pNext, pCounters))
+		{
+		}
+	}
+	pCounters->m_threadId.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+	// Release the counters when the thread terminates
+	class Release
+	{
+	public:
+		~Release()
+		{
+			isTerminated = true;
+			ThreadCounters* const pReleased = pCounters;
+			pCounters = nullptr;
+			IrStd::Memory::getInstance().releaseThreadCounters(pReleased);
+		}
+	};
+	static thread_local Release release;
+	(void) release;
+
+	return pCounters;
+}
+
+void IrStd::Memory::releaseThreadCounters(ThreadCounters* pCounters) noexcept
+{
+	if (pCounters)
+	{
+		const auto counters = pCounters->getCounters();
+		m_retiredCurrent.fetch_add(counters.m_current);
+		m_retiredNbNew.fetch_add(counters.m_nbNew);
+		m_retiredNbDelete.fetch_add(counters.m_nbDelete);
+		pCounters->clear();
+		pCounters->m_threadId.store(std::thread::id(), std::memory_order_relaxed);
+		pCounters->m_isUsed.store(false);
+	}
+}
+
+IrStd::Memory::Statistics::Counters IrStd::Memory::getCounters() const noexcept
+{
+	Statistics::Counters counters{m_retiredCurrent.load(), m_retiredNbNew.load(), m_retiredNbDelete.load()};
+	for (auto pCur = m_pThreadCountersList.load(); pCur; pCur = pCur->m_pNext)
+	{
+		const auto threadCounters = pCur->getCounters();
+		counters.m_current += threadCounters.m_current;
+		counters.m_nbNew += threadCounters.m_nbNew;
+		counters.m_nbDelete += threadCounters.m_nbDelete;
+	}
+	return counters;
+}
+
+void IrStd::Memory::updatePeak() noexcept
+{
+	m_statistics.update();
+	m_statistics.m_budget.check(m_statistics.m_allocCurrent.load());
+	const auto pStatistics = m_pStatistics.load();
+	if (pStatistics != &m_statistics)
+	{
+		pStatistics->update();
+		pStatistics->m_budget.check(pStatistics->m_allocCurrent.load());
+	}
+}
+
+void IrStd::Memory::eachThread(const std::function<void(const std::thread::id, const Statistics&)>& callback) const
+{
+	for (auto pCur = m_pThreadCountersList.load(); pCur; pCur = pCur->m_pNext)
+	{
+		const auto id = pCur->m_threadId.load(std::memory_order_relaxed);
+		// The counters may be released meanwhile, or not yet assigned
+		if (pCur->m_isUsed.load() && id != std::thread::id())
+		{
+			Statistics stats;
+			stats.set(pCur->getCounters(), pCur->m_peak.load(std::memory_order_relaxed));
+			callback(id, stats);
+		}
+	}
+}
+
+bool IrStd::Memory::getThreadStatistics(const std::thread::id id, Statistics& stats) const noexcept
+{
+	for (auto pCur = m_pThreadCountersList.load(); pCur; pCur = pCur->m_pNext)
+	{
+		if (pCur->m_isUsed.load() && pCur->m_threadId.load(std::memory_order_relaxed) == id)
+		{
+			stats.set(pCur->getCounters(), pCur->m_peak.load(std::memory_order_relaxed));
+			return true;
+		}
+	}
+	return false;
+}
+
+// ---- Budget related --------------------------------------------------------
+
+IrStd::Memory::Budget& IrStd::Memory::getBudget() noexcept
+{
+	return m_statistics.m_budget;
+}
+
+void IrStd::Memory::setBudget(const IrStd::Type::Memory soft, const IrStd::Type::Memory hard) noexcept
+{
+	m_statistics.m_budget.set(soft, hard);
+}
+
+IrStd::Memory::Budget::Level IrStd::Memory::getBudgetLevel() const noexcept
+{
+	// The most restrictive level between the global and the current scope
+	const auto level = m_statistics.m_budget.getLevel();
+	const auto scopeLevel = m_pStatistics.load()->m_budget.getLevel();
+	return (static_cast<int>(scopeLevel) > static_cast<int>(level)) ? scopeLevel : level;
+}
+
+void IrStd::Memory::checkBudget() noexcept
+{
+	updatePeak();
+}
+
+// ---- Heap profiler related ------------------------------------------------
+
+bool IrStd::Memory::startProfiling(const size_t sampleInterval, const char* const pDumpPrefix) noexcept
+{
+#if IS_MEMORY_MONITOR
+	return m_profiler.start(sampleInterval, pDumpPrefix);
+#else
+	IRSTD_LOG_WARNING(IrStdMemory, "The heap profiler requires the memory monitoring");
+	(void) sampleInterval;
+	(void) pDumpPrefix;
+	return false;
+#endif
+}
+
+void IrStd::Memory::stopProfiling() noexcept
+{
+	m_profiler.stop();
+}
+
+bool IrStd::Memory::isProfiling() const noexcept
+{
+	return m_profiler.isActive();
+}
+
+void IrStd::Memory::dumpProfile(std::ostream& out, const ProfileFormat format) const
+{
+	m_profiler.dump(out, format);
+}
+
+void IrStd::Memory::requestProfileDump() noexcept
+{
+	m_profiler.requestDump();
+}
+
+// ---- Leak report related ---------------------------------------------------
+
+void IrStd::Memory::takeSnapshot(Snapshot& snapshot) const
+{
+	snapshot.collect(m_allocMap, m_profiler);
+}
+
+void IrStd::Memory::enableLeakReport(const bool traceAll) noexcept
 {
+	if (traceAll)
+	{
+		m_isLeakTraceAll.store(startProfiling(/*sampleInterval*/1));
+	}
+	m_isLeakReport.store(true);
+}
+
+bool IrStd::Memory::isLeakReport() const noexcept
+{
+	return m_isLeakReport.load();
+}
+
+void IrStd::Memory::dumpLeaks(std::ostream& out, const size_t maxGroups) const
+{
+	Snapshot snapshot;
+	takeSnapshot(snapshot);
+	if (m_isLeakTraceAll.load())
+	{
+		snapshot.removeUntraced();
+	}
+	snapshot.dump(out, maxGroups);
+}
+
+// ---- Object pool related ---------------------------------------------------
+
+void IrStd::Memory::eachObjectPool(const std::function<void(const char* const, const ObjectPoolStatistics&)>& callback) const
+{
+	ObjectPoolBase::each([&](const ObjectPoolBase& pool) {
+		callback(pool.getName(), pool.getStatistics());
+	});
+}
+
+void IrStd::Memory::enableObjectPoolReport() noexcept
+{
+	m_isObjectPoolReport.store(true);
+}
+
+bool IrStd::Memory::isObjectPoolReport() const noexcept
+{
+	return m_isObjectPoolReport.load();
 }
 
+// ---- Arena related ---------------------------------------------------------
+
+void IrStd::Memory::reserveArena(const int64_t size) noexcept
+{
+	m_arenaReserved.fetch_add(size, std::memory_order_relaxed);
+}
+
+void IrStd::Memory::releaseArena(const size_t allocated, const size_t nbAllocations) noexcept
+{
+	m_arenaAllocated.fetch_add(allocated, std::memory_order_relaxed);
+	m_arenaNbAllocations.fetch_add(nbAllocations, std::memory_order_relaxed);
+	m_arenaNbScopes.fetch_add(1, std::memory_order_relaxed);
+}
+
+IrStd::Type::Memory IrStd::Memory::getArenaReserved() const noexcept
+{
+	return std::max(static_cast<int64_t>(0), m_arenaReserved.load(std::memory_order_relaxed));
+}
+
+IrStd::Type::Memory IrStd::Memory::getArenaAllocated() const noexcept
+{
+	return m_arenaAllocated.load(std::memory_order_relaxed);
+}
+
+size_t IrStd::Memory::getArenaNbAllocations() const noexcept
+{
+	return static_cast<size_t>(m_arenaNbAllocations.load(std::memory_order_relaxed));
+}
+
+size_t IrStd::Memory::getArenaNbScopes() const noexcept
+{
+	return static_cast<size_t>(m_arenaNbScopes.load(std::memory_order_relaxed));
+}
 
 // ---- Statistics related  ---------------------------------------------------
 
+void IrStd::Memory::Statistics::update() const noexcept
+{
+	if (!m_isLive.load())
+	{
+		return;
+	}
+
+	const auto counters = Memory::getInstance().getCounters();
+	const int64_t current = counters.m_current - m_base.m_current;
+	m_allocCurrent.store(current);
+	m_allocNbNew.store(counters.m_nbNew - m_base.m_nbNew);
+	m_allocNbDelete.store(counters.m_nbDelete - m_base.m_nbDelete);
+
+	auto peak = m_allocPeak.load();
+	while (current > peak && !m_allocPeak.compare_exchange_weak(peak, current))
+	{
+	}
+}
+
 IrStd::Memory::Statistics& IrStd::Memory::getStatistics() const noexcept
 {
 	return *m_pStatistics.load();
@@ -109,25 +488,63 @@ void* IrStd::Memory::newImpl(size_t size) noexcept
 		return nullptr;
 	}
 
+	recordAlloc(ptr, size);
+
+	return ptr;
+}
+
+// ---- IrStd::Memory::deleteImpl ---------------------------------------------
+
+void IrStd::Memory::deleteImpl(void* ptr) noexcept
+{
+	recordFree(ptr);
+	std::free(ptr);
+}
+
+// ---- IrStd::Memory::recordAlloc --------------------------------------------
+
+bool IrStd::Memory::isRecording() noexcept
+{
+#if IS_MEMORY_MONITOR
+	return IrStd::Main::isAlive() && m_enable;
+#else
+	return false;
+#endif
+}
+
+void IrStd::Memory::recordAlloc(void* ptr, size_t size) noexcept
+{
 #if IS_MEMORY_MONITOR
 	// Record this entry
 	{
 		IRSTD_SCOPE(IrStd::Flag::IrStdMemoryNoTrace);
-		std::pair<void*, size_t> entry(ptr, size);
 		{
-			std::lock_guard<std::mutex> lock(m_mutexAllocMap);
-			const auto ret = m_allocMap.insert(entry);
-			IRSTD_ASSERT(IrStdMemory, ret.second, "Entry " << static_cast<void*>(ptr) << " already exists");
+			const bool isSampled = m_profiler.isActive() && m_profiler.mustSample(size);
+			const auto ret = m_allocMap.insert(ptr, (isSampled) ? (size | MemoryImpl::HeapProfiler::SAMPLED_FLAG) : size);
+			IRSTD_ASSERT(IrStdMemory, ret, "Entry " << static_cast<void*>(ptr) << " already exists");
+			if (isSampled)
+			{
+				m_profiler.recordAlloc(ptr, size);
+			}
 		}
 		{
-			auto& stats = getStatistics();
-			stats.m_allocCurrent.fetch_add(size);
-			stats.m_allocPeak.store(std::max(stats.getStatPeakRaw(), stats.getStatCurrentRaw()));
-			stats.m_allocNbNew++;
+			const auto pCounters = getThreadCounters();
+			if (pCounters)
+			{
+				if (pCounters->add(static_cast<int64_t>(size)))
+				{
+					updatePeak();
+				}
+			}
+			else
+			{
+				m_retiredCurrent.fetch_add(static_cast<int64_t>(size));
+				m_retiredNbNew++;
+			}
 		}
 	}
 
-#if IS_MEMORY_MONITOR && defined(IRSTDMEMORY_DEBUG)
+#if defined(IRSTDMEMORY_DEBUG)
 	{
 		IRSTD_SCOPE(scope, IrStd::Flag::IrStdMemoryNoTrace);
 		if (scope.isActivator())
@@ -139,39 +556,48 @@ void* IrStd::Memory::newImpl(size_t size) noexcept
 		}
 	}
 #endif
+#else
+	(void) ptr;
+	(void) size;
 #endif
-
-	return ptr;
 }
 
-// ---- IrStd::Memory::deleteImpl ---------------------------------------------
+// ---- IrStd::Memory::recordFree ---------------------------------------------
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-but-set-variable"
-void IrStd::Memory::deleteImpl(void* ptr) noexcept
+void IrStd::Memory::recordFree(void* ptr) noexcept
 {
 #if IS_MEMORY_MONITOR
 	size_t size = 0;
 	// Update the records
 	{
 		IRSTD_SCOPE(IrStd::Flag::IrStdMemoryNoTrace);
-		auto& stats = getStatistics();
 		{
-			std::lock_guard<std::mutex> lock(m_mutexAllocMap);
-			const auto it = m_allocMap.find(ptr);
-			IRSTD_ASSERT(IrStdMemory, it != m_allocMap.end(),
-					"Unable to find ptr " << static_cast<void*>(ptr));
-			size = it->second;
-			stats.m_allocCurrent.fetch_sub(it->second);
-			m_allocMap.erase(it);
+			const auto ret = m_allocMap.erase(ptr, size);
+			IRSTD_ASSERT(IrStdMemory, ret, "Unable to find ptr " << static_cast<void*>(ptr));
+		}
+		if (size & MemoryImpl::HeapProfiler::SAMPLED_FLAG)
+		{
+			size &= ~MemoryImpl::HeapProfiler::SAMPLED_FLAG;
+			m_profiler.recordFree(ptr, size);
+		}
+		const auto pCounters = getThreadCounters();
+		if (pCounters)
+		{
+			if (pCounters->remove(static_cast<int64_t>(size)))
+			{
+				updatePeak();
+			}
+		}
+		else
+		{
+			m_retiredCurrent.fetch_sub(static_cast<int64_t>(size));
+			m_retiredNbDelete++;
 		}
-		stats.m_allocNbDelete++;
 	}
-#endif
 
-	std::free(ptr);
-
-#if IS_MEMORY_MONITOR && defined(IRSTDMEMORY_DEBUG)
+#if defined(IRSTDMEMORY_DEBUG)
 	{
 		IRSTD_SCOPE(scope, IrStd::Flag::IrStdMemoryNoTrace);
 		if (scope.isActivator())
@@ -183,104 +609,59 @@ void IrStd::Memory::deleteImpl(void* ptr) noexcept
 		}
 	}
 #endif
+#else
+	(void) ptr;
+#endif
 }
 #pragma GCC diagnostic pop
 
-#if IRSTD_IS_PLATFORM(LINUX)
+// ---- IrStd::Memory::getSample ---------------------------------------------
 
-// ---- IrStd::Memory::getVirtualMemory* --------------------------------------
+IrStd::Memory::Sample IrStd::Memory::getSample() const noexcept
+{
+	return m_sampler.get();
+}
 
-IrStd::Type::Memory IrStd::Memory::getVirtualMemoryTotal() const noexcept
+void IrStd::Memory::setSamplingInterval(const uint64_t intervalMs) noexcept
+{
+	m_sampler.setInterval(intervalMs);
+}
+
+void IrStd::Memory::getSampleHistory(std::vector<Sample>& sampleList) const
 {
-	struct ::sysinfo memInfo;
-	::sysinfo(&memInfo);
-	IrStd::Type::Memory totalVirtualMem = memInfo.totalram;
+	m_sampler.getHistory(sampleList);
+}
 
-	totalVirtualMem += memInfo.totalswap;
-	totalVirtualMem *= memInfo.mem_unit;
+// ---- IrStd::Memory::getVirtualMemory* --------------------------------------
 
-	return totalVirtualMem;
+IrStd::Type::Memory IrStd::Memory::getVirtualMemoryTotal() const noexcept
+{
+	return getSample().m_virtualMemoryTotal;
 }
 
 IrStd::Type::Memory IrStd::Memory::getVirtualMemoryTotalUsed() const noexcept
 {
-	struct ::sysinfo memInfo;
-	::sysinfo(&memInfo);
-	IrStd::Type::Memory virtualMemUsed = memInfo.totalram - memInfo.freeram;
-
-	virtualMemUsed += memInfo.totalswap - memInfo.freeswap;
-	virtualMemUsed *= memInfo.mem_unit;
-
-	return virtualMemUsed;
+	return getSample().m_virtualMemoryTotalUsed;
 }
 
 IrStd::Type::Memory IrStd::Memory::getVirtualMemoryCurrent() const noexcept
 {
-	FILE* file = ::fopen("/proc/self/status", "r");
-	IrStd::Type::Memory result = 0;
-	char line[128];
-	if (file)
-	{
-		while (::fgets(line, 128, file) != NULL)
-		{
-			if (::strncmp(line, "VmSize:", 7) == 0)
-			{
-				const char* p = line;
-				while (*p <'0' || *p > '9') p++;
-				line[::strlen(line) - 3] = '\0';
-				result = ::atoi(p);
-				break;
-			}
-		}
-		::fclose(file);
-	}
-	return result;
+	return getSample().m_virtualMemoryCurrent;
 }
 
 // ---- IrStd::Memory::getRAM* ------------------------------------------------
 
 IrStd::Type::Memory IrStd::Memory::getRAMTotal() const noexcept
 {
-	struct ::sysinfo memInfo;
-	::sysinfo(&memInfo);
-	IrStd::Type::Memory totalVirtualMem = memInfo.totalram;
-
-	totalVirtualMem *= memInfo.mem_unit;
-
-	return totalVirtualMem;
+	return getSample().m_ramTotal;
 }
 
 IrStd::Type::Memory IrStd::Memory::getRAMTotalUsed() const noexcept
 {
-	struct ::sysinfo memInfo;
-	::sysinfo(&memInfo);
-	IrStd::Type::Memory virtualMemUsed = memInfo.totalram - memInfo.freeram;
-
-	virtualMemUsed *= memInfo.mem_unit;
-
-	return virtualMemUsed;
+	return getSample().m_ramTotalUsed;
 }
 
 IrStd::Type::Memory IrStd::Memory::getRAMCurrent() const noexcept
 {
-	FILE* file = ::fopen("/proc/self/status", "r");
-	IrStd::Type::Memory result = 0;
-	char line[128];
-	if (file)
-	{
-		while (::fgets(line, 128, file) != NULL)
-		{
-			if (::strncmp(line, "VmRSS:", 6) == 0)
-			{
-				const char* p = line;
-				while (*p <'0' || *p > '9') p++;
-				line[::strlen(line) - 3] = '\0';
-				result = ::atoi(p);
-				break;
-			}
-		}
-		::fclose(file);
-	}
-	return result;
+	return getSample().m_ramCurrent;
 }
-#endif
@@ -0,0 +1,226 @@
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+#include "Sampler.hpp"
+#include "../Compiler.hpp"
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/sysinfo.h>
+#endif
+
+namespace
+{
+	enum ValueIndex : size_t
+	{
+		TIMESTAMP = 0,
+		RAM_CURRENT,
+		RAM_TOTAL,
+		RAM_TOTAL_USED,
+		VIRTUAL_MEMORY_CURRENT,
+		VIRTUAL_MEMORY_TOTAL,
+		VIRTUAL_MEMORY_TOTAL_USED,
+		NB_VALUES
+	};
+
+	uint64_t getSteadyNs() noexcept
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	/**
+	 * Parse an unsigned decimal number and move the cursor after it
+	 */
+	uint64_t parseNumber(const char*& pCur, const char* const pEnd) noexcept
+	{
+		while (pCur < pEnd && (*pCur < '0' || *pCur > '9'))
+		{
+			pCur++;
+		}
+		uint64_t value = 0;
+		while (pCur < pEnd && *pCur >= '0' && *pCur <= '9')
+		{
+			value = value * 10 + static_cast<uint64_t>(*pCur - '0');
+			pCur++;
+		}
+		return value;
+	}
+}
+
+// ---- IrStd::MemoryImpl::Sampler --------------------------------------------
+
+constexpr size_t IrStd::MemoryImpl::Sampler::HISTORY_SIZE;
+constexpr uint64_t IrStd::MemoryImpl::Sampler::DEFAULT_INTERVAL_MS;
+
+IrStd::MemoryImpl::Sampler::Sampler() noexcept
+		: m_intervalNs(DEFAULT_INTERVAL_MS * 1000000)
+		, m_nextRefreshNs(0)
+		, m_fd(-1)
+		, m_pageSize(4096)
+		, m_nbSamples(0)
+{
+	static_assert(NB_VALUES == sizeof(m_slotList[0].m_valueList) / sizeof(m_slotList[0].m_valueList[0]),
+			"The number of values does not match the slot");
+
+	m_refreshLock.clear();
+	for (auto& slot : m_slotList)
+	{
+		slot.m_sequence.store(0, std::memory_order_relaxed);
+		for (auto& value : slot.m_valueList)
+		{
+			value.store(0, std::memory_order_relaxed);
+		}
+	}
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	m_fd = ::open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+	const long pageSize = ::sysconf(_SC_PAGESIZE);
+	m_pageSize = (pageSize > 0) ? static_cast<size_t>(pageSize) : 4096;
+#endif
+}
+
+IrStd::MemoryImpl::Sampler::~Sampler()
+{
+#if IRSTD_IS_PLATFORM(LINUX)
+	if (m_fd != -1)
+	{
+		::close(m_fd);
+	}
+#endif
+}
+
+void IrStd::MemoryImpl::Sampler::setInterval(const uint64_t intervalMs) noexcept
+{
+	m_intervalNs.store(intervalMs * 1000000);
+	// Force a refresh on the next read
+	m_nextRefreshNs.store(0);
+}
+
+void IrStd::MemoryImpl::Sampler::refresh() noexcept
+{
+	uint64_t valueList[NB_VALUES] = {0};
+	valueList[TIMESTAMP] = IrStd::Type::Timestamp::now();
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	// statm format: size resident shared text lib data dt (in pages)
+	if (m_fd != -1)
+	{
+		char buffer[128];
+		const auto nbBytes = ::pread(m_fd, buffer, sizeof(buffer), 0);
+		if (nbBytes > 0)
+		{
+			const char* pCur = buffer;
+			const char* const pEnd = buffer + nbBytes;
+			valueList[VIRTUAL_MEMORY_CURRENT] = parseNumber(pCur, pEnd) * m_pageSize;
+			valueList[RAM_CURRENT] = parseNumber(pCur, pEnd) * m_pageSize;
+		}
+	}
+
+	{
+		struct ::sysinfo memInfo;
+		if (::sysinfo(&memInfo) == 0)
+		{
+			const uint64_t unit = memInfo.mem_unit;
+			valueList[RAM_TOTAL] = memInfo.totalram * unit;
+			valueList[RAM_TOTAL_USED] = (memInfo.totalram - memInfo.freeram) * unit;
+			valueList[VIRTUAL_MEMORY_TOTAL] = (memInfo.totalram + memInfo.totalswap) * unit;
+			valueList[VIRTUAL_MEMORY_TOTAL_USED] = (memInfo.totalram - memInfo.freeram
+					+ memInfo.totalswap - memInfo.freeswap) * unit;
+		}
+	}
+#endif
+
+	// Write the next slot
+	const uint64_t nbSamples = m_nbSamples.load(std::memory_order_relaxed);
+	Slot& slot = m_slotList[nbSamples % HISTORY_SIZE];
+	const uint64_t sequence = slot.m_sequence.load(std::memory_order_relaxed);
+	slot.m_sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	for (size_t i = 0; i < NB_VALUES; ++i)
+	{
+		slot.m_valueList[i].store(valueList[i], std::memory_order_relaxed);
+	}
+	slot.m_sequence.store(sequence + 2, std::memory_order_release);
+	m_nbSamples.store(nbSamples + 1, std::memory_order_release);
+}
+
+bool IrStd::MemoryImpl::Sampler::read(const Slot& slot, Sample& sample) const noexcept
+{
+	uint64_t valueList[NB_VALUES];
+	const uint64_t sequence = slot.m_sequence.load(std::memory_order_acquire);
+	if (sequence & 1)
+	{
+		return false;
+	}
+	for (size_t i = 0; i < NB_VALUES; ++i)
+	{
+		valueList[i] = slot.m_valueList[i].load(std::memory_order_relaxed);
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (slot.m_sequence.load(std::memory_order_relaxed) != sequence)
+	{
+		return false;
+	}
+
+	sample.m_timestamp = valueList[TIMESTAMP];
+	sample.m_ramCurrent = valueList[RAM_CURRENT];
+	sample.m_ramTotal = valueList[RAM_TOTAL];
+	sample.m_ramTotalUsed = valueList[RAM_TOTAL_USED];
+	sample.m_virtualMemoryCurrent = valueList[VIRTUAL_MEMORY_CURRENT];
+	sample.m_virtualMemoryTotal = valueList[VIRTUAL_MEMORY_TOTAL];
+	sample.m_virtualMemoryTotalUsed = valueList[VIRTUAL_MEMORY_TOTAL_USED];
+
+	return true;
+}
+
+IrStd::MemoryImpl::Sampler::Sample IrStd::MemoryImpl::Sampler::get() noexcept
+{
+	// Only one reader refreshes the sample, the others use the previous one
+	const uint64_t now = getSteadyNs();
+	if (now >= m_nextRefreshNs.load(std::memory_order_relaxed)
+			&& !m_refreshLock.test_and_set(std::memory_order_acquire))
+	{
+		if (now >= m_nextRefreshNs.load(std::memory_order_relaxed))
+		{
+			refresh();
+			m_nextRefreshNs.store(now + m_intervalNs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+		m_refreshLock.clear(std::memory_order_release);
+	}
+
+	// Wait for the first sample if there is none yet
+	while (!m_nbSamples.load(std::memory_order_acquire))
+	{
+		std::this_thread::yield();
+	}
+
+	Sample sample;
+	for (;;)
+	{
+		const uint64_t nbSamples = m_nbSamples.load(std::memory_order_acquire);
+		if (read(m_slotList[(nbSamples - 1) % HISTORY_SIZE], sample))
+		{
+			return sample;
+		}
+	}
+}
+
+void IrStd::MemoryImpl::Sampler::getHistory(std::vector<Sample>& sampleList) const
+{
+	sampleList.clear();
+	const uint64_t nbSamples = m_nbSamples.load(std::memory_order_acquire);
+	const uint64_t first = (nbSamples > HISTORY_SIZE) ? nbSamples - HISTORY_SIZE : 0;
+	sampleList.reserve(static_cast<size_t>(nbSamples - first));
+	for (uint64_t i = first; i < nbSamples; ++i)
+	{
+		Sample sample;
+		// Samples being overwritten are skipped
+		if (read(m_slotList[i % HISTORY_SIZE], sample))
+		{
+			sampleList.push_back(sample);
+		}
+	}
+}
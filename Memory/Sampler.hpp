@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../Type/Memory.hpp"
+#include "../Type/Timestamp.hpp"
+
+namespace IrStd
+{
+	namespace MemoryImpl
+	{
+		/**
+		 * \brief Cached sampler of the process and system memory usage
+		 *
+		 * The values are refreshed at most once per interval by the first reader
+		 * noticing that the current sample is outdated, the other readers return
+		 * the cached values without any system call nor lock.
+		 *
+		 * The process memory is read from /proc/self/statm through a file
+		 * descriptor kept open, the system memory is read with sysinfo.
+		 * The latest samples are kept in a ring buffer to show the memory trend.
+		 */
+		class Sampler
+		{
+		public:
+			struct Sample
+			{
+				IrStd::Type::Timestamp m_timestamp;
+				IrStd::Type::Memory m_ramCurrent;
+				IrStd::Type::Memory m_ramTotal;
+				IrStd::Type::Memory m_ramTotalUsed;
+				IrStd::Type::Memory m_virtualMemoryCurrent;
+				IrStd::Type::Memory m_virtualMemoryTotal;
+				IrStd::Type::Memory m_virtualMemoryTotalUsed;
+			};
+
+			/**
+			 * Number of samples kept in the history
+			 */
+			static constexpr size_t HISTORY_SIZE = 64;
+			static constexpr uint64_t DEFAULT_INTERVAL_MS = 100;
+
+			Sampler() noexcept;
+			~Sampler();
+
+			Sampler(const Sampler&) = delete;
+			Sampler& operator=(const Sampler&) = delete;
+
+			/**
+			 * \brief Minimum time between 2 samples, 0 to sample on every read
+			 */
+			void setInterval(const uint64_t intervalMs) noexcept;
+
+			/**
+			 * \brief Get the latest sample, refresh it if outdated
+			 */
+			Sample get() noexcept;
+
+			/**
+			 * \brief Copy the samples of the history, from the oldest to the latest
+			 */
+			void getHistory(std::vector<Sample>& sampleList) const;
+
+		private:
+			/**
+			 * Samples are protected by a sequence number, odd while being written
+			 */
+			struct Slot
+			{
+				std::atomic<uint64_t> m_sequence;
+				std::atomic<uint64_t> m_valueList[7];
+			};
+
+			bool read(const Slot& slot, Sample& sample) const noexcept;
+			void refresh() noexcept;
+
+			std::atomic<uint64_t> m_intervalNs;
+			std::atomic<uint64_t> m_nextRefreshNs;
+			std::atomic_flag m_refreshLock;
+			int m_fd;
+			size_t m_pageSize;
+
+			// Total number of samples taken, the latest is at (m_nbSamples - 1) % HISTORY_SIZE
+			std::atomic<uint64_t> m_nbSamples;
+			Slot m_slotList[HISTORY_SIZE];
+		};
+	}
+}
@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "Snapshot.hpp"
+#include "../Exception.hpp"
+#include "../Type/Memory.hpp"
+
+namespace
+{
+	struct Record
+	{
+		void* m_ptr;
+		size_t m_size;
+		size_t m_stack;
+	};
+	typedef std::vector<Record, IrStd::AllocatorObj<Record, IrStd::AllocatorRaw>> RecordList;
+
+	struct Difference
+	{
+		const IrStd::MemoryImpl::Snapshot::Group* m_pGroup;
+		int64_t m_count;
+	};
+	typedef std::vector<Difference, IrStd::AllocatorObj<Difference, IrStd::AllocatorRaw>> DifferenceList;
+
+	uint64_t getBytes(const IrStd::MemoryImpl::Snapshot::Group& group) noexcept
+	{
+		return static_cast<uint64_t>(group.m_size) * group.m_count;
+	}
+
+	void streamSigned(std::ostream& out, const int64_t value)
+	{
+		out << ((value < 0) ? "-" : "+") << IrStd::Type::Memory(static_cast<uint64_t>((value < 0) ? -value : value));
+	}
+}
+
+// ---- IrStd::MemoryImpl::Snapshot -------------------------------------------
+
+constexpr size_t IrStd::MemoryImpl::Snapshot::DEFAULT_MAX_GROUPS;
+
+IrStd::MemoryImpl::Snapshot::Snapshot() noexcept
+		: m_nbBlocks(0)
+		, m_bytes(0)
+{
+}
+
+int IrStd::MemoryImpl::Snapshot::compare(const Group& a, const Group& b) noexcept
+{
+	if (a.m_size != b.m_size)
+	{
+		return (a.m_size < b.m_size) ? -1 : 1;
+	}
+	if (a.m_depth != b.m_depth)
+	{
+		return (a.m_depth < b.m_depth) ? -1 : 1;
+	}
+	return std::memcmp(a.m_addressList, b.m_addressList, a.m_depth * sizeof(void*));
+}
+
+void IrStd::MemoryImpl::Snapshot::collect(const AllocMap& allocMap, const HeapProfiler& profiler)
+{
+	m_groupList.clear();
+	m_nbBlocks = 0;
+	m_bytes = 0;
+
+	// Copy the entries first, the profiler cannot be queried while a shard is locked
+	RecordList recordList;
+	recordList.reserve(allocMap.size() + allocMap.size() / 8);
+	allocMap.each([&recordList](void* const ptr, const size_t size) {
+		// Entries added after the reservation are ignored, the allocator must not be re-entered
+		if (recordList.size() < recordList.capacity())
+		{
+			recordList.push_back(Record{ptr, size, HeapProfiler::NO_STACK});
+		}
+	});
+
+	for (auto& record : recordList)
+	{
+		if (record.m_size & HeapProfiler::SAMPLED_FLAG)
+		{
+			record.m_size &= ~HeapProfiler::SAMPLED_FLAG;
+			record.m_stack = profiler.findStack(record.m_ptr);
+		}
+	}
+
+	// Group the records sharing the same stack and size
+	std::sort(recordList.begin(), recordList.end(), [](const Record& a, const Record& b) {
+		return (a.m_stack != b.m_stack) ? (a.m_stack < b.m_stack) : (a.m_size < b.m_size);
+	});
+	for (size_t i = 0; i < recordList.size();)
+	{
+		const Record& record = recordList[i];
+		Group group;
+		group.m_size = record.m_size;
+		group.m_count = 0;
+		group.m_depth = (record.m_stack == HeapProfiler::NO_STACK) ? 0 : profiler.copyStack(record.m_stack, group.m_addressList);
+		for (; i < recordList.size() && recordList[i].m_stack == record.m_stack && recordList[i].m_size == record.m_size; ++i)
+		{
+			++group.m_count;
+		}
+		m_nbBlocks += group.m_count;
+		m_bytes += ::getBytes(group);
+		m_groupList.push_back(group);
+	}
+
+	// Stacks that could not be resolved are merged with the groups without stack
+	std::sort(m_groupList.begin(), m_groupList.end(), [](const Group& a, const Group& b) {
+		return compare(a, b) < 0;
+	});
+	size_t last = 0;
+	for (size_t i = 1; i < m_groupList.size(); ++i)
+	{
+		if (compare(m_groupList[last], m_groupList[i]) == 0)
+		{
+			m_groupList[last].m_count += m_groupList[i].m_count;
+		}
+		else
+		{
+			m_groupList[++last] = m_groupList[i];
+		}
+	}
+	if (!m_groupList.empty())
+	{
+		m_groupList.resize(last + 1);
+	}
+}
+
+void IrStd::MemoryImpl::Snapshot::removeUntraced() noexcept
+{
+	const auto it = std::remove_if(m_groupList.begin(), m_groupList.end(), [this](const Group& group) {
+		if (group.m_depth)
+		{
+			return false;
+		}
+		m_nbBlocks -= group.m_count;
+		m_bytes -= ::getBytes(group);
+		return true;
+	});
+	m_groupList.erase(it, m_groupList.end());
+}
+
+uint64_t IrStd::MemoryImpl::Snapshot::getNbBlocks() const noexcept
+{
+	return m_nbBlocks;
+}
+
+uint64_t IrStd::MemoryImpl::Snapshot::getBytes() const noexcept
+{
+	return m_bytes;
+}
+
+const IrStd::MemoryImpl::Snapshot::GroupList& IrStd::MemoryImpl::Snapshot::getGroupList() const noexcept
+{
+	return m_groupList;
+}
+
+void IrStd::MemoryImpl::Snapshot::dumpStack(std::ostream& out, const Group& group)
+{
+	if (!group.m_depth)
+	{
+		out << "    [no call stack]\n";
+	}
+	for (size_t level = 0; level < group.m_depth; ++level)
+	{
+		out << "    at ";
+		Exception::functionName(out, group.m_addressList[level]);
+		out << "\n";
+	}
+}
+
+void IrStd::MemoryImpl::Snapshot::dump(std::ostream& out, const size_t maxGroups) const
+{
+	DifferenceList list;
+	list.reserve(m_groupList.size());
+	for (const auto& group : m_groupList)
+	{
+		list.push_back(Difference{&group, static_cast<int64_t>(group.m_count)});
+	}
+	std::sort(list.begin(), list.end(), [](const Difference& a, const Difference& b) {
+		return ::getBytes(*a.m_pGroup) > ::getBytes(*b.m_pGroup);
+	});
+
+	out << std::dec << m_nbBlocks << " block(s) alive using " << IrStd::Type::Memory(m_bytes)
+			<< ", in " << m_groupList.size() << " group(s)\n";
+	for (size_t i = 0; i < list.size() && i < maxGroups; ++i)
+	{
+		const Group& group = *list[i].m_pGroup;
+		out << std::dec << "#" << (i + 1) << " " << group.m_count << " x " << group.m_size
+				<< " byte(s) = " << IrStd::Type::Memory(::getBytes(group)) << "\n";
+		dumpStack(out, group);
+	}
+	if (list.size() > maxGroups)
+	{
+		out << std::dec << "... " << (list.size() - maxGroups) << " more group(s)\n";
+	}
+}
+
+void IrStd::MemoryImpl::Snapshot::dumpDiff(std::ostream& out, const Snapshot& before, const Snapshot& after,
+		const size_t maxGroups)
+{
+	// Both lists are ordered, walk through them at once
+	DifferenceList list;
+	auto itBefore = before.m_groupList.begin();
+	auto itAfter = after.m_groupList.begin();
+	while (itBefore != before.m_groupList.end() || itAfter != after.m_groupList.end())
+	{
+		const int order = (itBefore == before.m_groupList.end()) ? 1
+				: (itAfter == after.m_groupList.end()) ? -1 : compare(*itBefore, *itAfter);
+		if (order < 0)
+		{
+			list.push_back(Difference{&*itBefore, -static_cast<int64_t>(itBefore->m_count)});
+			++itBefore;
+		}
+		else if (order > 0)
+		{
+			list.push_back(Difference{&*itAfter, static_cast<int64_t>(itAfter->m_count)});
+			++itAfter;
+		}
+		else
+		{
+			const int64_t count = static_cast<int64_t>(itAfter->m_count) - static_cast<int64_t>(itBefore->m_count);
+			if (count)
+			{
+				list.push_back(Difference{&*itAfter, count});
+			}
+			++itBefore;
+			++itAfter;
+		}
+	}
+	std::sort(list.begin(), list.end(), [](const Difference& a, const Difference& b) {
+		return std::abs(a.m_count * static_cast<int64_t>(a.m_pGroup->m_size))
+				> std::abs(b.m_count * static_cast<int64_t>(b.m_pGroup->m_size));
+	});
+
+	const int64_t nbBlocks = static_cast<int64_t>(after.m_nbBlocks - before.m_nbBlocks);
+	out << std::dec << ((nbBlocks < 0) ? "" : "+") << nbBlocks << " block(s) alive, ";
+	streamSigned(out, static_cast<int64_t>(after.m_bytes - before.m_bytes));
+	out << std::dec << ", in " << list.size() << " group(s) changed\n";
+	for (size_t i = 0; i < list.size() && i < maxGroups; ++i)
+	{
+		const Group& group = *list[i].m_pGroup;
+		out << std::dec << "#" << (i + 1) << " " << ((list[i].m_count < 0) ? "" : "+") << list[i].m_count
+				<< " x " << group.m_size << " byte(s) = ";
+		streamSigned(out, list[i].m_count * static_cast<int64_t>(group.m_size));
+		out << "\n";
+		dumpStack(out, group);
+	}
+	if (list.size() > maxGroups)
+	{
+		out << std::dec << "... " << (list.size() - maxGroups) << " more group(s)\n";
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "../Allocator.hpp"
+#include "AllocMap.hpp"
+#include "HeapProfiler.hpp"
+
+namespace IrStd
+{
+	namespace MemoryImpl
+	{
+		/**
+		 * \brief Live allocations grouped by call stack and size
+		 *
+		 * The call stack is only known for the allocations sampled by the heap
+		 * profiler, the others are grouped by size only. Starting the profiler
+		 * with a sample interval of 1 traces every allocation.
+		 *
+		 * \note The groups are allocated with malloc directly, so that a
+		 * snapshot does not appear in the next ones.
+		 */
+		class Snapshot
+		{
+		public:
+			struct Group
+			{
+				size_t m_size;
+				uint64_t m_count;
+				// Depth is 0 if the call stack is unknown
+				size_t m_depth;
+				void* m_addressList[HeapProfiler::MAX_DEPTH];
+			};
+			typedef std::vector<Group, AllocatorObj<Group, AllocatorRaw>> GroupList;
+
+			static constexpr size_t DEFAULT_MAX_GROUPS = 20;
+
+			Snapshot() noexcept;
+
+			/**
+			 * \brief Replace the content with the live allocations of a map
+			 */
+			void collect(const AllocMap& allocMap, const HeapProfiler& profiler);
+
+			/**
+			 * \brief Drop the groups without call stack
+			 *
+			 * When every allocation is traced, these are the blocks allocated
+			 * before the profiler started, such as the singletons.
+			 */
+			void removeUntraced() noexcept;
+
+			uint64_t getNbBlocks() const noexcept;
+			uint64_t getBytes() const noexcept;
+
+			/**
+			 * \brief Groups, ordered by size and call stack
+			 */
+			const GroupList& getGroupList() const noexcept;
+
+			/**
+			 * \brief Write the groups using the most memory first
+			 */
+			void dump(std::ostream& out, const size_t maxGroups = DEFAULT_MAX_GROUPS) const;
+
+			/**
+			 * \brief Write the groups which changed the most between two snapshots
+			 */
+			static void dumpDiff(std::ostream& out, const Snapshot& before, const Snapshot& after,
+					const size_t maxGroups = DEFAULT_MAX_GROUPS);
+
+		private:
+			static int compare(const Group& a, const Group& b) noexcept;
+			static void dumpStack(std::ostream& out, const Group& group);
+
+			GroupList m_groupList;
+			uint64_t m_nbBlocks;
+			uint64_t m_bytes;
+		};
+	}
+}
@@ -1,18 +1,32 @@
 #pragma once
 
-#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
 
 #include "Assert.hpp"
 
 namespace IrStd
 {
+	/**
+	 * \brief Reader-writer lock, optimized for read-mostly data
+	 *
+	 * Readers are counted on stripes, each on its own cache line, so that
+	 * readers from different threads do not write to the same memory. A read
+	 * scope is an atomic increment and a load when no writer is around.
+	 *
+	 * Writers have the preference: once a writer is waiting, new readers back
+	 * off until it is done, and the writer waits for the readers already in to
+	 * leave. Threads sleep on futexes when they have to wait.
+	 *
+	 * \note A thread holding a read scope must not take another one, it would
+	 * deadlock with a writer waiting in between.
+	 */
 	class RWLock
 	{
 	public:
-		RWLock()
-				: m_counter(0)
-		{
-		};
+		RWLock() noexcept;
 
 		class Scope
 		{
@@ -37,21 +51,21 @@ namespace IrStd
 		class ReaderScope : public Scope
 		{
 		public:
-			ReaderScope(RWLock& lock)
+			ReaderScope(RWLock& lock, const size_t stripe)
 					: Scope(lock)
+					, m_stripe(stripe)
 			{
 			}
 			ReaderScope(ReaderScope&& scope)
 					: Scope(std::move(scope))
+					, m_stripe(scope.m_stripe)
 			{
 			}
 			void release()
 			{
 				if (m_owner)
 				{
-					std::unique_lock<std::mutex> lock(m_lock.m_mutex);
-					m_lock.m_counter--;
-					m_lock.m_conditionVariable.notify_all();
+					m_lock.readUnlock(m_stripe);
 					m_owner = false;
 				}
 			}
@@ -59,6 +73,10 @@ namespace IrStd
 			{
 				release();
 			}
+
+		private:
+			// The reader is counted on this stripe, whichever thread releases it
+			const size_t m_stripe;
 		};
 
 		class WriterScope : public Scope
@@ -76,9 +94,7 @@ namespace IrStd
 			{
 				if (m_owner)
 				{
-					std::unique_lock<std::mutex> lock(m_lock.m_mutex);
-					m_lock.m_counter++;
-					m_lock.m_conditionVariable.notify_all();
+					m_lock.writeUnlock();
 					m_owner = false;
 				}
 			}
@@ -90,80 +106,102 @@ namespace IrStd
 
 		ReaderScope readScope()
 		{
-			std::unique_lock<std::mutex> lock(m_mutex);
-
-			IRSTD_ASSERT(m_counter.load() >= -1);
+			const size_t stripe = getStripe();
+			auto& nbReaders = m_stripeList[stripe].m_nbReaders;
 
-			// Get out of this loop only if m_counter > 0
+			// Fast path, no writer around
+			nbReaders.fetch_add(1, std::memory_order_seq_cst);
+			if (!(m_state.load(std::memory_order_seq_cst) & WRITER))
 			{
-				int64_t expected;
-				do
-				{
-					m_conditionVariable.wait(lock, [&]() {
-						expected = m_counter.load();
-						return (expected >= 0);
-					});
-				} while (!m_counter.compare_exchange_strong(expected, expected + 1));
+				return ReaderScope(*this, stripe);
 			}
+			readLockSlow(stripe);
 
 			IRSTD_ASSERT(isReadScope());
 
-			return std::move(ReaderScope(*this));
+			return ReaderScope(*this, stripe);
 		}
 
 		WriterScope writeScope()
 		{
-			std::unique_lock<std::mutex> lock(m_mutex);
-
-			IRSTD_ASSERT(m_counter.load() >= -1);
-
-			// Make sure only 1 write is here at a time
-			{
-				int64_t expected;
-				do
-				{
-					expected = 0;
-					m_conditionVariable.wait(lock, [&]() {
-						return (m_counter.load() == 0);
-					});
-				} while (!m_counter.compare_exchange_strong(expected, -1));
-			}
+			writeLock();
 
 			IRSTD_ASSERT(isWriteScope());
 
-			return std::move(WriterScope(*this));
+			return WriterScope(*this);
 		}
 
+		/**
+		 * \brief Whether a writer holds the lock, or is waiting for it
+		 */
 		bool isWriteScope() const noexcept
 		{
-			return (m_counter.load() == -1);
+			return (m_state.load() & WRITER) != 0;
 		}
 
 		bool isReadScope() const noexcept
 		{
-			return (m_counter.load() > 0);
+			return (getNbReaders() > 0);
 		}
 
 		bool isScope() const noexcept
 		{
-			return (m_counter.load() != 0);
+			return (isWriteScope() || isReadScope());
 		}
 
 		// For testing purpose
+		// -1 = 1 write
+		// 0 = nothing
+		// >0 = multiple readers
 		int64_t getCounter() const noexcept
 		{
-			return m_counter.load();
+			return (isWriteScope()) ? -1 : getNbReaders();
 		}
 
 	private:
 		friend ReaderScope;
 		friend WriterScope;
 
-		std::mutex m_mutex;
-		// -1 = 1 write
-		// 0 = nothing
-		// >0 = multiple readers
-		std::atomic<int64_t> m_counter;
-		std::condition_variable m_conditionVariable;
+		static constexpr size_t NB_STRIPES = 16;
+		// Bits of m_state
+		static constexpr uint32_t WRITER = 1;
+		static constexpr uint32_t WAITERS = 2;
+
+		// Stripes are aligned on a cache line to avoid false sharing
+		struct alignas(64) Stripe
+		{
+			std::atomic<int64_t> m_nbReaders;
+		};
+
+		/**
+		 * Stripe of the calling thread, threads are spread over the stripes
+		 */
+		static size_t getStripe() noexcept;
+
+		int64_t getNbReaders() const noexcept;
+
+		/**
+		 * Back off while a writer is around, and count the reader again
+		 */
+		void readLockSlow(const size_t stripe) noexcept;
+		void readUnlock(const size_t stripe) noexcept
+		{
+			m_stripeList[stripe].m_nbReaders.fetch_sub(1, std::memory_order_seq_cst);
+			// A writer might be waiting for the readers to leave
+			if (m_state.load(std::memory_order_seq_cst) & WRITER)
+			{
+				wakeWriter();
+			}
+		}
+		void wakeWriter() noexcept;
+
+		void writeLock() noexcept;
+		void writeUnlock() noexcept;
+
+		Stripe m_stripeList[NB_STRIPES];
+		// Writer flag, threads waiting for the writer sleep on it
+		std::atomic<uint32_t> m_state;
+		// Bumped by readers leaving, the writer waiting for them sleeps on it
+		std::atomic<uint32_t> m_drainEpoch;
 	};
 }
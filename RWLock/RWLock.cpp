@@ -0,0 +1,151 @@
+#include <climits>
+#include <thread>
+
+#include "../RWLock.hpp"
+#include "../Compiler.hpp"
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	#include <unistd.h>
+	#include <linux/futex.h>
+	#include <sys/syscall.h>
+#endif
+
+namespace
+{
+	// Spins of a writer waiting for the readers, before sleeping
+	constexpr size_t DRAIN_SPIN_COUNT = 64;
+
+	void wait(std::atomic<uint32_t>& value, const uint32_t expected) noexcept
+	{
+#if IRSTD_IS_PLATFORM(LINUX)
+		::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&value), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+		if (value.load() == expected)
+		{
+			std::this_thread::yield();
+		}
+#endif
+	}
+
+	void wake(std::atomic<uint32_t>& value, const int nbThreads) noexcept
+	{
+#if IRSTD_IS_PLATFORM(LINUX)
+		::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&value), FUTEX_WAKE_PRIVATE, nbThreads, nullptr, nullptr, 0);
+#else
+		(void) value;
+		(void) nbThreads;
+#endif
+	}
+}
+
+// ---- IrStd::RWLock ---------------------------------------------------------
+
+constexpr size_t IrStd::RWLock::NB_STRIPES;
+constexpr uint32_t IrStd::RWLock::WRITER;
+constexpr uint32_t IrStd::RWLock::WAITERS;
+
+IrStd::RWLock::RWLock() noexcept
+		: m_state(0)
+		, m_drainEpoch(0)
+{
+	for (auto& stripe : m_stripeList)
+	{
+		stripe.m_nbReaders = 0;
+	}
+}
+
+size_t IrStd::RWLock::getStripe() noexcept
+{
+	static std::atomic<size_t> nextStripe(0);
+	static thread_local const size_t stripe = nextStripe.fetch_add(1, std::memory_order_relaxed) % NB_STRIPES;
+	return stripe;
+}
+
+int64_t IrStd::RWLock::getNbReaders() const noexcept
+{
+	int64_t nbReaders = 0;
+	for (const auto& stripe : m_stripeList)
+	{
+		nbReaders += stripe.m_nbReaders.load(std::memory_order_seq_cst);
+	}
+	return nbReaders;
+}
+
+void IrStd::RWLock::readLockSlow(const size_t stripe) noexcept
+{
+	auto& nbReaders = m_stripeList[stripe].m_nbReaders;
+	do
+	{
+		// Leave, so that the writer does not wait for this reader
+		readUnlock(stripe);
+
+		uint32_t state = m_state.load(std::memory_order_seq_cst);
+		while (state & WRITER)
+		{
+			// Let the writer know that it must wake up the waiters
+			if (!(state & WAITERS) && !m_state.compare_exchange_weak(state, state | WAITERS))
+			{
+				continue;
+			}
+			wait(m_state, state | WAITERS);
+			state = m_state.load(std::memory_order_seq_cst);
+		}
+
+		nbReaders.fetch_add(1, std::memory_order_seq_cst);
+	} while (m_state.load(std::memory_order_seq_cst) & WRITER);
+}
+
+void IrStd::RWLock::wakeWriter() noexcept
+{
+	m_drainEpoch.fetch_add(1, std::memory_order_seq_cst);
+	wake(m_drainEpoch, 1);
+}
+
+void IrStd::RWLock::writeLock() noexcept
+{
+	// Only one writer at a time
+	uint32_t waiters = 0;
+	for (;;)
+	{
+		uint32_t state = m_state.load(std::memory_order_seq_cst);
+		if (!(state & WRITER))
+		{
+			// A writer which slept cannot tell whether others still do
+			if (m_state.compare_exchange_weak(state, WRITER | waiters, std::memory_order_seq_cst))
+			{
+				break;
+			}
+			continue;
+		}
+		if (!(state & WAITERS) && !m_state.compare_exchange_weak(state, state | WAITERS))
+		{
+			continue;
+		}
+		wait(m_state, state | WAITERS);
+		waiters = WAITERS;
+	}
+
+	// New readers back off from now on, wait for the ones already in
+	for (size_t spin = 0; ; ++spin)
+	{
+		const uint32_t epoch = m_drainEpoch.load(std::memory_order_seq_cst);
+		if (!getNbReaders())
+		{
+			break;
+		}
+		if (spin < DRAIN_SPIN_COUNT)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		wait(m_drainEpoch, epoch);
+	}
+}
+
+void IrStd::RWLock::writeUnlock() noexcept
+{
+	if (m_state.exchange(0, std::memory_order_seq_cst) & WAITERS)
+	{
+		wake(m_state, INT_MAX);
+	}
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace IrStd
+{
+	namespace RcuImpl
+	{
+		/**
+		 * Reading state of a thread
+		 */
+		struct Record;
+
+		/**
+		 * \brief Mark the calling thread as reading, scopes can be nested
+		 *
+		 * The thread records the current epoch, writers do not reclaim what
+		 * was retired since, until the thread leaves.
+		 *
+		 * \return The record of the calling thread, to pass to \ref leave.
+		 */
+		Record* enter() noexcept;
+		void leave(Record* const pRecord) noexcept;
+
+		/**
+		 * Move to the next epoch and return the previous one
+		 */
+		uint64_t advance() noexcept;
+
+		/**
+		 * Oldest epoch recorded by a thread reading, UINT64_MAX if none
+		 */
+		uint64_t getMinActiveEpoch() noexcept;
+	}
+
+	/**
+	 * \brief Pointer-published structure, read without lock
+	 *
+	 * Readers access the current version within a read scope. Writers build
+	 * a new version and publish it; the previous one is retired and deleted
+	 * once all the readers which could have seen it are gone (epoch-based
+	 * reclamation). Reading is a store to a thread-local record and a load,
+	 * readers never wait.
+	 *
+	 * Writers are serialized with a mutex, they are meant to be rare.
+	 */
+	template<class T>
+	class Rcu
+	{
+	public:
+		/**
+		 * \brief Access to a version of the value
+		 *
+		 * The version stays valid until the scope is released, even if a new
+		 * one is published in the meantime.
+		 *
+		 * \note A scope can be moved, but it must be released by the thread
+		 * which created it.
+		 */
+		class ReadScope
+		{
+		public:
+			explicit ReadScope(const Rcu& rcu) noexcept
+					: m_pRecord(RcuImpl::enter())
+			{
+				m_pValue = rcu.m_pValue.load(std::memory_order_acquire);
+			}
+			ReadScope(const ReadScope& scope) = delete;
+			ReadScope(ReadScope&& scope) noexcept
+					: m_pValue(scope.m_pValue)
+					, m_pRecord(scope.m_pRecord)
+			{
+				scope.m_pRecord = nullptr;
+			}
+			~ReadScope()
+			{
+				release();
+			}
+			void release() noexcept
+			{
+				if (m_pRecord)
+				{
+					RcuImpl::leave(m_pRecord);
+					m_pRecord = nullptr;
+				}
+			}
+			const T& operator*() const noexcept
+			{
+				return *m_pValue;
+			}
+			const T* operator->() const noexcept
+			{
+				return m_pValue;
+			}
+			const T* get() const noexcept
+			{
+				return m_pValue;
+			}
+
+		private:
+			const T* m_pValue;
+			// Record entered by this scope, nullptr once released
+			RcuImpl::Record* m_pRecord;
+		};
+
+		explicit Rcu(const T& value = T())
+				: m_pValue(new T(value))
+		{
+		}
+
+		Rcu(const Rcu&) = delete;
+		Rcu& operator=(const Rcu&) = delete;
+
+		/**
+		 * No reader can access the structure anymore, the versions are all deleted
+		 */
+		~Rcu()
+		{
+			for (const auto& retired : m_retiredList)
+			{
+				delete retired.m_pValue;
+			}
+			delete m_pValue.load();
+		}
+
+		ReadScope read() const noexcept
+		{
+			return ReadScope(*this);
+		}
+
+		/**
+		 * \brief Publish a new version
+		 */
+		void publish(const T& value)
+		{
+			std::unique_ptr<T> pValue(new T(value));
+			std::lock_guard<std::mutex> lock(m_mutex);
+			replace(std::move(pValue));
+		}
+
+		/**
+		 * \brief Publish a modified copy of the current version
+		 *
+		 * \param fct Function modifying the copy, called with T&.
+		 */
+		template<class F>
+		void update(F&& fct)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			std::unique_ptr<T> pValue(new T(*m_pValue.load(std::memory_order_relaxed)));
+			fct(*pValue);
+			replace(std::move(pValue));
+		}
+
+		/**
+		 * \brief Wait until all the retired versions are deleted
+		 *
+		 * \note This must not be called from a read scope, it would wait for itself.
+		 */
+		void synchronize()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			while (!m_retiredList.empty())
+			{
+				if (!reclaim())
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		// For testing purpose
+		size_t getNbRetired() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_retiredList.size();
+		}
+
+	private:
+		struct Retired
+		{
+			const T* m_pValue;
+			// Epoch at which it was replaced
+			uint64_t m_epoch;
+		};
+
+		/**
+		 * Publish a version and retire the current one, the lock must be held
+		 */
+		void replace(std::unique_ptr<T>&& pValue)
+		{
+			m_retiredList.reserve(m_retiredList.size() + 1);
+			const T* const pPrevious = m_pValue.exchange(pValue.release(), std::memory_order_seq_cst);
+			m_retiredList.push_back(Retired{pPrevious, RcuImpl::advance()});
+			reclaim();
+		}
+
+		/**
+		 * Delete the versions no reader can access anymore, the lock must be held
+		 *
+		 * \return true if at least one version was deleted.
+		 */
+		bool reclaim() noexcept
+		{
+			const uint64_t minEpoch = RcuImpl::getMinActiveEpoch();
+			size_t nbKept = 0;
+			for (const auto& retired : m_retiredList)
+			{
+				if (retired.m_epoch < minEpoch)
+				{
+					delete retired.m_pValue;
+				}
+				else
+				{
+					m_retiredList[nbKept++] = retired;
+				}
+			}
+			const bool isReclaimed = (nbKept != m_retiredList.size());
+			m_retiredList.resize(nbKept);
+			return isReclaimed;
+		}
+
+		std::atomic<const T*> m_pValue;
+		mutable std::mutex m_mutex;
+		std::vector<Retired> m_retiredList;
+	};
+}
@@ -0,0 +1,130 @@
+#include <cstdlib>
+#include <exception>
+#include <limits>
+#include <new>
+
+#include "../Rcu.hpp"
+#include "../Assert.hpp"
+
+/**
+ * Records are reused by new threads and never deleted, so that writers can
+ * scan them without lock. They bypass the monitored allocator, as they are
+ * never released.
+ */
+struct IrStd::RcuImpl::Record
+{
+	// Epoch recorded when entering, 0 if not reading
+	std::atomic<uint64_t> m_epoch;
+	std::atomic<bool> m_isUsed;
+	Record* m_pNext;
+	// Used by the owner thread only
+	size_t m_depth;
+};
+
+namespace
+{
+	typedef IrStd::RcuImpl::Record Record;
+
+	std::atomic<uint64_t> globalEpoch(1);
+	std::atomic<Record*> pRecordList(nullptr);
+
+	Record* acquireRecord() noexcept
+	{
+		for (auto pRecord = pRecordList.load(std::memory_order_acquire); pRecord; pRecord = pRecord->m_pNext)
+		{
+			bool isUsed = false;
+			if (!pRecord->m_isUsed.load(std::memory_order_relaxed)
+					&& pRecord->m_isUsed.compare_exchange_strong(isUsed, true, std::memory_order_acquire))
+			{
+				return pRecord;
+			}
+		}
+
+		void* const ptr = std::malloc(sizeof(Record));
+		// Same as a failing new in a noexcept function
+		if (!ptr)
+		{
+			std::terminate();
+		}
+		auto pRecord = new (ptr) Record;
+		pRecord->m_epoch.store(0, std::memory_order_relaxed);
+		pRecord->m_isUsed.store(true, std::memory_order_relaxed);
+		pRecord->m_depth = 0;
+		pRecord->m_pNext = pRecordList.load(std::memory_order_relaxed);
+		while (!pRecordList.compare_exchange_weak(pRecord->m_pNext, pRecord, std::memory_order_release))
+		{
+		}
+		return pRecord;
+	}
+
+	thread_local Record* pCurrentRecord = nullptr;
+
+	/**
+	 * Give the record back when the thread exits
+	 */
+	struct RecordOwner
+	{
+		~RecordOwner()
+		{
+			if (pCurrentRecord)
+			{
+				pCurrentRecord->m_isUsed.store(false, std::memory_order_release);
+				pCurrentRecord = nullptr;
+			}
+		}
+	};
+
+	Record& getRecord() noexcept
+	{
+		if (!pCurrentRecord)
+		{
+			// A thread reading while it exits, after its owner is gone, keeps its record
+			static thread_local RecordOwner owner;
+			pCurrentRecord = acquireRecord();
+		}
+		return *pCurrentRecord;
+	}
+}
+
+// ---- IrStd::RcuImpl --------------------------------------------------------
+
+IrStd::RcuImpl::Record* IrStd::RcuImpl::enter() noexcept
+{
+	auto& record = getRecord();
+	if (!record.m_depth++)
+	{
+		record.m_epoch.store(globalEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		// The epoch is visible to writers before the pointer is read
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+	return &record;
+}
+
+void IrStd::RcuImpl::leave(Record* const pRecord) noexcept
+{
+	// The depth is not atomic, and the thread may be reading again meanwhile
+	IRSTD_ASSERT(pRecord == pCurrentRecord, "The read scope is released by another thread than its owner");
+	if (!--pRecord->m_depth)
+	{
+		pRecord->m_epoch.store(0, std::memory_order_release);
+	}
+}
+
+uint64_t IrStd::RcuImpl::advance() noexcept
+{
+	return globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+}
+
+uint64_t IrStd::RcuImpl::getMinActiveEpoch() noexcept
+{
+	uint64_t minEpoch = std::numeric_limits<uint64_t>::max();
+	for (auto pRecord = pRecordList.load(std::memory_order_acquire); pRecord; pRecord = pRecord->m_pNext)
+	{
+		const uint64_t epoch = pRecord->m_epoch.load(std::memory_order_seq_cst);
+		if (epoch && epoch < minEpoch)
+		{
+			minEpoch = epoch;
+		}
+	}
+	return minEpoch;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace IrStd
+{
+	/**
+	 * \brief Small value read without lock, written rarely
+	 *
+	 * Writers increment a sequence number before and after writing the value.
+	 * Readers copy the value and retry if the sequence number changed in the
+	 * meantime, or was odd, a write being in progress. Readers never write to
+	 * shared memory, so they do not contend with each other.
+	 *
+	 * The value is copied word by word with atomic operations, this is meant
+	 * for snapshots of a few words of plain data.
+	 */
+	template<class T>
+	class SeqLock
+	{
+	public:
+		static_assert(std::is_trivially_copyable<T>::value, "SeqLock only holds trivially copyable types");
+
+		explicit SeqLock(const T& value = T()) noexcept
+				: m_sequence(0)
+		{
+			write(value);
+		}
+
+		SeqLock(const SeqLock&) = delete;
+		SeqLock& operator=(const SeqLock&) = delete;
+
+		/**
+		 * \brief Consistent copy of the value
+		 */
+		T load() const noexcept
+		{
+			uint64_t buffer[NB_WORDS];
+			for (;;)
+			{
+				const uint32_t sequence = m_sequence.load(std::memory_order_acquire);
+				if (sequence & 1)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+				for (size_t i = 0; i < NB_WORDS; ++i)
+				{
+					buffer[i] = m_data[i].load(std::memory_order_relaxed);
+				}
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (m_sequence.load(std::memory_order_relaxed) == sequence)
+				{
+					break;
+				}
+			}
+			T value;
+			std::memcpy(&value, buffer, sizeof(T));
+			return value;
+		}
+
+		/**
+		 * \brief Replace the value, writers are serialized
+		 */
+		void store(const T& value) noexcept
+		{
+			const uint32_t sequence = lock();
+			write(value);
+			m_sequence.store(sequence + 2, std::memory_order_release);
+		}
+
+		/**
+		 * \brief Replace the value with the result of a function of the current one
+		 */
+		template<class F>
+		void update(F&& fct)
+		{
+			const uint32_t sequence = lock();
+			T value;
+			for (size_t i = 0; i < NB_WORDS; ++i)
+			{
+				m_buffer[i] = m_data[i].load(std::memory_order_relaxed);
+			}
+			std::memcpy(&value, m_buffer, sizeof(T));
+			try
+			{
+				value = fct(value);
+			}
+			catch (...)
+			{
+				m_sequence.store(sequence + 2, std::memory_order_release);
+				throw;
+			}
+			write(value);
+			m_sequence.store(sequence + 2, std::memory_order_release);
+		}
+
+		// For testing purpose
+		uint32_t getSequence() const noexcept
+		{
+			return m_sequence.load();
+		}
+
+	private:
+		static constexpr size_t NB_WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+		/**
+		 * Make the sequence odd, and return its previous value
+		 */
+		uint32_t lock() noexcept
+		{
+			uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				if (sequence & 1)
+				{
+					std::this_thread::yield();
+					sequence = m_sequence.load(std::memory_order_relaxed);
+					continue;
+				}
+				if (m_sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire))
+				{
+					break;
+				}
+			}
+			// The value is not written before the sequence is odd
+			std::atomic_thread_fence(std::memory_order_release);
+			return sequence;
+		}
+
+		void write(const T& value) noexcept
+		{
+			std::memset(m_buffer, 0, sizeof(m_buffer));
+			std::memcpy(m_buffer, &value, sizeof(T));
+			for (size_t i = 0; i < NB_WORDS; ++i)
+			{
+				m_data[i].store(m_buffer[i], std::memory_order_relaxed);
+			}
+		}
+
+		std::atomic<uint32_t> m_sequence;
+		std::atomic<uint64_t> m_data[NB_WORDS];
+		// Used by the writer only
+		uint64_t m_buffer[NB_WORDS];
+	};
+
+	template<class T>
+	constexpr size_t SeqLock<T>::NB_WORDS;
+}
@@ -118,6 +118,8 @@ namespace IrStd
 		const uint16_t m_port;
 		const uint16_t m_backLog;
 		Event m_event;
+		// Descriptor of m_event, set by start() before the connections are processed
+		int m_eventFd;
 		Status m_status;
 
 		/**
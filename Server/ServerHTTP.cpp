@@ -169,6 +169,9 @@ IrStd::ServerHTTP::ProcessStatus IrStd::ServerHTTP::processImpl(
 		ServerHTTPImpl::ClientInfo& info,
 		std::string& dataStr)
 {
+	// All the temporary allocations related to this request are released at once
+	ArenaScope arena;
+
 	// Ensure a response is sent 
 	class ResponseRAII
 	{
@@ -817,7 +820,7 @@ void IrStd::ServerHTTP::Response::setData(const char* const data, const size_t s
 void IrStd::ServerHTTP::Response::send(const int socket) const
 {
 	// Build the header
-	std::string response("HTTP/1.1 ");
+	ArenaString response("HTTP/1.1 ");
 	response.append(IrStd::Type::ShortString(m_code));
 	response.append(" ");
 	response.append(m_pReason);
@@ -3,6 +3,7 @@
 #include <limits>
 
 #include "MimeType.hpp"
+#include "../Allocator.hpp"
 #include "../Server.hpp"
 #include "../Json.hpp"
 
@@ -89,8 +90,8 @@ namespace IrStd
 		private:
 			size_t m_code;
 			const char* m_pReason;
-			std::string m_headers;
-			std::string m_data;
+			ArenaString m_headers;
+			ArenaString m_data;
 		};
 
 		typedef ServerHTTPImpl::ClientInfo Request;
@@ -32,13 +32,13 @@ void IrStd::ServerREST::Context::addMatch(const size_t begin, const size_t end,
 
 int64_t IrStd::ServerREST::Context::getMatchAsInt(const size_t index) const
 {
-	const std::string str = getMatchAsString(index);
+	const ArenaString str = getMatchAsArenaString(index);
 	return Type::Numeric<int64_t>::fromString(str.c_str());
 }
 
 uint64_t IrStd::ServerREST::Context::getMatchAsUInt(const size_t index) const
 {
-	const std::string str = getMatchAsString(index);
+	const ArenaString str = getMatchAsArenaString(index);
 	return Type::Numeric<uint64_t>::fromString(str.c_str());
 }
 
@@ -51,6 +51,15 @@ std::string IrStd::ServerREST::Context::getMatchAsString(const size_t index) con
 	return uri.substr(match.m_begin, match.m_end - match.m_begin);
 }
 
+IrStd::ArenaString IrStd::ServerREST::Context::getMatchAsArenaString(const size_t index) const
+{
+	IRSTD_THROW_ASSERT(IrStdServer, index < m_nbMatches, "Index (" << index
+			<< ") is out of bound (nbMatches=" << m_nbMatches << ")");
+	const std::string& uri = getRequest().getURI();
+	const auto& match = m_matchList[index];
+	return ArenaString(uri.data() + match.m_begin, match.m_end - match.m_begin);
+}
+
 size_t IrStd::ServerREST::Context::getNbMatches() const noexcept
 {
 	return m_nbMatches;
@@ -50,6 +50,11 @@ namespace IrStd
 			 */
 			std::string getMatchAsString(const size_t index) const;
 
+			/**
+			 * Same as \ref getMatchAsString but the string is allocated from the request arena
+			 */
+			ArenaString getMatchAsArenaString(const size_t index) const;
+
 			/**
 			 * Return the number of matches
 			 */
@@ -12,6 +12,7 @@
 #include "../Server.hpp"
 #include "../Logger.hpp"
 #include "../Assert.hpp"
+#include "../Memory.hpp"
 #include "../Type/ShortString.hpp"
 
 IRSTD_TOPIC_USE(IrStd, Server);
@@ -26,6 +27,7 @@ IrStd::Server<T>::Server(
 		: m_manager(maxConnections)
 		, m_port(static_cast<uint16_t>(port))
 		, m_backLog(static_cast<uint16_t>(backLog))
+		, m_eventFd(-1)
 		, m_status(Status::IDLE)
 {
 }
@@ -36,6 +38,7 @@ size_t IrStd::Server<T>::receiveSpecificAmount(const int socket, std::string& da
 	size_t dataReceived = 0;
 	while (dataReceived < size)
 	{
+		IRSTD_THROW_ASSERT(IRSTD_TOPIC(IrStd, Server), isStarted(), "The server stopped while receiving data");
 		dataReceived += receive(socket, data, size - dataReceived);
 	}
 
@@ -50,10 +53,12 @@ size_t IrStd::Server<T>::receive(const int socket, std::string& data, const size
 {
 	constexpr size_t CHUNK_SIZE = 512;
 
-	// Monitor socket for input
-	struct ::pollfd fds[1];
+	// Monitor socket for input, and the server event for the stop request
+	struct ::pollfd fds[2];
 	fds[0].fd = socket;
 	fds[0].events = POLLIN;
+	fds[1].fd = m_eventFd;
+	fds[1].events = POLLIN;
 
 	const size_t originalSize = data.size();
 	size_t size = 0;
@@ -69,7 +74,7 @@ size_t IrStd::Server<T>::receive(const int socket, std::string& data, const size
 		}
 
 		// Wait for an event
-		const int retPoll = ::poll(fds, 1, CLIENT_TIMEOUT_MS);
+		const int retPoll = ::poll(fds, 2, CLIENT_TIMEOUT_MS);
 
 		IRSTD_THROW_ASSERT(IRSTD_TOPIC(IrStd, Server), retPoll != -1,
 				"poll: code=" << errno << ", str=" << ::strerror(errno))
@@ -77,8 +82,17 @@ size_t IrStd::Server<T>::receive(const int socket, std::string& data, const size
 		IRSTD_THROW_ASSERT(IRSTD_TOPIC(IrStd, Server), retPoll != 0,
 				"Timeout while receiving data");
 
-		if (fds[0].revents & POLLIN)
+		if (fds[1].revents & POLLIN)
 		{
+			continue;
+		}
+		else if (fds[0].revents & POLLIN)
+		{
+			// Drop the connection rather than growing the buffer above the memory budget
+			IRSTD_THROW_ASSERT(IRSTD_TOPIC(IrStd, Server),
+					IrStd::Memory::getInstance().getBudgetLevel() != IrStd::Memory::Budget::Level::HARD,
+					"The hard memory limit is reached");
+
 			data.resize(originalSize + size + chunckSize);
 			const auto sizeRecv = ::recv(socket, &data[originalSize + size], chunckSize, 0);
 
@@ -291,8 +305,41 @@ void IrStd::Server<T>::start()
 		m_event.trigger();
 	}
 
+	// Wait for connections and for the stop request at once
+	m_eventFd = m_event.getFd();
+	struct ::pollfd fds[2];
+	fds[0].fd = sockFd;
+	fds[0].events = POLLIN;
+	fds[1].fd = m_eventFd;
+	fds[1].events = POLLIN;
+
 	while (isStarted())
 	{
+		const int retPoll = ::poll(fds, 2, /*timeout*/-1);
+		if (retPoll == -1)
+		{
+			if (errno != EINTR)
+			{
+				IRSTD_LOG_ERROR(IRSTD_TOPIC(IrStd, Server), "poll: code=" << errno << ", str=" << ::strerror(errno));
+			}
+			continue;
+		}
+
+		// The event is triggered, the status tells whether to stop. When stopping, the
+		// descriptor stays readable to wake up the connections as well
+		if (fds[1].revents & POLLIN)
+		{
+			if (isStarted())
+			{
+				m_event.clearFd();
+			}
+			continue;
+		}
+		if (!(fds[0].revents & POLLIN))
+		{
+			continue;
+		}
+
 		struct ::sockaddr_storage clientAddr;
 		::socklen_t sinSize = sizeof(clientAddr);
 
@@ -315,6 +362,15 @@ void IrStd::Server<T>::start()
 			break;
 		}
 
+		// Shed the load if the memory budget is exhausted
+		if (IrStd::Memory::getInstance().getBudgetLevel() == IrStd::Memory::Budget::Level::HARD)
+		{
+			IRSTD_LOG_WARNING(IRSTD_TOPIC(IrStd, Server), "Rejecting connection, the hard memory limit is reached ("
+					<< IrStd::Memory::getInstance().getStatCurrent() << ")");
+			closeSocket(clientFd);
+			continue;
+		}
+
 		// Register this file descriptor
 		const auto index = m_manager.allocateClient(clientFd);
 		if (index == m_manager.size())
@@ -371,21 +427,9 @@ void IrStd::Server<T>::stop()
 			"Server is not running (status=" << static_cast<int>(m_status) << ")");
 	IRSTD_LOG_TRACE(IRSTD_TOPIC(IrStd, Server), "Sending stop request to server on port "
 			<< m_port);
+	// Wakes up the accept loop, which polls the event
 	m_status = Status::STOPPING;
 	m_event.trigger();
-
-	try
-	{
-		auto sockFd = createSocket(nullptr, m_port, SocketLink::CONNECT);
-		IRSTD_THROW_ASSERT(IRSTD_TOPIC(IrStd, Server), sockFd >= 0, "Invalid socket");
-		closeSocket(sockFd);
-	}
-	catch (const IrStd::Exception& e)
-	{
-		IRSTD_LOG_ERROR(IRSTD_TOPIC(IrStd, Server), "Ignoring as a workaround: "
-				<< e);
-		// Todo: need to remove this
-	}
 }
 
 template<class T>
@@ -6,6 +6,7 @@
 #include <memory>
 #include <future>
 #include <atomic>
+#include <vector>
 
 #include "Logger.hpp"
 #include "Topic.hpp"
@@ -23,7 +24,17 @@ namespace IrStd
 	class Thread;
 	typedef std::shared_ptr<Thread> ThreadPtr;
 
-	class Thread
+	/**
+	 * \brief A thread created through IrStd
+	 *
+	 * A running thread knows its own Thread object through a thread-local
+	 * pointer, so that querying or updating the current thread never goes
+	 * through the registry.
+	 *
+	 * The name of the thread is also given to the system (truncated to 15
+	 * characters on Linux), so that it shows in top, gdb or perf.
+	 */
+	class Thread : public std::enable_shared_from_this<Thread>
 	{
 	public:
 		enum class Status
@@ -33,6 +44,40 @@ namespace IrStd
 			TERMINATED
 		};
 
+		/**
+		 * \brief Scheduling policy of a thread
+		 */
+		enum class Policy
+		{
+			/// Default time-sharing policy
+			OTHER = 0,
+			/// Real-time, runs until it blocks or a higher priority thread is ready
+			FIFO,
+			/// Real-time, like FIFO with a time slice
+			ROUND_ROBIN,
+			/// Time-sharing for CPU-bound threads, less often preempted
+			BATCH,
+			/// Runs only when nothing else is to run
+			IDLE
+		};
+
+		/**
+		 * \brief Activity of a thread since it started
+		 */
+		struct Statistics
+		{
+			/// Time spent in the ACTIVE and IDLE states
+			uint64_t m_activeTimeNs;
+			uint64_t m_idleTimeNs;
+			/// CPU time consumed by the thread, 0 if not available
+			uint64_t m_cpuTimeNs;
+			/// Context switches, the thread blocked or was preempted
+			uint64_t m_nbVoluntarySwitches;
+			uint64_t m_nbInvoluntarySwitches;
+			/// Jobs processed, for threads running jobs
+			uint64_t m_nbJobs;
+		};
+
 		Thread(const char* const pName = "<unamed>");
 		~Thread();
 
@@ -65,6 +110,22 @@ namespace IrStd
 		bool setIdle() noexcept;
 		bool setActive() noexcept;
 
+		/**
+		 * \brief Count a job processed by the thread
+		 */
+		void addJob() noexcept
+		{
+			m_nbJobs.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		/**
+		 * \brief Read the activity of the thread
+		 *
+		 * The CPU time and context switches come from the system, they are
+		 * frozen once the thread exits.
+		 */
+		void getStatistics(Statistics& statistics) const noexcept;
+
 		/**
 		 * \brief Put a thread to sleep
 		 *
@@ -92,6 +153,46 @@ namespace IrStd
 		 */
 		const char* getName() const noexcept;
 
+		/**
+		 * \brief Restrict the thread to a set of CPUs
+		 *
+		 * \param cpuList Indexes of the CPUs, all the CPUs of the process if empty.
+		 *
+		 * \return false if it failed or is not supported on this platform.
+		 */
+		bool setAffinity(const std::vector<size_t>& cpuList) noexcept;
+
+		/**
+		 * \brief Set the scheduling policy of the thread
+		 *
+		 * \param priority Static priority, from 1 to 99 for the real-time
+		 *        policies, 0 for the others.
+		 *
+		 * \note Real-time policies usually require privileges (CAP_SYS_NICE).
+		 *
+		 * \return false if it failed or is not supported on this platform.
+		 */
+		bool setPolicy(const Policy policy, const int priority = 0) noexcept;
+
+		/**
+		 * \brief Set the nice level of the thread, from -20 (highest) to 19 (lowest)
+		 *
+		 * \return false if it failed or is not supported on this platform.
+		 */
+		bool setNice(const int nice) noexcept;
+
+		/**
+		 * \brief Return the CPUs the calling thread is allowed to run on
+		 */
+		static std::vector<size_t> getCpuList();
+
+		/**
+		 * \brief Return the Thread object of the calling thread
+		 *
+		 * \return nullptr if the calling thread was not created through IrStd.
+		 */
+		static Thread* getCurrent() noexcept;
+
 		/**
 		 * Return a hash of the thread id
 		 */
@@ -106,6 +207,22 @@ namespace IrStd
 		 */
 		void start() noexcept;
 
+		/**
+		 * Called by the thread itself when it starts and before it exits
+		 */
+		void onStart() noexcept;
+		void onStop() noexcept;
+
+		/**
+		 * Add the time since the last status change to the time of the previous status
+		 */
+		void accountStatus(const Status previous) noexcept;
+
+		/**
+		 * Read the CPU time and context switches from the system
+		 */
+		bool readSystemStatistics(Statistics& statistics) const noexcept;
+
 		template<class Function, class ... Args>
 		static ThreadPtr createIdle(const char* const pName, Function&& f, Args&& ... args)
 		{
@@ -128,6 +245,7 @@ namespace IrStd
 					<< pThread->m_event.getCounter() << ")");
 
 			// Set the status to active
+			pThread->onStart();
 			pThread->m_status = Status::ACTIVE;
 			pThread->m_event.trigger();
 
@@ -136,6 +254,7 @@ namespace IrStd
 
 			fct();
 
+			pThread->onStop();
 			pThread->m_status = Status::TERMINATED;
 			IRSTD_LOG_TRACE(IRSTD_TOPIC(IrStd, Thread), "Terminating " << std::this_thread::get_id()
 					<< " (" << pThread->getName() << ")");
@@ -143,11 +262,34 @@ namespace IrStd
 
 		std::thread m_thread;
 		std::atomic<Status> m_status;
-		bool m_isTerminate;
+		std::atomic<bool> m_isTerminate;
 		Event m_event;
 		std::string m_name;
+		// Identifier of the thread for the system, set once started
+		std::atomic<int64_t> m_systemId;
+
+		// Time of the last status change, 0 until the thread starts
+		std::atomic<uint64_t> m_statusTimeNs;
+		std::atomic<uint64_t> m_activeTimeNs;
+		std::atomic<uint64_t> m_idleTimeNs;
+		std::atomic<uint64_t> m_nbJobs;
+		// System statistics saved when the thread exits
+		std::atomic<bool> m_isFinal;
+		Statistics m_final;
+		// CPU clock of the thread (a clockid_t), valid while m_hasClock is set.
+		// Cleared under the lock before the thread is joined.
+		mutable std::mutex m_clockLock;
+		bool m_hasClock;
+		int64_t m_clockId;
 	};
 
+	/**
+	 * \brief Registry of the threads created through IrStd
+	 *
+	 * The registry is only locked to create, terminate or list threads. The
+	 * functions querying or updating the calling thread use its thread-local
+	 * Thread object instead.
+	 */
 	class Threads : public SingletonImpl<Threads>
 	{
 	public:
@@ -267,3 +409,5 @@ std::ostream& operator<<(std::ostream& os, const std::thread::id& threadId);
 
 // Extra implementation
 #include "Thread/ThreadPool.hpp"
+#include "Thread/Task.hpp"
+#include "Thread/Reactor.hpp"
@@ -0,0 +1,567 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../Allocator.hpp"
+#include "../Assert.hpp"
+
+namespace IrStd
+{
+	template<class T>
+	class Future;
+	template<class T>
+	class Promise;
+
+	namespace ThreadPoolImpl
+	{
+		class Scheduler;
+
+		/**
+		 * \brief State shared between a promise and its futures
+		 *
+		 * The state is reference counted and holds the value, or the exception,
+		 * and the continuations to run once it is set.
+		 */
+		class SharedStateBase
+		{
+		public:
+			SharedStateBase(Scheduler* const pScheduler) noexcept;
+			virtual ~SharedStateBase();
+
+			void acquire() noexcept
+			{
+				m_refCount.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			void release() noexcept
+			{
+				if (m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					delete this;
+				}
+			}
+
+			/**
+			 * Count the promises referring to the state, when the last one goes
+			 * away without setting it, the state is set with a broken promise
+			 * error (std::future_error).
+			 */
+			void acquirePromise() noexcept
+			{
+				m_nbPromises.fetch_add(1, std::memory_order_relaxed);
+			}
+			void releasePromise() noexcept;
+
+			bool isReady() const noexcept;
+
+			/**
+			 * Block until the state is set
+			 */
+			void wait() noexcept;
+
+			const std::exception_ptr& getException() const noexcept
+			{
+				return m_exception;
+			}
+
+			/**
+			 * Scheduler running the continuations, nullptr to run them in the thread setting the state
+			 */
+			Scheduler* getScheduler() const noexcept
+			{
+				return m_pScheduler;
+			}
+
+			/**
+			 * Run a function once the state is set, right away if it is already set
+			 *
+			 * \param isInline Run the function in the thread setting the state rather
+			 *        than through the scheduler, this is for short functions only.
+			 */
+			void addContinuation(const std::function<void()>& fct, const bool isInline = false);
+
+			void setException(const std::exception_ptr& exception);
+
+		protected:
+			/**
+			 * Mark the state as set and run the continuations
+			 */
+			void complete();
+
+		private:
+			void run(const std::function<void()>& fct, const bool isInline);
+			void lock() noexcept;
+			void unlock() noexcept;
+
+			std::atomic<uint32_t> m_refCount;
+			std::atomic<uint32_t> m_nbPromises;
+			// Used as a futex, see the .cpp
+			std::atomic<uint32_t> m_status;
+			std::atomic_flag m_lock;
+			std::exception_ptr m_exception;
+			Scheduler* const m_pScheduler;
+
+			struct Continuation
+			{
+				std::function<void()> m_fct;
+				bool m_isInline;
+			};
+			std::vector<Continuation> m_continuationList;
+		};
+
+		template<class T>
+		class SharedState : public SharedStateBase, public AllocatorImpl<AllocatorObjectPool<SharedState<T>>>
+		{
+		public:
+			SharedState(Scheduler* const pScheduler) noexcept
+					: SharedStateBase(pScheduler)
+					, m_isValue(false)
+			{
+			}
+
+			~SharedState()
+			{
+				if (m_isValue)
+				{
+					reinterpret_cast<T*>(&m_value)->~T();
+				}
+			}
+
+			template<class U>
+			void setValue(U&& value)
+			{
+				::new (&m_value) T(std::forward<U>(value));
+				m_isValue = true;
+				complete();
+			}
+
+			const T& getValue() const noexcept
+			{
+				return *reinterpret_cast<const T*>(&m_value);
+			}
+
+		private:
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type m_value;
+			bool m_isValue;
+		};
+
+		template<>
+		class SharedState<void> : public SharedStateBase, public AllocatorImpl<AllocatorObjectPool<SharedState<void>>>
+		{
+		public:
+			SharedState(Scheduler* const pScheduler) noexcept
+					: SharedStateBase(pScheduler)
+			{
+			}
+
+			void setValue()
+			{
+				complete();
+			}
+		};
+
+		template<class T>
+		struct Setter;
+		template<class R, class F>
+		struct SubmitJob;
+		template<class T, class R, class F>
+		struct ThenJob;
+
+		/**
+		 * Result of a continuation taking the value of a Future<T>
+		 */
+		template<class T, class F>
+		struct ThenResult
+		{
+			typedef decltype(std::declval<F&>()(std::declval<const T&>())) type;
+		};
+
+		template<class F>
+		struct ThenResult<void, F>
+		{
+			typedef decltype(std::declval<F&>()()) type;
+		};
+
+		template<class T>
+		struct GetResult
+		{
+			typedef const T& type;
+		};
+
+		template<>
+		struct GetResult<void>
+		{
+			typedef void type;
+		};
+	}
+
+	/**
+	 * \brief Value available in the future
+	 *
+	 * Futures are cheap to copy, they all refer to the same state.
+	 */
+	template<class T>
+	class Future
+	{
+	public:
+		Future() noexcept
+				: m_pState(nullptr)
+		{
+		}
+
+		Future(const Future& future) noexcept
+				: m_pState(future.m_pState)
+		{
+			if (m_pState)
+			{
+				m_pState->acquire();
+			}
+		}
+
+		Future(Future&& future) noexcept
+				: m_pState(future.m_pState)
+		{
+			future.m_pState = nullptr;
+		}
+
+		~Future()
+		{
+			if (m_pState)
+			{
+				m_pState->release();
+			}
+		}
+
+		Future& operator=(Future future) noexcept
+		{
+			std::swap(m_pState, future.m_pState);
+			return *this;
+		}
+
+		/**
+		 * \brief Whether the future refers to a state, false once default
+		 * constructed or moved from. Other calls require a valid future.
+		 */
+		bool isValid() const noexcept
+		{
+			return m_pState != nullptr;
+		}
+
+		bool isReady() const noexcept
+		{
+			IRSTD_ASSERT(IRSTD_TOPIC(IrStd, Thread), isValid(), "The future has no state");
+			return m_pState->isReady();
+		}
+
+		/**
+		 * \brief Block until the value is set
+		 *
+		 * \note Blocking a worker prevents it from running other jobs,
+		 * prefer \ref then from a worker.
+		 */
+		void wait() const noexcept
+		{
+			IRSTD_ASSERT(IRSTD_TOPIC(IrStd, Thread), isValid(), "The future has no state");
+			m_pState->wait();
+		}
+
+		/**
+		 * \brief Wait for the value and return it, or re-throw the exception set instead
+		 */
+		typename ThreadPoolImpl::GetResult<T>::type get() const
+		{
+			wait();
+			if (m_pState->getException())
+			{
+				std::rethrow_exception(m_pState->getException());
+			}
+			return m_pState->getValue();
+		}
+
+		/**
+		 * \brief Chain a function called with the value once set
+		 *
+		 * The function runs on the scheduler which set the value. If an
+		 * exception was set instead, the function is not called and the
+		 * exception is forwarded to the future returned.
+		 */
+		template<class F>
+		Future<typename ThreadPoolImpl::ThenResult<T, typename std::decay<F>::type>::type> then(F&& fct) const
+		{
+			typedef typename std::decay<F>::type Function;
+			typedef typename ThreadPoolImpl::ThenResult<T, Function>::type R;
+
+			IRSTD_ASSERT(IRSTD_TOPIC(IrStd, Thread), isValid(), "The future has no state");
+			Promise<R> promise(m_pState->getScheduler());
+			Future<R> future = promise.getFuture();
+			m_pState->addContinuation(ThreadPoolImpl::ThenJob<T, R, Function>{*this, promise, Function(std::forward<F>(fct))});
+			return future;
+		}
+
+		ThreadPoolImpl::SharedStateBase& getState() const noexcept
+		{
+			IRSTD_ASSERT(IRSTD_TOPIC(IrStd, Thread), isValid(), "The future has no state");
+			return *m_pState;
+		}
+
+	private:
+		friend Promise<T>;
+
+		explicit Future(ThreadPoolImpl::SharedState<T>* const pState) noexcept
+				: m_pState(pState)
+		{
+			m_pState->acquire();
+		}
+
+		ThreadPoolImpl::SharedState<T>* m_pState;
+	};
+
+	template<>
+	inline void Future<void>::get() const
+	{
+		wait();
+		if (m_pState->getException())
+		{
+			std::rethrow_exception(m_pState->getException());
+		}
+	}
+
+	/**
+	 * \brief Set the value of futures
+	 */
+	template<class T>
+	class Promise
+	{
+	public:
+		/**
+		 * \param pScheduler Scheduler running the continuations, they run in the
+		 *        thread setting the value if nullptr.
+		 */
+		explicit Promise(ThreadPoolImpl::Scheduler* const pScheduler = nullptr)
+				: m_pState(new ThreadPoolImpl::SharedState<T>(pScheduler))
+		{
+			m_pState->acquire();
+			m_pState->acquirePromise();
+		}
+
+		Promise(const Promise& promise) noexcept
+				: m_pState(promise.m_pState)
+		{
+			m_pState->acquire();
+			m_pState->acquirePromise();
+		}
+
+		/**
+		 * The futures of a promise destroyed without being set get a broken
+		 * promise error, they would wait forever otherwise.
+		 */
+		~Promise()
+		{
+			m_pState->releasePromise();
+			m_pState->release();
+		}
+
+		Promise& operator=(const Promise&) = delete;
+
+		Future<T> getFuture() const noexcept
+		{
+			return Future<T>(m_pState);
+		}
+
+		template<class ... Args>
+		void setValue(Args&& ... args)
+		{
+			m_pState->setValue(std::forward<Args>(args)...);
+		}
+
+		void setException(const std::exception_ptr& exception)
+		{
+			m_pState->setException(exception);
+		}
+
+		/**
+		 * \brief Set the value with the result of a function, or with the exception it throws
+		 */
+		template<class F>
+		void setWith(F&& fct)
+		{
+			try
+			{
+				ThreadPoolImpl::Setter<T>::set(*this, fct);
+			}
+			catch (...)
+			{
+				setException(std::current_exception());
+			}
+		}
+
+	private:
+		ThreadPoolImpl::SharedState<T>* m_pState;
+	};
+
+	namespace ThreadPoolImpl
+	{
+		/**
+		 * Set a promise with the result of a function, or with the exception it throws
+		 */
+		template<class T>
+		struct Setter
+		{
+			template<class F, class ... Args>
+			static void set(Promise<T>& promise, F& fct, Args&& ... args)
+			{
+				promise.setValue(fct(std::forward<Args>(args)...));
+			}
+		};
+
+		template<>
+		struct Setter<void>
+		{
+			template<class F, class ... Args>
+			static void set(Promise<void>& promise, F& fct, Args&& ... args)
+			{
+				fct(std::forward<Args>(args)...);
+				promise.setValue();
+			}
+		};
+
+		template<class R, class F>
+		struct SubmitJob
+		{
+			void operator()()
+			{
+				m_promise.setWith(m_fct);
+			}
+
+			Promise<R> m_promise;
+			F m_fct;
+		};
+
+		template<class T, class R, class F>
+		struct ThenJob
+		{
+			void operator()()
+			{
+				m_promise.setWith([this]() { return m_fct(m_future.get()); });
+			}
+
+			Future<T> m_future;
+			Promise<R> m_promise;
+			F m_fct;
+		};
+
+		template<class R, class F>
+		struct ThenJob<void, R, F>
+		{
+			void operator()()
+			{
+				m_promise.setWith([this]() { m_future.get(); return m_fct(); });
+			}
+
+			Future<void> m_future;
+			Promise<R> m_promise;
+			F m_fct;
+		};
+	}
+
+	/**
+	 * \brief Future set once all the futures are set
+	 *
+	 * If any of them holds an exception, the first one is forwarded.
+	 * The values are read from the futures themselves.
+	 */
+	template<class T>
+	Future<void> whenAll(const std::vector<Future<T>>& futureList)
+	{
+		struct Context
+		{
+			Context(const size_t nbFutures, Promise<void>&& promise)
+					: m_nbLeft(nbFutures)
+					, m_promise(promise)
+					, m_isException(false)
+			{
+			}
+			std::atomic<size_t> m_nbLeft;
+			Promise<void> m_promise;
+			std::exception_ptr m_exception;
+			std::atomic<bool> m_isException;
+		};
+
+		Promise<void> promise((futureList.empty()) ? nullptr : futureList.front().getState().getScheduler());
+		Future<void> future = promise.getFuture();
+		if (futureList.empty())
+		{
+			promise.setValue();
+			return future;
+		}
+
+		auto pContext = std::make_shared<Context>(futureList.size(), std::move(promise));
+		for (const auto& item : futureList)
+		{
+			ThreadPoolImpl::SharedStateBase& state = item.getState();
+			state.addContinuation([pContext, &state]() {
+				bool expected = false;
+				if (state.getException() && pContext->m_isException.compare_exchange_strong(expected, true))
+				{
+					pContext->m_exception = state.getException();
+				}
+				if (pContext->m_nbLeft.fetch_sub(1) == 1)
+				{
+					if (pContext->m_exception)
+					{
+						pContext->m_promise.setException(pContext->m_exception);
+					}
+					else
+					{
+						pContext->m_promise.setValue();
+					}
+				}
+			}, /*isInline*/true);
+		}
+		return future;
+	}
+
+	/**
+	 * \brief Future set with the index of the first future set
+	 *
+	 * \note The list must not be empty, the future would never be set.
+	 */
+	template<class T>
+	Future<size_t> whenAny(const std::vector<Future<T>>& futureList)
+	{
+		IRSTD_ASSERT(IRSTD_TOPIC(IrStd, Thread), !futureList.empty(), "whenAny needs at least one future");
+
+		struct Context
+		{
+			explicit Context(Promise<size_t>&& promise)
+					: m_promise(promise)
+					, m_isSet(false)
+			{
+			}
+			Promise<size_t> m_promise;
+			std::atomic<bool> m_isSet;
+		};
+
+		Promise<size_t> promise(futureList.front().getState().getScheduler());
+		Future<size_t> future = promise.getFuture();
+		auto pContext = std::make_shared<Context>(std::move(promise));
+		for (size_t i = 0; i < futureList.size(); ++i)
+		{
+			futureList[i].getState().addContinuation([pContext, i]() {
+				bool expected = false;
+				if (pContext->m_isSet.compare_exchange_strong(expected, true))
+				{
+					pContext->m_promise.setValue(i);
+				}
+			}, /*isInline*/true);
+		}
+		return future;
+	}
+}
@@ -0,0 +1,236 @@
+#include <vector>
+
+#include "../Thread.hpp"
+#include "../Exception.hpp"
+#include "../Compiler.hpp"
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	#include <cerrno>
+	#include <cstring>
+	#include <unistd.h>
+	#include <sys/epoll.h>
+	#include <sys/eventfd.h>
+#endif
+
+IRSTD_TOPIC_USE_ALIAS(IrStdThread, IrStd, Thread);
+
+namespace
+{
+	std::exception_ptr makeError(const std::string& message)
+	{
+		try
+		{
+			IRSTD_THROW(IrStdThread, message);
+		}
+		catch (...)
+		{
+			return std::current_exception();
+		}
+		return nullptr;
+	}
+}
+
+// ---- IrStd::Reactor --------------------------------------------------------
+
+IrStd::Reactor::Reactor(ThreadPoolImpl::Scheduler* const pScheduler)
+		: m_pScheduler(pScheduler)
+		, m_epollFd(-1)
+		, m_wakeFd(-1)
+		, m_isStopping(false)
+{
+#if IRSTD_IS_PLATFORM(LINUX)
+	m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+	IRSTD_ASSERT(IrStdThread, m_epollFd != -1, "epoll_create1 failed: " << std::strerror(errno));
+	m_wakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	IRSTD_ASSERT(IrStdThread, m_wakeFd != -1, "eventfd failed: " << std::strerror(errno));
+
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = m_wakeFd;
+	::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event);
+
+	m_threadId = IrStd::Threads::create("Reactor", &Reactor::process, this);
+#else
+	IRSTD_CRASH(IrStdThread, "Reactor is not supported on this platform (" << IRSTD_PLATFORM_STRING << ")");
+#endif
+}
+
+IrStd::Reactor::~Reactor()
+{
+#if IRSTD_IS_PLATFORM(LINUX)
+	m_isStopping.store(true);
+	const uint64_t value = 1;
+	if (::write(m_wakeFd, &value, sizeof(value)) != sizeof(value))
+	{
+		IRSTD_LOG_ERROR(IrStdThread, "Cannot wake up the reactor thread: " << std::strerror(errno));
+	}
+	IrStd::Threads::terminate(m_threadId);
+
+	// Nothing will set the futures still pending
+	for (auto& item : m_waiterMap)
+	{
+		if (item.second.m_pRead)
+		{
+			item.second.m_pRead->setException(makeError("The reactor was destroyed"));
+		}
+		if (item.second.m_pWrite)
+		{
+			item.second.m_pWrite->setException(makeError("The reactor was destroyed"));
+		}
+	}
+	::close(m_wakeFd);
+	::close(m_epollFd);
+#endif
+}
+
+IrStd::Future<void> IrStd::Reactor::whenReadable(const int fd)
+{
+	return when(fd, /*isRead*/true);
+}
+
+IrStd::Future<void> IrStd::Reactor::whenWritable(const int fd)
+{
+	return when(fd, /*isRead*/false);
+}
+
+IrStd::Future<void> IrStd::Reactor::when(const int fd, const bool isRead)
+{
+	Promise<void> promise(m_pScheduler);
+	Future<void> future = promise.getFuture();
+	bool isError = false;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		const bool isNew = (m_waiterMap.find(fd) == m_waiterMap.end());
+		Waiter& waiter = m_waiterMap[fd];
+		auto& pPromise = (isRead) ? waiter.m_pRead : waiter.m_pWrite;
+		IRSTD_ASSERT(IrStdThread, !pPromise, "File descriptor " << fd << " is already awaited for "
+				<< ((isRead) ? "reading" : "writing"));
+		pPromise.reset(new Promise<void>(promise));
+		if (!arm(fd, waiter, isNew))
+		{
+			pPromise.reset();
+			if (!waiter.m_pRead && !waiter.m_pWrite)
+			{
+				m_waiterMap.erase(fd);
+			}
+			isError = true;
+		}
+	}
+	if (isError)
+	{
+		promise.setException(makeError("Cannot wait for file descriptor " + std::to_string(fd)));
+	}
+	return future;
+}
+
+void IrStd::Reactor::cancel(const int fd)
+{
+	Waiter waiter;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		const auto it = m_waiterMap.find(fd);
+		if (it == m_waiterMap.end())
+		{
+			return;
+		}
+		waiter = std::move(it->second);
+		m_waiterMap.erase(it);
+#if IRSTD_IS_PLATFORM(LINUX)
+		::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+	}
+	if (waiter.m_pRead)
+	{
+		waiter.m_pRead->setException(makeError("Waiting for file descriptor " + std::to_string(fd) + " was cancelled"));
+	}
+	if (waiter.m_pWrite)
+	{
+		waiter.m_pWrite->setException(makeError("Waiting for file descriptor " + std::to_string(fd) + " was cancelled"));
+	}
+}
+
+bool IrStd::Reactor::arm(const int fd, const Waiter& waiter, const bool isNew) noexcept
+{
+#if IRSTD_IS_PLATFORM(LINUX)
+	// One shot, so that a ready descriptor is reported once until armed again
+	struct epoll_event event;
+	event.events = EPOLLONESHOT;
+	if (waiter.m_pRead)
+	{
+		event.events |= EPOLLIN;
+	}
+	if (waiter.m_pWrite)
+	{
+		event.events |= EPOLLOUT;
+	}
+	event.data.fd = fd;
+	return (::epoll_ctl(m_epollFd, (isNew) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event) == 0);
+#else
+	return false;
+#endif
+}
+
+void IrStd::Reactor::process()
+{
+#if IRSTD_IS_PLATFORM(LINUX)
+	constexpr int MAX_EVENTS = 64;
+	struct epoll_event eventList[MAX_EVENTS];
+	std::vector<std::unique_ptr<Promise<void>>> readyList;
+
+	while (!m_isStopping.load())
+	{
+		const int nbEvents = ::epoll_wait(m_epollFd, eventList, MAX_EVENTS, /*timeout*/-1);
+		if (nbEvents < 0)
+		{
+			IRSTD_ASSERT(IrStdThread, errno == EINTR, "epoll_wait failed: " << std::strerror(errno));
+			continue;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			for (int i = 0; i < nbEvents; ++i)
+			{
+				const int fd = eventList[i].data.fd;
+				if (fd == m_wakeFd)
+				{
+					continue;
+				}
+				const auto it = m_waiterMap.find(fd);
+				if (it == m_waiterMap.end())
+				{
+					continue;
+				}
+
+				// Errors and hang-ups wake up both directions, the next I/O call reports them
+				Waiter& waiter = it->second;
+				const uint32_t events = eventList[i].events;
+				if (waiter.m_pRead && (events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+				{
+					readyList.push_back(std::move(waiter.m_pRead));
+				}
+				if (waiter.m_pWrite && (events & (EPOLLOUT | EPOLLHUP | EPOLLERR)))
+				{
+					readyList.push_back(std::move(waiter.m_pWrite));
+				}
+
+				if (!waiter.m_pRead && !waiter.m_pWrite)
+				{
+					::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+					m_waiterMap.erase(it);
+				}
+				else
+				{
+					arm(fd, waiter, /*isNew*/false);
+				}
+			}
+		}
+
+		// Set the futures without the lock, continuations might wait again
+		for (auto& pPromise : readyList)
+		{
+			pPromise->setValue();
+		}
+		readyList.clear();
+	}
+#endif
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "Future.hpp"
+
+namespace IrStd
+{
+	namespace ThreadPoolImpl
+	{
+		class Scheduler;
+	}
+
+	/**
+	 * \brief Notify when sockets or file descriptors are ready
+	 *
+	 * A single thread waits for all the file descriptors registered, and sets
+	 * the future of the ones ready. The continuations chained on these futures
+	 * run on the scheduler given, so that many logical tasks waiting for I/O
+	 * share a few threads instead of blocking one each.
+	 *
+	 * There can be one reader and one writer waiting per file descriptor.
+	 *
+	 * \note This uses epoll, on Linux only.
+	 */
+	class Reactor
+	{
+	public:
+		/**
+		 * \param pScheduler Scheduler running the continuations, they run on
+		 *        the reactor thread if nullptr.
+		 */
+		explicit Reactor(ThreadPoolImpl::Scheduler* const pScheduler = nullptr);
+		~Reactor();
+
+		Reactor(const Reactor&) = delete;
+		Reactor& operator=(const Reactor&) = delete;
+
+		/**
+		 * \brief Future set once fd can be read without blocking, or is closed
+		 */
+		Future<void> whenReadable(const int fd);
+
+		/**
+		 * \brief Future set once fd can be written without blocking, or is closed
+		 */
+		Future<void> whenWritable(const int fd);
+
+		/**
+		 * \brief Stop waiting for a file descriptor, before closing it
+		 *
+		 * The futures pending on it are set with an exception.
+		 */
+		void cancel(const int fd);
+
+	private:
+		struct Waiter
+		{
+			std::unique_ptr<Promise<void>> m_pRead;
+			std::unique_ptr<Promise<void>> m_pWrite;
+		};
+
+		Future<void> when(const int fd, const bool isRead);
+
+		/**
+		 * Register the events still awaited for fd, the lock must be held
+		 */
+		bool arm(const int fd, const Waiter& waiter, const bool isNew) noexcept;
+
+		void process();
+
+		ThreadPoolImpl::Scheduler* const m_pScheduler;
+		int m_epollFd;
+		// Written to wake up the reactor thread
+		int m_wakeFd;
+		std::atomic<bool> m_isStopping;
+		std::mutex m_mutex;
+		std::unordered_map<int, Waiter> m_waiterMap;
+		std::thread::id m_threadId;
+	};
+}
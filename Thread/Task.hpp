@@ -0,0 +1,226 @@
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <utility>
+
+#include "../Event.hpp"
+#include "Future.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * Coroutines are used when the compiler supports them (C++20), otherwise
+ * logical tasks are written as chains of Future::then.
+ */
+#if !defined(IRSTD_HAS_COROUTINES)
+	#if defined(__cpp_impl_coroutine) && defined(__has_include)
+		#if __has_include(<coroutine>)
+			#define IRSTD_HAS_COROUTINES 1
+		#endif
+	#endif
+#endif
+#if !defined(IRSTD_HAS_COROUTINES)
+	#define IRSTD_HAS_COROUTINES 0
+#endif
+
+#if IRSTD_HAS_COROUTINES
+	#include <coroutine>
+#endif
+
+namespace IrStd
+{
+	/**
+	 * \brief Future set with the counter at the next trigger of an event
+	 *
+	 * \param pScheduler Scheduler running the continuations, they run in the
+	 *        thread triggering the event if nullptr.
+	 */
+	inline Future<size_t> whenTriggered(Event& event, ThreadPoolImpl::Scheduler* const pScheduler = nullptr)
+	{
+		Promise<size_t> promise(pScheduler);
+		Future<size_t> future = promise.getFuture();
+		event.onNext([promise](const size_t counter) mutable {
+			promise.setValue(counter);
+		});
+		return future;
+	}
+
+#if IRSTD_HAS_COROUTINES
+	template<class T>
+	class Task;
+
+	namespace ThreadPoolImpl
+	{
+		/**
+		 * Suspend a coroutine until a future is set
+		 *
+		 * The coroutine resumes on the scheduler of the future, or in the
+		 * thread setting it if it has none.
+		 */
+		template<class T>
+		class FutureAwaiter
+		{
+		public:
+			explicit FutureAwaiter(const Future<T>& future) noexcept
+					: m_future(future)
+			{
+			}
+
+			bool await_ready() const noexcept
+			{
+				return m_future.isReady();
+			}
+
+			void await_suspend(std::coroutine_handle<> handle)
+			{
+				m_future.getState().addContinuation([handle]() {
+					handle.resume();
+				});
+			}
+
+			T await_resume() const
+			{
+				return m_future.get();
+			}
+
+		private:
+			const Future<T> m_future;
+		};
+
+		/**
+		 * Resume a coroutine as a job of a scheduler
+		 */
+		class SchedulerAwaiter
+		{
+		public:
+			explicit SchedulerAwaiter(Scheduler& scheduler) noexcept
+					: m_scheduler(scheduler)
+			{
+			}
+
+			bool await_ready() const noexcept
+			{
+				return false;
+			}
+
+			void await_suspend(std::coroutine_handle<> handle)
+			{
+				m_scheduler.addJob([handle]() {
+					handle.resume();
+				});
+			}
+
+			void await_resume() const noexcept
+			{
+			}
+
+		private:
+			Scheduler& m_scheduler;
+		};
+
+		template<class T>
+		class TaskPromiseBase
+		{
+		public:
+			template<class U>
+			void return_value(U&& value)
+			{
+				m_promise.setValue(std::forward<U>(value));
+			}
+
+		protected:
+			Promise<T> m_promise;
+		};
+
+		template<>
+		class TaskPromiseBase<void>
+		{
+		public:
+			void return_void()
+			{
+				m_promise.setValue();
+			}
+
+		protected:
+			Promise<void> m_promise;
+		};
+	}
+
+	/**
+	 * \brief Coroutine whose result is available as a future
+	 *
+	 * The coroutine starts right away, in the calling thread, and runs until
+	 * its first suspension. It then resumes wherever the awaited future is
+	 * set, use \ref resumeOn to move it to a scheduler. The coroutine frame
+	 * releases itself once complete, the task only holds its result.
+	 *
+	 * \code
+	 * IrStd::Task<size_t> echo(IrStd::Reactor& reactor, int fd)
+	 * {
+	 *     co_await reactor.whenReadable(fd);
+	 *     ...
+	 * }
+	 * \endcode
+	 */
+	template<class T>
+	class Task
+	{
+	public:
+		class promise_type : public ThreadPoolImpl::TaskPromiseBase<T>
+		{
+		public:
+			Task get_return_object() const noexcept
+			{
+				return Task(this->m_promise.getFuture());
+			}
+
+			std::suspend_never initial_suspend() const noexcept
+			{
+				return {};
+			}
+
+			std::suspend_never final_suspend() const noexcept
+			{
+				return {};
+			}
+
+			void unhandled_exception()
+			{
+				this->m_promise.setException(std::current_exception());
+			}
+		};
+
+		const Future<T>& getFuture() const noexcept
+		{
+			return m_future;
+		}
+
+		ThreadPoolImpl::FutureAwaiter<T> operator co_await() const noexcept
+		{
+			return ThreadPoolImpl::FutureAwaiter<T>(m_future);
+		}
+
+	private:
+		explicit Task(const Future<T>& future) noexcept
+				: m_future(future)
+		{
+		}
+
+		Future<T> m_future;
+	};
+
+	template<class T>
+	ThreadPoolImpl::FutureAwaiter<T> operator co_await(const Future<T>& future) noexcept
+	{
+		return ThreadPoolImpl::FutureAwaiter<T>(future);
+	}
+
+	/**
+	 * \brief Continue the current coroutine as a job of the scheduler
+	 */
+	inline ThreadPoolImpl::SchedulerAwaiter resumeOn(ThreadPoolImpl::Scheduler& scheduler) noexcept
+	{
+		return ThreadPoolImpl::SchedulerAwaiter(scheduler);
+	}
+#endif
+}
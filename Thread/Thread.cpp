@@ -1,12 +1,44 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <thread>
 
 #include "../Thread.hpp"
 #include "../Compiler.hpp"
 
+#if IRSTD_IS_PLATFORM(LINUX)
+	#include <pthread.h>
+	#include <sched.h>
+	#include <unistd.h>
+	#include <time.h>
+	#include <sys/resource.h>
+	#include <sys/syscall.h>
+#endif
+
 IRSTD_TOPIC_REGISTER(IrStd, Thread);
 IRSTD_TOPIC_USE_ALIAS(IrStdThread, IrStd, Thread);
 
+namespace
+{
+	// Thread object of the calling thread, set while its function runs
+	thread_local IrStd::Thread* pCurrentThread = nullptr;
+
+	uint64_t getTimeNs() noexcept
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	uint64_t toNs(const struct timespec& time) noexcept
+	{
+		return static_cast<uint64_t>(time.tv_sec) * 1000000000ull + static_cast<uint64_t>(time.tv_nsec);
+	}
+#endif
+}
+
 // ---- IrStd::Thread ---------------------------------------------------------
 
 IrStd::Thread::Thread(const char* const pName)
@@ -14,7 +46,16 @@ IrStd::Thread::Thread(const char* const pName)
 		, m_isTerminate(false)
 		, m_event("ThreadWakeup")
 		, m_name(pName)
+		, m_systemId(0)
+		, m_statusTimeNs(0)
+		, m_activeTimeNs(0)
+		, m_idleTimeNs(0)
+		, m_nbJobs(0)
+		, m_isFinal(false)
+		, m_hasClock(false)
+		, m_clockId(0)
 {
+	std::memset(&m_final, 0, sizeof(m_final));
 }
 
 IrStd::Thread::~Thread()
@@ -38,6 +79,10 @@ void IrStd::Thread::sendTerminateSignal() noexcept
 void IrStd::Thread::terminate() noexcept
 {
 	sendTerminateSignal();
+	{
+		std::lock_guard<std::mutex> lock(m_clockLock);
+		m_hasClock = false;
+	}
 	m_thread.join();
 }
 
@@ -80,13 +125,130 @@ bool IrStd::Thread::isIdle() const noexcept
 bool IrStd::Thread::setIdle() noexcept
 {
 	Status expected = Status::ACTIVE;
-	return m_status.compare_exchange_weak(expected, Status::IDLE);
+	if (m_status.compare_exchange_strong(expected, Status::IDLE))
+	{
+		accountStatus(Status::ACTIVE);
+		return true;
+	}
+	return false;
 }
 
 bool IrStd::Thread::setActive() noexcept
 {
 	Status expected = Status::IDLE;
-	return m_status.compare_exchange_weak(expected, Status::ACTIVE);
+	if (m_status.compare_exchange_strong(expected, Status::ACTIVE))
+	{
+		accountStatus(Status::IDLE);
+		return true;
+	}
+	return false;
+}
+
+void IrStd::Thread::accountStatus(const Status previous) noexcept
+{
+	const uint64_t timeNs = getTimeNs();
+	const uint64_t previousTimeNs = m_statusTimeNs.exchange(timeNs, std::memory_order_relaxed);
+	// Not started yet
+	if (!previousTimeNs)
+	{
+		return;
+	}
+	auto& counter = (previous == Status::ACTIVE) ? m_activeTimeNs : m_idleTimeNs;
+	counter.fetch_add(timeNs - previousTimeNs, std::memory_order_relaxed);
+}
+
+void IrStd::Thread::getStatistics(Statistics& statistics) const noexcept
+{
+	if (m_isFinal.load(std::memory_order_acquire) || !readSystemStatistics(statistics))
+	{
+		// The statistics may have been frozen meanwhile
+		if (m_isFinal.load(std::memory_order_acquire))
+		{
+			statistics = m_final;
+		}
+		else
+		{
+			statistics.m_cpuTimeNs = 0;
+			statistics.m_nbVoluntarySwitches = 0;
+			statistics.m_nbInvoluntarySwitches = 0;
+		}
+	}
+
+	statistics.m_activeTimeNs = m_activeTimeNs.load(std::memory_order_relaxed);
+	statistics.m_idleTimeNs = m_idleTimeNs.load(std::memory_order_relaxed);
+	statistics.m_nbJobs = m_nbJobs.load(std::memory_order_relaxed);
+
+	// Add the time spent in the current status
+	const uint64_t statusTimeNs = m_statusTimeNs.load(std::memory_order_relaxed);
+	const uint64_t timeNs = getTimeNs();
+	if (statusTimeNs && timeNs > statusTimeNs)
+	{
+		switch (m_status.load())
+		{
+		case Status::ACTIVE:
+			statistics.m_activeTimeNs += timeNs - statusTimeNs;
+			break;
+		case Status::IDLE:
+			statistics.m_idleTimeNs += timeNs - statusTimeNs;
+			break;
+		case Status::TERMINATED:
+		default:
+			break;
+		}
+	}
+}
+
+bool IrStd::Thread::readSystemStatistics(Statistics& statistics) const noexcept
+{
+#if IRSTD_IS_PLATFORM(LINUX)
+	// From the thread itself, the system provides everything directly
+	if (pCurrentThread == this)
+	{
+		struct timespec time;
+		struct rusage usage;
+		if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) || getrusage(RUSAGE_THREAD, &usage))
+		{
+			return false;
+		}
+		statistics.m_cpuTimeNs = toNs(time);
+		statistics.m_nbVoluntarySwitches = static_cast<uint64_t>(usage.ru_nvcsw);
+		statistics.m_nbInvoluntarySwitches = static_cast<uint64_t>(usage.ru_nivcsw);
+		return true;
+	}
+
+	// The clock is read under the lock, terminate() takes it before joining
+	const int64_t systemId = m_systemId.load(std::memory_order_acquire);
+	{
+		std::lock_guard<std::mutex> lock(m_clockLock);
+		struct timespec time;
+		if (!m_hasClock || clock_gettime(static_cast<clockid_t>(m_clockId), &time))
+		{
+			return false;
+		}
+		statistics.m_cpuTimeNs = toNs(time);
+	}
+
+	// Context switches are only available through procfs
+	statistics.m_nbVoluntarySwitches = 0;
+	statistics.m_nbInvoluntarySwitches = 0;
+	std::ifstream file("/proc/self/task/" + std::to_string(systemId) + "/status");
+	std::string line;
+	while (std::getline(file, line))
+	{
+		unsigned long long value;
+		if (std::sscanf(line.c_str(), "voluntary_ctxt_switches: %llu", &value) == 1)
+		{
+			statistics.m_nbVoluntarySwitches = value;
+		}
+		else if (std::sscanf(line.c_str(), "nonvoluntary_ctxt_switches: %llu", &value) == 1)
+		{
+			statistics.m_nbInvoluntarySwitches = value;
+		}
+	}
+	return true;
+#else
+	return false;
+#endif
 }
 
 bool IrStd::Thread::sleep(const uint64_t timeMs) noexcept
@@ -113,6 +275,137 @@ const char* IrStd::Thread::getName() const noexcept
 	return m_name.c_str();
 }
 
+IrStd::Thread* IrStd::Thread::getCurrent() noexcept
+{
+	return pCurrentThread;
+}
+
+void IrStd::Thread::onStart() noexcept
+{
+	pCurrentThread = this;
+	m_statusTimeNs.store(getTimeNs(), std::memory_order_relaxed);
+#if IRSTD_IS_PLATFORM(LINUX)
+	m_systemId.store(static_cast<int64_t>(::syscall(SYS_gettid)), std::memory_order_release);
+	clockid_t clockId;
+	if (!pthread_getcpuclockid(pthread_self(), &clockId))
+	{
+		std::lock_guard<std::mutex> lock(m_clockLock);
+		m_clockId = static_cast<int64_t>(clockId);
+		m_hasClock = true;
+	}
+	// The name is limited to 16 characters including the terminating null
+	char name[16];
+	std::snprintf(name, sizeof(name), "%s", m_name.c_str());
+	pthread_setname_np(pthread_self(), name);
+#endif
+}
+
+void IrStd::Thread::onStop() noexcept
+{
+	accountStatus(m_status.load());
+	const bool isFinal = readSystemStatistics(m_final);
+	{
+		std::lock_guard<std::mutex> lock(m_clockLock);
+		m_hasClock = false;
+		m_isFinal.store(isFinal, std::memory_order_release);
+	}
+	pCurrentThread = nullptr;
+}
+
+bool IrStd::Thread::setAffinity(const std::vector<size_t>& cpuList) noexcept
+{
+#if IRSTD_IS_PLATFORM(LINUX)
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	for (const auto cpu : (cpuList.empty()) ? getCpuList() : cpuList)
+	{
+		if (cpu >= CPU_SETSIZE)
+		{
+			return false;
+		}
+		CPU_SET(cpu, &cpuSet);
+	}
+	return (pthread_setaffinity_np(m_thread.native_handle(), sizeof(cpuSet), &cpuSet) == 0);
+#else
+	return false;
+#endif
+}
+
+bool IrStd::Thread::setPolicy(const Policy policy, const int priority) noexcept
+{
+#if IRSTD_IS_PLATFORM(LINUX)
+	int systemPolicy = SCHED_OTHER;
+	switch (policy)
+	{
+	case Policy::OTHER:
+		systemPolicy = SCHED_OTHER;
+		break;
+	case Policy::FIFO:
+		systemPolicy = SCHED_FIFO;
+		break;
+	case Policy::ROUND_ROBIN:
+		systemPolicy = SCHED_RR;
+		break;
+	case Policy::BATCH:
+		systemPolicy = SCHED_BATCH;
+		break;
+	case Policy::IDLE:
+		systemPolicy = SCHED_IDLE;
+		break;
+	default:
+		return false;
+	}
+	struct sched_param param;
+	param.sched_priority = priority;
+	return (pthread_setschedparam(m_thread.native_handle(), systemPolicy, &param) == 0);
+#else
+	return false;
+#endif
+}
+
+bool IrStd::Thread::setNice(const int nice) noexcept
+{
+#if IRSTD_IS_PLATFORM(LINUX)
+	// On Linux the nice level applies to a single thread, identified by its system id
+	const int64_t systemId = m_systemId.load(std::memory_order_acquire);
+	if (!systemId)
+	{
+		return false;
+	}
+	return (::setpriority(PRIO_PROCESS, static_cast<id_t>(systemId), nice) == 0);
+#else
+	return false;
+#endif
+}
+
+std::vector<size_t> IrStd::Thread::getCpuList()
+{
+	std::vector<size_t> cpuList;
+#if IRSTD_IS_PLATFORM(LINUX)
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0)
+	{
+		for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+		{
+			if (CPU_ISSET(cpu, &cpuSet))
+			{
+				cpuList.push_back(cpu);
+			}
+		}
+	}
+#endif
+	if (cpuList.empty())
+	{
+		const size_t nbCpus = std::thread::hardware_concurrency();
+		for (size_t cpu = 0; cpu < ((nbCpus) ? nbCpus : 1); ++cpu)
+		{
+			cpuList.push_back(cpu);
+		}
+	}
+	return cpuList;
+}
+
 size_t IrStd::Thread::getHash(std::thread::id threadId) noexcept
 {
 	std::hash<std::thread::id> hasher;
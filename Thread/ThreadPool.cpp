@@ -0,0 +1,774 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <future>
+#include <string>
+
+#include "../Thread.hpp"
+#include "../Compiler.hpp"
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	#include <unistd.h>
+	#include <linux/futex.h>
+	#include <sys/syscall.h>
+#endif
+
+IRSTD_TOPIC_USE_ALIAS(IrStdThread, IrStd, Thread);
+
+namespace
+{
+	// Scheduler and worker index of the current thread, if it is a worker
+	thread_local const IrStd::ThreadPoolImpl::Scheduler* pCurrentScheduler = nullptr;
+	thread_local size_t currentWorkerIndex = 0;
+
+	// Order of the deadline heap, the earliest deadline on top
+	bool isLaterDeadline(const IrStd::ThreadPoolImpl::Job* const pA, const IrStd::ThreadPoolImpl::Job* const pB) noexcept
+	{
+		return pA->m_deadline > pB->m_deadline;
+	}
+
+	uint64_t getRandom(uint64_t& state) noexcept
+	{
+		// xorshift64
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	void futexWait(std::atomic<uint32_t>& value, const uint32_t expected, const uint64_t timeoutMs = 0) noexcept
+	{
+		struct timespec timeout;
+		timeout.tv_sec = static_cast<time_t>(timeoutMs / 1000);
+		timeout.tv_nsec = static_cast<long>((timeoutMs % 1000) * 1000000);
+		::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&value), FUTEX_WAIT_PRIVATE, expected,
+				(timeoutMs) ? &timeout : nullptr, nullptr, 0);
+	}
+
+	void futexWake(std::atomic<uint32_t>& value, const int nbThreads) noexcept
+	{
+		::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&value), FUTEX_WAKE_PRIVATE, nbThreads, nullptr, nullptr, 0);
+	}
+#endif
+}
+
+// ---- IrStd::ThreadPoolImpl::Parking ----------------------------------------
+
+IrStd::ThreadPoolImpl::Parking::Parking() noexcept
+		: m_epoch(0)
+		, m_nbWaiters(0)
+{
+}
+
+uint32_t IrStd::ThreadPoolImpl::Parking::prepareWait() noexcept
+{
+	m_nbWaiters.fetch_add(1, std::memory_order_seq_cst);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	return m_epoch.load(std::memory_order_relaxed);
+}
+
+void IrStd::ThreadPoolImpl::Parking::cancelWait() noexcept
+{
+	m_nbWaiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool IrStd::ThreadPoolImpl::Parking::wait(const uint32_t epoch, const uint64_t timeoutMs) noexcept
+{
+	const auto timeEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+#if IRSTD_IS_PLATFORM(LINUX)
+	// Returns immediately if a notification was sent since prepareWait
+	while (m_epoch.load(std::memory_order_acquire) == epoch)
+	{
+		if (!timeoutMs)
+		{
+			futexWait(m_epoch, epoch);
+			continue;
+		}
+		const auto timeLeft = std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd - std::chrono::steady_clock::now());
+		if (timeLeft.count() <= 0)
+		{
+			break;
+		}
+		futexWait(m_epoch, epoch, static_cast<uint64_t>(timeLeft.count()));
+	}
+#else
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		const auto isNotified = [&]() {
+			return m_epoch.load(std::memory_order_acquire) != epoch;
+		};
+		if (timeoutMs)
+		{
+			m_condition.wait_until(lock, timeEnd, isNotified);
+		}
+		else
+		{
+			m_condition.wait(lock, isNotified);
+		}
+	}
+#endif
+	m_nbWaiters.fetch_sub(1, std::memory_order_seq_cst);
+	// A notification sent until the waiter count is decremented is not lost
+	return m_epoch.load(std::memory_order_seq_cst) != epoch;
+}
+
+uint32_t IrStd::ThreadPoolImpl::Parking::getNbWaiters() const noexcept
+{
+	return m_nbWaiters.load(std::memory_order_relaxed);
+}
+
+void IrStd::ThreadPoolImpl::Parking::notifyOne() noexcept
+{
+	notifyMany(1);
+}
+
+void IrStd::ThreadPoolImpl::Parking::notifyAll() noexcept
+{
+	notifyMany(INT_MAX);
+}
+
+void IrStd::ThreadPoolImpl::Parking::notifyMany(const size_t nbThreads) noexcept
+{
+	// Pairs with prepareWait, either the waiter is seen or it sees the new work
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	const uint32_t nbWaiters = m_nbWaiters.load(std::memory_order_relaxed);
+	if (!nbWaiters || !nbThreads)
+	{
+		return;
+	}
+	// No need to wake up more threads than there are sleeping
+	const int nbWakeUps = static_cast<int>(std::min<size_t>(nbThreads, (nbWaiters < INT_MAX) ? nbWaiters : INT_MAX));
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	m_epoch.fetch_add(1, std::memory_order_release);
+	futexWake(m_epoch, nbWakeUps);
+#else
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_epoch.fetch_add(1, std::memory_order_release);
+	}
+	for (int i=0; i<nbWakeUps; ++i)
+	{
+		m_condition.notify_one();
+	}
+#endif
+}
+
+// ---- IrStd::ThreadPoolImpl::SharedStateBase --------------------------------
+
+namespace
+{
+	// Status of a shared state, waiters sleep on it while it is pending
+	constexpr uint32_t STATUS_PENDING = 0;
+	constexpr uint32_t STATUS_PENDING_WAITED = 1;
+	constexpr uint32_t STATUS_READY = 2;
+}
+
+IrStd::ThreadPoolImpl::SharedStateBase::SharedStateBase(Scheduler* const pScheduler) noexcept
+		: m_refCount(0)
+		, m_nbPromises(0)
+		, m_status(STATUS_PENDING)
+		, m_pScheduler(pScheduler)
+{
+	m_lock.clear();
+}
+
+IrStd::ThreadPoolImpl::SharedStateBase::~SharedStateBase()
+{
+}
+
+void IrStd::ThreadPoolImpl::SharedStateBase::lock() noexcept
+{
+	while (m_lock.test_and_set(std::memory_order_acquire))
+	{
+		std::this_thread::yield();
+	}
+}
+
+void IrStd::ThreadPoolImpl::SharedStateBase::unlock() noexcept
+{
+	m_lock.clear(std::memory_order_release);
+}
+
+void IrStd::ThreadPoolImpl::SharedStateBase::releasePromise() noexcept
+{
+	if (m_nbPromises.fetch_sub(1, std::memory_order_acq_rel) == 1 && !isReady())
+	{
+		try
+		{
+			setException(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+		}
+		catch (...)
+		{
+			// Continuations cannot propagate errors from a destructor
+		}
+	}
+}
+
+bool IrStd::ThreadPoolImpl::SharedStateBase::isReady() const noexcept
+{
+	return m_status.load(std::memory_order_acquire) == STATUS_READY;
+}
+
+void IrStd::ThreadPoolImpl::SharedStateBase::wait() noexcept
+{
+	uint32_t status = m_status.load(std::memory_order_acquire);
+	while (status != STATUS_READY)
+	{
+		// Let the thread setting the state know that it must wake up the waiters
+		if (status == STATUS_PENDING
+				&& !m_status.compare_exchange_weak(status, STATUS_PENDING_WAITED, std::memory_order_acquire))
+		{
+			continue;
+		}
+#if IRSTD_IS_PLATFORM(LINUX)
+		futexWait(m_status, STATUS_PENDING_WAITED);
+#else
+		std::this_thread::yield();
+#endif
+		status = m_status.load(std::memory_order_acquire);
+	}
+}
+
+void IrStd::ThreadPoolImpl::SharedStateBase::setException(const std::exception_ptr& exception)
+{
+	m_exception = exception;
+	complete();
+}
+
+void IrStd::ThreadPoolImpl::SharedStateBase::addContinuation(const std::function<void()>& fct, const bool isInline)
+{
+	lock();
+	if (m_status.load(std::memory_order_acquire) != STATUS_READY)
+	{
+		m_continuationList.push_back(Continuation{fct, isInline});
+		unlock();
+		return;
+	}
+	unlock();
+	run(fct, isInline);
+}
+
+void IrStd::ThreadPoolImpl::SharedStateBase::complete()
+{
+	std::vector<Continuation> continuationList;
+	lock();
+	const uint32_t status = m_status.exchange(STATUS_READY, std::memory_order_acq_rel);
+	IRSTD_ASSERT(IrStdThread, status != STATUS_READY, "The value is already set");
+	continuationList.swap(m_continuationList);
+	unlock();
+
+#if IRSTD_IS_PLATFORM(LINUX)
+	if (status == STATUS_PENDING_WAITED)
+	{
+		futexWake(m_status, INT_MAX);
+	}
+#endif
+
+	for (const auto& continuation : continuationList)
+	{
+		run(continuation.m_fct, continuation.m_isInline);
+	}
+}
+
+void IrStd::ThreadPoolImpl::SharedStateBase::run(const std::function<void()>& fct, const bool isInline)
+{
+	if (isInline || !m_pScheduler)
+	{
+		fct();
+	}
+	else
+	{
+		m_pScheduler->addJob(fct);
+	}
+}
+
+// ---- IrStd::ThreadPoolImpl::Scheduler --------------------------------------
+
+constexpr uint64_t IrStd::ThreadPoolImpl::Scheduler::DEFAULT_IDLE_TIMEOUT_MS;
+constexpr size_t IrStd::ThreadPoolImpl::Scheduler::NB_PRIORITIES;
+constexpr size_t IrStd::ThreadPoolImpl::Scheduler::STARVATION_PERIOD;
+
+IrStd::ThreadPoolImpl::Scheduler::Scheduler(const std::string& name, const size_t nbWorkers)
+		: Scheduler(name, nbWorkers, nbWorkers)
+{
+}
+
+IrStd::ThreadPoolImpl::Scheduler::Scheduler(const std::string& name, const size_t minWorkers, const size_t maxWorkers,
+		const uint64_t idleTimeoutMs)
+		: m_name(name)
+		, m_minWorkers(minWorkers)
+		, m_maxWorkers(maxWorkers)
+		, m_idleTimeoutMs(idleTimeoutMs)
+		, m_workerList(new Worker[maxWorkers])
+		, m_nbWorkers(0)
+		, m_nbSlots(0)
+		, m_isPinned(false)
+		, m_cpuList(IrStd::Thread::getCpuList())
+		, m_isStopping(false)
+		, m_nbQueued(0)
+		, m_nbPending(0)
+{
+	IRSTD_ASSERT(IrStdThread, minWorkers > 0, "A thread pool needs at least one worker");
+	IRSTD_ASSERT(IrStdThread, minWorkers <= maxWorkers, "The minimum number of workers (" << minWorkers
+			<< ") is greater than the maximum (" << maxWorkers << ")");
+	m_spawnLock.clear();
+	for (size_t priority=0; priority<NB_PRIORITIES; ++priority)
+	{
+		m_nbInjected[priority].store(0);
+		m_nbDeadlines[priority].store(0);
+	}
+
+	for (size_t i=0; i<m_maxWorkers; ++i)
+	{
+		m_workerList[i].m_slot.store(Slot::FREE);
+		m_workerList[i].m_randomState = 0x9e3779b97f4a7c15ull * (i + 1);
+		m_workerList[i].m_nbFinds = 0;
+	}
+
+	// Initialize the threads
+	while (m_spawnLock.test_and_set(std::memory_order_acquire))
+	{
+	}
+	for (size_t i=0; i<m_minWorkers; ++i)
+	{
+		spawn();
+	}
+	m_spawnLock.clear(std::memory_order_release);
+}
+
+IrStd::ThreadPoolImpl::Scheduler::~Scheduler()
+{
+	// Wait for a worker being spawned
+	while (m_spawnLock.test_and_set(std::memory_order_acquire))
+	{
+		std::this_thread::yield();
+	}
+
+	// Delete existing workers
+	m_isStopping.store(true);
+	for (size_t i=0; i<m_nbSlots; ++i)
+	{
+		if (m_workerList[i].m_slot.load() == Slot::RUNNING)
+		{
+			IrStd::Threads::get(m_workerList[i].m_id)->sendTerminateSignal();
+		}
+	}
+	m_parking.notifyAll();
+	for (size_t i=0; i<m_nbSlots; ++i)
+	{
+		if (m_workerList[i].m_slot.load() != Slot::FREE)
+		{
+			IrStd::Threads::terminate(m_workerList[i].m_id);
+		}
+	}
+
+	// Discard the jobs not executed, their promises are broken. This runs the
+	// continuations of their futures, which can add jobs in turn.
+	std::vector<Job*> jobList;
+	do
+	{
+		jobList.clear();
+		{
+			std::unique_lock<std::mutex> lock(m_injectionMutex);
+			for (size_t priority=0; priority<NB_PRIORITIES; ++priority)
+			{
+				for (size_t i=0; i<m_nbSlots; ++i)
+				{
+					Job* pJob;
+					while (m_workerList[i].m_dequeList[priority].pop(pJob))
+					{
+						jobList.push_back(pJob);
+					}
+				}
+				jobList.insert(jobList.end(), m_injectionList[priority].begin(), m_injectionList[priority].end());
+				m_injectionList[priority].clear();
+				jobList.insert(jobList.end(), m_deadlineList[priority].begin(), m_deadlineList[priority].end());
+				m_deadlineList[priority].clear();
+			}
+		}
+		for (auto pJob : jobList)
+		{
+			delete pJob;
+		}
+	} while (!jobList.empty());
+}
+
+size_t IrStd::ThreadPoolImpl::Scheduler::getNbWorkers() const noexcept
+{
+	return m_nbWorkers.load(std::memory_order_relaxed);
+}
+
+size_t IrStd::ThreadPoolImpl::Scheduler::getMinWorkers() const noexcept
+{
+	return m_minWorkers;
+}
+
+size_t IrStd::ThreadPoolImpl::Scheduler::getMaxWorkers() const noexcept
+{
+	return m_maxWorkers;
+}
+
+size_t IrStd::ThreadPoolImpl::Scheduler::getHardwareConcurrency() noexcept
+{
+	const size_t nbThreads = std::thread::hardware_concurrency();
+	return (nbThreads) ? nbThreads : 1;
+}
+
+void IrStd::ThreadPoolImpl::Scheduler::setPinned(const bool isPinned)
+{
+	// Workers are not spawned or joined meanwhile
+	while (m_spawnLock.test_and_set(std::memory_order_acquire))
+	{
+		std::this_thread::yield();
+	}
+	m_isPinned.store(isPinned);
+	for (size_t i=0; i<m_nbSlots; ++i)
+	{
+		if (m_workerList[i].m_slot.load() == Slot::RUNNING)
+		{
+			auto pThread = IrStd::Threads::get(m_workerList[i].m_id);
+			if (pThread)
+			{
+				pin(*pThread, i);
+			}
+		}
+	}
+	m_spawnLock.clear(std::memory_order_release);
+}
+
+bool IrStd::ThreadPoolImpl::Scheduler::isPinned() const noexcept
+{
+	return m_isPinned.load();
+}
+
+void IrStd::ThreadPoolImpl::Scheduler::pin(Thread& thread, const size_t index)
+{
+	const bool isPinned = m_isPinned.load();
+	// Unpinned workers run on all the CPUs of the pool
+	const std::vector<size_t> cpuList = (isPinned)
+			? std::vector<size_t>{m_cpuList[index % m_cpuList.size()]} : m_cpuList;
+	if (!thread.setAffinity(cpuList))
+	{
+		IRSTD_LOG_WARNING(IrStdThread, "Cannot " << ((isPinned) ? "pin" : "unpin") << " worker " << thread.getName());
+	}
+}
+
+void IrStd::ThreadPoolImpl::Scheduler::spawn()
+{
+	// Find a free slot, or one whose thread exited
+	size_t index = 0;
+	while (index < m_maxWorkers && m_workerList[index].m_slot.load(std::memory_order_acquire) == Slot::RUNNING)
+	{
+		++index;
+	}
+	IRSTD_ASSERT(IrStdThread, index < m_maxWorkers, "No slot available");
+	Worker& worker = m_workerList[index];
+	if (worker.m_slot.load(std::memory_order_acquire) == Slot::RETIRED)
+	{
+		IrStd::Threads::terminate(worker.m_id);
+	}
+
+	worker.m_slot.store(Slot::RUNNING, std::memory_order_release);
+	m_nbWorkers.fetch_add(1);
+	if (index >= m_nbSlots.load(std::memory_order_relaxed))
+	{
+		m_nbSlots.store(index + 1, std::memory_order_release);
+	}
+
+	std::string workerName(m_name);
+	workerName += "::";
+	workerName += IrStd::Type::ShortString(index + 1);
+	worker.m_id = IrStd::Threads::create(workerName.c_str(), &Scheduler::process, this, index);
+}
+
+bool IrStd::ThreadPoolImpl::Scheduler::grow()
+{
+	// Only if the jobs waiting outnumber the workers, sleeping workers are about to take some already
+	const size_t nbWorkers = m_nbWorkers.load(std::memory_order_relaxed);
+	if (nbWorkers >= m_maxWorkers || m_nbQueued.load(std::memory_order_relaxed) <= nbWorkers)
+	{
+		return false;
+	}
+	// A single thread spawns at a time, the others carry on
+	if (m_spawnLock.test_and_set(std::memory_order_acquire))
+	{
+		return false;
+	}
+	const bool isSpawn = (!m_isStopping.load() && m_nbWorkers.load() < m_maxWorkers);
+	if (isSpawn)
+	{
+		spawn();
+	}
+	m_spawnLock.clear(std::memory_order_release);
+	return isSpawn;
+}
+
+bool IrStd::ThreadPoolImpl::Scheduler::retire() noexcept
+{
+	size_t nbWorkers = m_nbWorkers.load();
+	while (nbWorkers > m_minWorkers)
+	{
+		if (m_nbWorkers.compare_exchange_weak(nbWorkers, nbWorkers - 1))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+IrStd::ThreadPoolImpl::Scheduler::Worker* IrStd::ThreadPoolImpl::Scheduler::getCurrentWorker() noexcept
+{
+	return (pCurrentScheduler == this) ? &m_workerList[currentWorkerIndex] : nullptr;
+}
+
+void IrStd::ThreadPoolImpl::Scheduler::addJob(const std::function<void()>& job, const Priority priority,
+		const uint64_t deadlineMs)
+{
+	const size_t index = static_cast<size_t>(priority);
+	IRSTD_ASSERT(IrStdThread, index < NB_PRIORITIES, "Invalid priority: " << index);
+
+	Job* const pJob = new Job(job, priority, (deadlineMs)
+			? std::chrono::steady_clock::now() + std::chrono::milliseconds(deadlineMs) : Job::Deadline::max());
+	m_nbPending.fetch_add(1, std::memory_order_relaxed);
+	m_nbQueued.fetch_add(1, std::memory_order_relaxed);
+
+	Worker* const pWorker = (deadlineMs) ? nullptr : getCurrentWorker();
+	if (deadlineMs)
+	{
+		std::unique_lock<std::mutex> lock(m_injectionMutex);
+		m_deadlineList[index].push_back(pJob);
+		std::push_heap(m_deadlineList[index].begin(), m_deadlineList[index].end(), isLaterDeadline);
+		m_nbDeadlines[index].fetch_add(1, std::memory_order_release);
+	}
+	else if (pWorker)
+	{
+		pWorker->m_dequeList[index].push(pJob);
+	}
+	else
+	{
+		std::unique_lock<std::mutex> lock(m_injectionMutex);
+		m_injectionList[index].push_back(pJob);
+		m_nbInjected[index].fetch_add(1, std::memory_order_release);
+	}
+
+	m_parking.notifyOne();
+	if (m_minWorkers != m_maxWorkers)
+	{
+		grow();
+	}
+}
+
+void IrStd::ThreadPoolImpl::Scheduler::addJobs(Job* const* const pJobList, const size_t nbJobs, const Priority priority)
+{
+	if (!nbJobs)
+	{
+		return;
+	}
+	const size_t index = static_cast<size_t>(priority);
+	IRSTD_ASSERT(IrStdThread, index < NB_PRIORITIES, "Invalid priority: " << index);
+
+	m_nbPending.fetch_add(nbJobs, std::memory_order_relaxed);
+	m_nbQueued.fetch_add(nbJobs, std::memory_order_relaxed);
+
+	Worker* const pWorker = getCurrentWorker();
+	if (pWorker)
+	{
+		for (size_t i=0; i<nbJobs; ++i)
+		{
+			pWorker->m_dequeList[index].push(pJobList[i]);
+		}
+	}
+	else
+	{
+		std::unique_lock<std::mutex> lock(m_injectionMutex);
+		m_injectionList[index].insert(m_injectionList[index].end(), pJobList, pJobList + nbJobs);
+		m_nbInjected[index].fetch_add(nbJobs, std::memory_order_release);
+	}
+
+	// From a worker, it takes one of the jobs itself
+	m_parking.notifyMany((pWorker) ? nbJobs - 1 : nbJobs);
+	if (m_minWorkers != m_maxWorkers)
+	{
+		for (size_t i=0; i<nbJobs && grow(); ++i)
+		{
+		}
+	}
+}
+
+size_t IrStd::ThreadPoolImpl::Scheduler::getNbPendingJobs() const noexcept
+{
+	return m_nbQueued.load(std::memory_order_relaxed);
+}
+
+void IrStd::ThreadPoolImpl::Scheduler::waitForAllJobsToBeCompleted() noexcept
+{
+	IRSTD_ASSERT(IrStdThread, pCurrentScheduler != this, "A worker cannot wait for its own pool");
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_triggerComplete.wait(lock, [&]() {
+		return m_nbPending.load() == 0;
+	});
+}
+
+IrStd::ThreadPoolImpl::Job* IrStd::ThreadPoolImpl::Scheduler::popDeadline(const size_t priority) noexcept
+{
+	if (!m_nbDeadlines[priority].load(std::memory_order_acquire))
+	{
+		return nullptr;
+	}
+	std::unique_lock<std::mutex> lock(m_injectionMutex);
+	auto& deadlineList = m_deadlineList[priority];
+	if (deadlineList.empty())
+	{
+		return nullptr;
+	}
+	std::pop_heap(deadlineList.begin(), deadlineList.end(), isLaterDeadline);
+	Job* const pJob = deadlineList.back();
+	deadlineList.pop_back();
+	m_nbDeadlines[priority].fetch_sub(1, std::memory_order_relaxed);
+	return pJob;
+}
+
+IrStd::ThreadPoolImpl::Job* IrStd::ThreadPoolImpl::Scheduler::popInjected(const size_t priority) noexcept
+{
+	if (!m_nbInjected[priority].load(std::memory_order_acquire))
+	{
+		return nullptr;
+	}
+	std::unique_lock<std::mutex> lock(m_injectionMutex);
+	auto& injectionList = m_injectionList[priority];
+	if (injectionList.empty())
+	{
+		return nullptr;
+	}
+	Job* const pJob = injectionList.front();
+	injectionList.pop_front();
+	m_nbInjected[priority].fetch_sub(1, std::memory_order_relaxed);
+	return pJob;
+}
+
+IrStd::ThreadPoolImpl::Job* IrStd::ThreadPoolImpl::Scheduler::steal(Worker& worker, const size_t priority) noexcept
+{
+	// Start from a random victim, so that thieves spread over the workers
+	const size_t nbSlots = m_nbSlots.load(std::memory_order_acquire);
+	const size_t start = static_cast<size_t>(getRandom(worker.m_randomState) % nbSlots);
+	for (size_t i=0; i<nbSlots; ++i)
+	{
+		Worker& victim = m_workerList[(start + i) % nbSlots];
+		if (&victim == &worker)
+		{
+			continue;
+		}
+		Job* pJob;
+		if (victim.m_dequeList[priority].steal(pJob))
+		{
+			return pJob;
+		}
+	}
+	return nullptr;
+}
+
+IrStd::ThreadPoolImpl::Job* IrStd::ThreadPoolImpl::Scheduler::findJob(Worker& worker) noexcept
+{
+	Job* pJob;
+
+	// Once in a while, the lowest priority class goes first so that it cannot starve
+	const bool isLowestFirst = ((++worker.m_nbFinds % STARVATION_PERIOD) == 0);
+	const auto getPriority = [isLowestFirst](const size_t i) {
+		return (isLowestFirst) ? NB_PRIORITIES - 1 - i : i;
+	};
+
+	// Deadlines and local jobs first, then stealing, within each the higher priority classes first
+	for (size_t i=0; i<NB_PRIORITIES; ++i)
+	{
+		const size_t priority = getPriority(i);
+		pJob = popDeadline(priority);
+		if (pJob)
+		{
+			return pJob;
+		}
+		if (worker.m_dequeList[priority].pop(pJob))
+		{
+			return pJob;
+		}
+		pJob = popInjected(priority);
+		if (pJob)
+		{
+			return pJob;
+		}
+	}
+	for (size_t i=0; i<NB_PRIORITIES; ++i)
+	{
+		pJob = steal(worker, getPriority(i));
+		if (pJob)
+		{
+			return pJob;
+		}
+	}
+	return nullptr;
+}
+
+void IrStd::ThreadPoolImpl::Scheduler::run(Job* const pJob, Thread& thread)
+{
+	m_nbQueued.fetch_sub(1, std::memory_order_relaxed);
+	pJob->m_fct();
+	delete pJob;
+
+	// Counted before the job is completed, so that it shows once waitForAllJobsToBeCompleted() returns
+	thread.addJob();
+	if (m_nbPending.fetch_sub(1) == 1)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_triggerComplete.notify_all();
+	}
+}
+
+void IrStd::ThreadPoolImpl::Scheduler::process(const size_t index)
+{
+	pCurrentScheduler = this;
+	currentWorkerIndex = index;
+	Worker& worker = m_workerList[index];
+	IrStd::Thread* const pThread = IrStd::Thread::getCurrent();
+	if (m_isPinned.load())
+	{
+		pin(*pThread, index);
+	}
+
+	while (!m_isStopping.load(std::memory_order_relaxed))
+	{
+		Job* pJob = findJob(worker);
+		if (!pJob)
+		{
+			// Check one last time before sleeping, a job added meanwhile would wake this worker up
+			const uint32_t epoch = m_parking.prepareWait();
+			pJob = (m_isStopping.load()) ? nullptr : findJob(worker);
+			if (!pJob)
+			{
+				if (m_isStopping.load())
+				{
+					m_parking.cancelWait();
+					break;
+				}
+				pThread->setIdle();
+				const bool isNotified = m_parking.wait(epoch, (m_minWorkers != m_maxWorkers) ? m_idleTimeoutMs : 0);
+				pThread->setActive();
+				// Idle for too long, its deque is empty as only this worker pushes to it
+				if (!isNotified && retire())
+				{
+					pCurrentScheduler = nullptr;
+					worker.m_slot.store(Slot::RETIRED, std::memory_order_release);
+					return;
+				}
+				continue;
+			}
+			m_parking.cancelWait();
+		}
+
+		// Execute the function
+		run(pJob, *pThread);
+	}
+
+	pCurrentScheduler = nullptr;
+}
@@ -1,110 +1,474 @@
 #pragma once
 
-#include <array>
-#include <queue>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <vector>
 
+#include "../Allocator.hpp"
 #include "../Assert.hpp"
+#include "../Compiler.hpp"
 #include "../Thread.hpp"
 #include "../Type.hpp"
+#include "Future.hpp"
+#include "WorkStealingDeque.hpp"
 
 namespace IrStd
 {
-	template<size_t N>
-	class ThreadPool
+	namespace ThreadPoolImpl
 	{
-	public:
-		ThreadPool(const std::string& name)
+		/**
+		 * \brief Put threads to sleep until they are notified
+		 *
+		 * A thread must announce that it is going to sleep with \ref prepareWait,
+		 * check one last time for work, and then either \ref cancelWait or \ref wait.
+		 * A notification sent in between is never lost. Notifying is almost free
+		 * when nobody sleeps.
+		 *
+		 * \note On Linux the threads sleep on a futex, without any lock.
+		 */
+		class Parking
 		{
-			// Initialize the threads
-			for (size_t i=0; i<N; ++i)
-			{
-				std::string workerName(name);
-				workerName += "::";
-				workerName += IrStd::Type::ShortString(i + 1);
-				m_workerList[i] = IrStd::Threads::create(workerName.c_str(), &ThreadPool<N>::process, this);
-			}
-		}
+		public:
+			Parking() noexcept;
+
+			uint32_t prepareWait() noexcept;
+			void cancelWait() noexcept;
+
+			/**
+			 * \param timeoutMs Timeout in ms, 0 to wait forever.
+			 *
+			 * \return false if the timeout was reached without notification.
+			 */
+			bool wait(const uint32_t epoch, const uint64_t timeoutMs = 0) noexcept;
+
+			void notifyOne() noexcept;
+			void notifyAll() noexcept;
+
+			/**
+			 * Wake up to nbThreads threads, a single system call for all of them
+			 */
+			void notifyMany(const size_t nbThreads) noexcept;
+
+			/**
+			 * Number of threads sleeping or about to
+			 */
+			uint32_t getNbWaiters() const noexcept;
+
+		private:
+			std::atomic<uint32_t> m_epoch;
+			std::atomic<uint32_t> m_nbWaiters;
+#if !IRSTD_IS_PLATFORM(LINUX)
+			std::mutex m_mutex;
+			std::condition_variable m_condition;
+#endif
+		};
 
-		~ThreadPool()
+		/**
+		 * \brief Priority class of a job
+		 */
+		enum class Priority
+		{
+			HIGH = 0,
+			NORMAL,
+			LOW
+		};
+
+		class Job : public AllocatorImpl<AllocatorObjectPool<Job>>
 		{
-			// Delete existing workers
-			for (size_t i=0; i<N; ++i)
+		public:
+			typedef std::chrono::steady_clock::time_point Deadline;
+
+			Job(const std::function<void()>& fct, const Priority priority, const Deadline deadline)
+					: m_fct(fct)
+					, m_priority(priority)
+					, m_deadline(deadline)
 			{
-				auto pThread = IrStd::Threads::get(m_workerList[i]);
-				pThread->sendTerminateSignal();
-				m_condition.notify_all();
-				pThread->terminate();
 			}
-		}
+
+			std::function<void()> m_fct;
+			const Priority m_priority;
+			// Deadline::max() if the job has no deadline
+			const Deadline m_deadline;
+		};
 
 		/**
-		 * Add a new job to the list
+		 * \brief State of a parallel for, shared by the threads running it
 		 */
-		void addJob(const std::function<void()>& job)
+		class ParallelFor
 		{
-			std::unique_lock<std::mutex> lock(m_mutex);
-			m_jobList.push(job);
-			m_condition.notify_one();
-		}
+		public:
+			ParallelFor(const size_t begin, const size_t end, const size_t grain)
+					: m_begin(begin)
+					, m_end(end)
+					, m_grain(grain)
+					, m_nbChunks((end - begin + grain - 1) / grain)
+					, m_next(0)
+					, m_nbDone(0)
+					, m_isException(false)
+			{
+			}
 
-		size_t getNbPendingJobs() const noexcept
-		{
-			std::unique_lock<std::mutex> lock(m_mutex);
-			return m_jobList.size();
-		}
+			size_t getNbChunks() const noexcept
+			{
+				return m_nbChunks;
+			}
+
+			Future<void> getFuture() const noexcept
+			{
+				return m_promise.getFuture();
+			}
+
+			/**
+			 * Process chunks until there is none left
+			 */
+			template<class F>
+			void run(F& fct)
+			{
+				for (size_t chunk = m_next.fetch_add(1); chunk < m_nbChunks; chunk = m_next.fetch_add(1))
+				{
+					const size_t first = m_begin + chunk * m_grain;
+					const size_t last = std::min(first + m_grain, m_end);
+					try
+					{
+						for (size_t i = first; i < last; ++i)
+						{
+							fct(i);
+						}
+					}
+					catch (...)
+					{
+						bool expected = false;
+						if (m_isException.compare_exchange_strong(expected, true))
+						{
+							m_exception = std::current_exception();
+						}
+					}
+					if (m_nbDone.fetch_add(1) + 1 == m_nbChunks)
+					{
+						complete();
+					}
+				}
+			}
+
+		private:
+			void complete()
+			{
+				if (m_exception)
+				{
+					m_promise.setException(m_exception);
+				}
+				else
+				{
+					m_promise.setValue();
+				}
+			}
+
+			const size_t m_begin;
+			const size_t m_end;
+			const size_t m_grain;
+			const size_t m_nbChunks;
+			std::atomic<size_t> m_next;
+			std::atomic<size_t> m_nbDone;
+			std::atomic<bool> m_isException;
+			std::exception_ptr m_exception;
+			Promise<void> m_promise;
+		};
 
 		/**
-		 * Wait until all pending jobs are completed. This function
-		 * will return only when there are no pending jobs left in the queue.
+		 * \brief Work-stealing scheduler
+		 *
+		 * Each worker owns a deque. Jobs added from a worker go to its own deque,
+		 * it runs the most recent ones first while idle workers steal the oldest
+		 * ones from random victims. Jobs added from other threads go through a
+		 * shared injection queue, which is only locked if it is not empty.
+		 * Workers without job sleep until a new job is added.
+		 *
+		 * Jobs of higher priority classes run first. Within a class, jobs with a
+		 * deadline run first, earliest deadline first, so a deadline never lets a
+		 * job overtake a higher class. To avoid starvation, every
+		 * STARVATION_PERIOD jobs a worker looks for the lowest priority class
+		 * first, so background jobs still progress under saturation.
+		 *
+		 * The number of workers is elastic, between a minimum and a maximum. A
+		 * worker is added when more jobs are waiting than there are workers, and
+		 * a worker exits after sleeping for the idle timeout.
 		 */
-		void waitForAllJobsToBeCompleted() noexcept
+		class Scheduler
 		{
-			std::mutex mutex;
-			std::unique_lock<std::mutex> lock(mutex);
+		public:
+			typedef ThreadPoolImpl::Priority Priority;
 
-			m_triggerComplete.wait(lock, [&]() {
-				return getNbPendingJobs() == 0;
-			});
-		}
+			static constexpr uint64_t DEFAULT_IDLE_TIMEOUT_MS = 5000;
+			static constexpr size_t NB_PRIORITIES = 3;
+			static constexpr size_t STARVATION_PERIOD = 32;
 
-	private:
-		void process()
-		{
-			auto pThread = IrStd::Threads::get();
+			/**
+			 * Create a scheduler with a fixed number of workers
+			 */
+			Scheduler(const std::string& name, const size_t nbWorkers);
 
-			// Infinite loop
-			while (true)
+			/**
+			 * Create a scheduler starting with minWorkers workers
+			 */
+			Scheduler(const std::string& name, const size_t minWorkers, const size_t maxWorkers,
+					const uint64_t idleTimeoutMs = DEFAULT_IDLE_TIMEOUT_MS);
+			~Scheduler();
+
+			Scheduler(const Scheduler&) = delete;
+			Scheduler& operator=(const Scheduler&) = delete;
+
+			/**
+			 * Add a new job to the list
+			 *
+			 * \param deadlineMs Time in ms from now by which the job should run,
+			 *        0 for none. A job with a deadline runs before the others
+			 *        of its priority class.
+			 */
+			void addJob(const std::function<void()>& job, const Priority priority = Priority::NORMAL,
+					const uint64_t deadlineMs = 0);
+
+			/**
+			 * \brief Add a batch of jobs at once
+			 *
+			 * The jobs are queued with a single lock, and only as many workers
+			 * as needed are woken up, with a single notification.
+			 *
+			 * \param first, last Range of functions callable without argument.
+			 */
+			template<class Iterator>
+			void addJobs(Iterator first, Iterator last, const Priority priority = Priority::NORMAL)
 			{
-				std::function<void()> job;
-				pThread->setIdle();
+				// Owned here until they are all queued, in case one of them fails
+				std::vector<std::unique_ptr<Job>> ownerList;
+				for (; first != last; ++first)
+				{
+					std::unique_ptr<Job> pJob(new Job(*first, priority, Job::Deadline::max()));
+					ownerList.push_back(std::move(pJob));
+				}
+				std::vector<Job*> jobList;
+				jobList.reserve(ownerList.size());
+				for (const auto& pJob : ownerList)
+				{
+					jobList.push_back(pJob.get());
+				}
+				addJobs(jobList.data(), jobList.size(), priority);
+				for (auto& pJob : ownerList)
+				{
+					pJob.release();
+				}
+			}
 
-				// Grab the first job from the list
+			/**
+			 * \brief Call fct(i) for each i in [begin, end), in parallel
+			 *
+			 * The range is split in chunks of grain indexes, taken one after the
+			 * other by the workers and by the calling thread, which returns once
+			 * all of them are processed. If a call throws, the first exception is
+			 * re-thrown here, after all the chunks are processed.
+			 *
+			 * \note This can be called from a worker.
+			 */
+			template<class F>
+			void parallelFor(const size_t begin, const size_t end, const size_t grain, F&& fct)
+			{
+				if (begin >= end)
 				{
-					std::unique_lock<std::mutex> lock(m_mutex);
-					m_condition.wait(lock, [&]() {
-						return !m_jobList.empty() || IrStd::Threads::isTerminated();
-					});
-					if (IrStd::Threads::isTerminated())
-					{
-						break;
-					}
-					IRSTD_ASSERT(!m_jobList.empty());
-					job = m_jobList.front();
-					m_jobList.pop();
+					return;
 				}
+				const size_t grainSize = (grain) ? grain : 1;
+				auto pContext = std::make_shared<ParallelFor>(begin, end, grainSize);
 
-				// Execute the function
-				pThread->setActive();
-				job();
-				m_triggerComplete.notify_one();
+				// The helpers reference fct, they can only use it before the last chunk completes
+				const std::function<void()> helper = [pContext, &fct]() {
+					pContext->run(fct);
+				};
+				const size_t nbHelpers = std::min(pContext->getNbChunks() - 1, m_maxWorkers);
+				std::vector<std::function<void()>> helperList(nbHelpers, helper);
+				addJobs(helperList.begin(), helperList.end());
+
+				pContext->run(fct);
+				pContext->getFuture().get();
 			}
+
+			/**
+			 * \brief Add a job and get a future on its result
+			 *
+			 * The continuations chained on the future also run on this pool.
+			 */
+			template<class F>
+			Future<decltype(std::declval<typename std::decay<F>::type&>()())> submit(F&& fct,
+					const Priority priority = Priority::NORMAL, const uint64_t deadlineMs = 0)
+			{
+				typedef typename std::decay<F>::type Function;
+				typedef decltype(std::declval<Function&>()()) R;
+
+				Promise<R> promise(this);
+				Future<R> future = promise.getFuture();
+				addJob(SubmitJob<R, Function>{promise, Function(std::forward<F>(fct))}, priority, deadlineMs);
+				return future;
+			}
+
+			/**
+			 * Number of jobs waiting to be executed
+			 */
+			size_t getNbPendingJobs() const noexcept;
+
+			/**
+			 * Wait until all the jobs added so far are completed, including
+			 * those added by the jobs themselves.
+			 *
+			 * \note This must not be called from a worker.
+			 */
+			void waitForAllJobsToBeCompleted() noexcept;
+
+			/**
+			 * Number of workers currently running
+			 */
+			size_t getNbWorkers() const noexcept;
+			size_t getMinWorkers() const noexcept;
+			size_t getMaxWorkers() const noexcept;
+
+			/**
+			 * Number of threads of the machine, at least 1
+			 */
+			static size_t getHardwareConcurrency() noexcept;
+
+			/**
+			 * \brief Pin each worker to its own CPU, or release them
+			 *
+			 * The CPUs are those the scheduler was created with, worker i runs on
+			 * the i-th of them, modulo their number. Workers spawned later are
+			 * pinned as well.
+			 */
+			void setPinned(const bool isPinned);
+			bool isPinned() const noexcept;
+
+		private:
+			enum class Slot
+			{
+				FREE = 0,
+				RUNNING,
+				// The thread exited but is not joined yet
+				RETIRED
+			};
+
+			struct Worker
+			{
+				// One deque per priority class
+				WorkStealingDeque<Job*> m_dequeList[NB_PRIORITIES];
+				std::atomic<Slot> m_slot;
+				std::thread::id m_id;
+				uint64_t m_randomState;
+				// Number of jobs looked for, for the starvation protection
+				size_t m_nbFinds;
+			};
+
+			void process(const size_t index);
+
+			/**
+			 * Add a worker if more jobs are waiting than there are workers
+			 *
+			 * \return true if a worker was added.
+			 */
+			bool grow();
+
+			/**
+			 * Start a worker on a free or retired slot, the spawn lock must be held
+			 */
+			void spawn();
+
+			/**
+			 * Decrease the number of workers if above the minimum
+			 *
+			 * \return true if the current worker must exit.
+			 */
+			bool retire() noexcept;
+
+			/**
+			 * Apply the pinning setting to a worker
+			 */
+			void pin(Thread& thread, const size_t index);
+
+			/**
+			 * Return the worker of this scheduler running the current thread, nullptr if none
+			 */
+			Worker* getCurrentWorker() noexcept;
+
+			/**
+			 * Queue the jobs, they are owned by the scheduler once this returns
+			 */
+			void addJobs(Job* const* const pJobList, const size_t nbJobs, const Priority priority);
+
+			Job* findJob(Worker& worker) noexcept;
+			Job* popDeadline(const size_t priority) noexcept;
+			Job* popInjected(const size_t priority) noexcept;
+			Job* steal(Worker& worker, const size_t priority) noexcept;
+			void run(Job* const pJob, Thread& thread);
+
+			const std::string m_name;
+			const size_t m_minWorkers;
+			const size_t m_maxWorkers;
+			const uint64_t m_idleTimeoutMs;
+			std::unique_ptr<Worker[]> m_workerList;
+			std::atomic<size_t> m_nbWorkers;
+			// Number of slots used so far, thieves look at those only
+			std::atomic<size_t> m_nbSlots;
+			std::atomic_flag m_spawnLock;
+			std::atomic<bool> m_isPinned;
+			const std::vector<size_t> m_cpuList;
+
+			// Jobs added from outside the workers, and jobs with a deadline as min-heaps
+			std::mutex m_injectionMutex;
+			std::deque<Job*> m_injectionList[NB_PRIORITIES];
+			std::atomic<size_t> m_nbInjected[NB_PRIORITIES];
+			std::vector<Job*> m_deadlineList[NB_PRIORITIES];
+			std::atomic<size_t> m_nbDeadlines[NB_PRIORITIES];
+
+			Parking m_parking;
+			std::atomic<bool> m_isStopping;
+
+			// Jobs added and not taken yet, and jobs added and not completed yet
+			std::atomic<size_t> m_nbQueued;
+			std::atomic<size_t> m_nbPending;
+			std::mutex m_mutex;
+			std::condition_variable m_triggerComplete;
+		};
+	}
+
+	/**
+	 * \brief Pool of N workers, or of an elastic number of workers if N is 0
+	 */
+	template<size_t N = 0>
+	class ThreadPool : public ThreadPoolImpl::Scheduler
+	{
+	public:
+		ThreadPool(const std::string& name)
+				: ThreadPoolImpl::Scheduler(name, N)
+		{
 		}
+	};
 
-		mutable std::mutex m_mutex;
-		std::array<std::thread::id, N> m_workerList;
-		std::queue<std::function<void()>> m_jobList;
-		std::condition_variable m_condition;
-		std::condition_variable m_triggerComplete;
+	template<>
+	class ThreadPool<0> : public ThreadPoolImpl::Scheduler
+	{
+	public:
+		/**
+		 * \param maxWorkers Maximum number of workers, the number of threads of the machine by default.
+		 * \param minWorkers Number of workers kept alive when idle.
+		 * \param idleTimeoutMs Time after which an idle worker exits.
+		 */
+		explicit ThreadPool(const std::string& name,
+				const size_t maxWorkers = ThreadPoolImpl::Scheduler::getHardwareConcurrency(),
+				const size_t minWorkers = 1,
+				const uint64_t idleTimeoutMs = ThreadPoolImpl::Scheduler::DEFAULT_IDLE_TIMEOUT_MS)
+				: ThreadPoolImpl::Scheduler(name, minWorkers, maxWorkers, idleTimeoutMs)
+		{
+		}
 	};
 }
@@ -3,9 +3,22 @@
 
 #include "../Thread.hpp"
 #include "../Compiler.hpp"
+#include "../Memory.hpp"
 
 IRSTD_TOPIC_USE_ALIAS(IrStdThread, IrStd, Thread);
 
+namespace
+{
+	/**
+	 * Return the Thread object if id is the calling thread, without locking the registry
+	 */
+	IrStd::Thread* getIfCurrent(const std::thread::id id) noexcept
+	{
+		IrStd::Thread* const pThread = IrStd::Thread::getCurrent();
+		return (pThread && id == std::this_thread::get_id()) ? pThread : nullptr;
+	}
+}
+
 // ---- IrStd::Threads --------------------------------------------------------
 
 void IrStd::Threads::each(const std::function<void(const Thread&)>& callback) noexcept
@@ -22,14 +35,18 @@ void IrStd::Threads::each(const std::function<void(const Thread&)>& callback) no
 
 bool IrStd::Threads::sleep(const uint64_t timeMs) noexcept
 {
-	const auto id = std::this_thread::get_id();
-	auto pThread = getInstance().get(id);
-	IRSTD_ASSERT(IrStdThread, pThread, "The thread (" << id << ") is not registered");
+	auto pThread = Thread::getCurrent();
+	IRSTD_ASSERT(IrStdThread, pThread, "The thread (" << std::this_thread::get_id() << ") is not registered");
 	return pThread->sleep(timeMs);
 }
 
 bool IrStd::Threads::isTerminated(std::thread::id id) noexcept
 {
+	if (auto pCurrent = getIfCurrent(id))
+	{
+		return pCurrent->isTerminated();
+	}
+
 	// Check if the thread is registered
 	auto& threads = IrStd::Threads::getInstance();
 	{
@@ -47,6 +64,11 @@ bool IrStd::Threads::isActive(std::thread::id id) noexcept
 
 bool IrStd::Threads::isRegistered(std::thread::id id) noexcept
 {
+	if (getIfCurrent(id))
+	{
+		return true;
+	}
+
 	auto& threads = IrStd::Threads::getInstance();
 	{
 		IRSTD_SCOPE(threads.m_lock);
@@ -56,6 +78,11 @@ bool IrStd::Threads::isRegistered(std::thread::id id) noexcept
 
 bool IrStd::Threads::setIdle(std::thread::id id) noexcept
 {
+	if (auto pCurrent = getIfCurrent(id))
+	{
+		return pCurrent->setIdle();
+	}
+
 	auto& threads = IrStd::Threads::getInstance();
 	{
 		IRSTD_SCOPE(threads.m_lock);
@@ -67,6 +94,11 @@ bool IrStd::Threads::setIdle(std::thread::id id) noexcept
 
 bool IrStd::Threads::setActive(std::thread::id id) noexcept
 {
+	if (auto pCurrent = getIfCurrent(id))
+	{
+		return pCurrent->setActive();
+	}
+
 	auto& threads = IrStd::Threads::getInstance();
 	{
 		IRSTD_SCOPE(threads.m_lock);
@@ -144,6 +176,11 @@ std::shared_ptr<IrStd::Thread> IrStd::Threads::getNoLock(std::thread::id id) noe
 
 std::shared_ptr<IrStd::Thread> IrStd::Threads::get(std::thread::id id) noexcept
 {
+	if (auto pCurrent = getIfCurrent(id))
+	{
+		return pCurrent->shared_from_this();
+	}
+
 	IRSTD_SCOPE(IrStd::Threads::getInstance().m_lock);
 	return IrStd::Threads::getInstance().getNoLock(id);
 }
@@ -176,6 +213,30 @@ void IrStd::Threads::toStreamImpl(std::ostream& os)
 		{
 			os << ", terminate=true";
 		}
+		{
+			Thread::Statistics stats;
+			item.second->getStatistics(stats);
+			const uint64_t totalTimeNs = stats.m_activeTimeNs + stats.m_idleTimeNs;
+			os << ", active=" << (stats.m_activeTimeNs / 1000000) << "ms"
+					<< ", idle=" << (stats.m_idleTimeNs / 1000000) << "ms"
+					<< ", cpu=" << (stats.m_cpuTimeNs / 1000000) << "ms";
+			if (totalTimeNs)
+			{
+				os << " (" << (stats.m_cpuTimeNs * 100 / totalTimeNs) << "%)";
+			}
+			os << ", switches=" << stats.m_nbVoluntarySwitches << "/" << stats.m_nbInvoluntarySwitches;
+			if (stats.m_nbJobs)
+			{
+				os << ", jobs=" << stats.m_nbJobs;
+			}
+		}
+		{
+			IrStd::Memory::Statistics stats;
+			if (IrStd::Memory::getInstance().getThreadStatistics(item.first, stats))
+			{
+				os << ", memory=" << stats.getStatCurrentRaw() << ".byte(s)";
+			}
+		}
 		os << std::endl;
 	}
 }
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace IrStd
+{
+	namespace ThreadPoolImpl
+	{
+		/**
+		 * \brief Chase-Lev work-stealing deque
+		 *
+		 * Only the owner thread can push and pop, at the bottom of the deque.
+		 * Any other thread can steal from the top. The owner therefore works on
+		 * the most recent items, which are most likely in its cache, while the
+		 * thieves take the oldest ones.
+		 *
+		 * The buffer grows when full. The previous buffers might still be read
+		 * by a thief, they are only released with the deque.
+		 *
+		 * \note T must be trivially copyable, pointers typically.
+		 */
+		template<class T>
+		class WorkStealingDeque
+		{
+		public:
+			static constexpr size_t INITIAL_CAPACITY = 256;
+
+			WorkStealingDeque()
+					: m_top(0)
+					, m_bottom(0)
+					, m_pArray(new Array(INITIAL_CAPACITY, nullptr))
+			{
+			}
+
+			~WorkStealingDeque()
+			{
+				Array* pArray = m_pArray.load(std::memory_order_relaxed);
+				while (pArray)
+				{
+					Array* const pPrevious = pArray->m_pPrevious;
+					delete pArray;
+					pArray = pPrevious;
+				}
+			}
+
+			WorkStealingDeque(const WorkStealingDeque&) = delete;
+			WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+			/**
+			 * \brief Push an item at the bottom, owner thread only
+			 */
+			void push(const T item)
+			{
+				const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+				const int64_t top = m_top.load(std::memory_order_acquire);
+				Array* pArray = m_pArray.load(std::memory_order_relaxed);
+				if (bottom - top > static_cast<int64_t>(pArray->m_mask))
+				{
+					pArray = grow(pArray, bottom, top);
+				}
+				pArray->put(bottom, item);
+				std::atomic_thread_fence(std::memory_order_release);
+				m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+
+			/**
+			 * \brief Pop an item from the bottom, owner thread only
+			 *
+			 * \return false if the deque is empty.
+			 */
+			bool pop(T& item) noexcept
+			{
+				const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+				Array* const pArray = m_pArray.load(std::memory_order_relaxed);
+				m_bottom.store(bottom, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t top = m_top.load(std::memory_order_relaxed);
+
+				if (top > bottom)
+				{
+					m_bottom.store(bottom + 1, std::memory_order_relaxed);
+					return false;
+				}
+
+				item = pArray->get(bottom);
+				if (top == bottom)
+				{
+					// Last item, race against the thieves
+					const bool isWon = m_top.compare_exchange_strong(top, top + 1,
+							std::memory_order_seq_cst, std::memory_order_relaxed);
+					m_bottom.store(bottom + 1, std::memory_order_relaxed);
+					return isWon;
+				}
+				return true;
+			}
+
+			/**
+			 * \brief Steal an item from the top, from any thread
+			 *
+			 * \return false if the deque is empty or if another thread won the race.
+			 */
+			bool steal(T& item) noexcept
+			{
+				int64_t top = m_top.load(std::memory_order_acquire);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+				if (top >= bottom)
+				{
+					return false;
+				}
+
+				Array* const pArray = m_pArray.load(std::memory_order_acquire);
+				item = pArray->get(top);
+				return m_top.compare_exchange_strong(top, top + 1,
+						std::memory_order_seq_cst, std::memory_order_relaxed);
+			}
+
+			/**
+			 * \brief Approximate number of items
+			 */
+			size_t size() const noexcept
+			{
+				const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+				const int64_t top = m_top.load(std::memory_order_relaxed);
+				return (bottom > top) ? static_cast<size_t>(bottom - top) : 0;
+			}
+
+			bool empty() const noexcept
+			{
+				return size() == 0;
+			}
+
+		private:
+			struct Array
+			{
+				Array(const size_t capacity, Array* const pPrevious)
+						: m_mask(capacity - 1)
+						, m_pItemList(new std::atomic<T>[capacity])
+						, m_pPrevious(pPrevious)
+				{
+				}
+
+				~Array()
+				{
+					delete[] m_pItemList;
+				}
+
+				T get(const int64_t index) const noexcept
+				{
+					return m_pItemList[static_cast<size_t>(index) & m_mask].load(std::memory_order_relaxed);
+				}
+
+				void put(const int64_t index, const T item) noexcept
+				{
+					m_pItemList[static_cast<size_t>(index) & m_mask].store(item, std::memory_order_relaxed);
+				}
+
+				const size_t m_mask;
+				std::atomic<T>* const m_pItemList;
+				Array* const m_pPrevious;
+			};
+
+			Array* grow(Array* const pArray, const int64_t bottom, const int64_t top)
+			{
+				Array* const pNewArray = new Array((pArray->m_mask + 1) * 2, pArray);
+				for (int64_t i = top; i < bottom; ++i)
+				{
+					pNewArray->put(i, pArray->get(i));
+				}
+				m_pArray.store(pNewArray, std::memory_order_release);
+				return pNewArray;
+			}
+
+			// The owner and the thieves write different ends, keep them on separate cache lines
+			std::atomic<int64_t> m_top;
+			char m_padding[64 - sizeof(std::atomic<int64_t>)];
+			std::atomic<int64_t> m_bottom;
+			std::atomic<Array*> m_pArray;
+		};
+
+		template<class T>
+		constexpr size_t WorkStealingDeque<T>::INITIAL_CAPACITY;
+	}
+}
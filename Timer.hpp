@@ -0,0 +1,204 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Allocator.hpp"
+#include "Topic.hpp"
+#include "Thread.hpp"
+
+IRSTD_TOPIC_USE(IrStd, Timer);
+
+namespace IrStd
+{
+	namespace TimerImpl
+	{
+		/**
+		 * \brief Link of a doubly linked list
+		 */
+		struct Node
+		{
+			Node* m_pPrevious;
+			Node* m_pNext;
+		};
+
+		/**
+		 * \brief A scheduled callback, linked in a slot of the wheel
+		 */
+		class Entry : public Node, public AllocatorImpl<AllocatorObjectPool<Entry>>
+		{
+		public:
+			Entry(const uint64_t id, const uint64_t expiry, const uint64_t period, const std::function<void()>& fct)
+					: Node{nullptr, nullptr}
+					, m_id(id)
+					, m_expiry(expiry)
+					, m_period(period)
+					, m_isCancelled(false)
+					, m_fct(fct)
+			{
+			}
+
+			const uint64_t m_id;
+			// Tick at which the callback runs, and the period in ticks, 0 if it runs once
+			uint64_t m_expiry;
+			const uint64_t m_period;
+			// Cancelled while its callback was dispatched
+			bool m_isCancelled;
+			const std::function<void()> m_fct;
+		};
+	}
+
+	/**
+	 * \brief Run callbacks after a delay or periodically, from a single thread
+	 *
+	 * The callbacks are kept in a hierarchical timer wheel: the first level has
+	 * one slot per tick, each of the next levels has slots covering a whole
+	 * turn of the previous level. Entries move down one level at a time when
+	 * their slot is reached. Adding and cancelling a callback are O(1).
+	 *
+	 * The timer thread only dispatches the callbacks, they run on the scheduler
+	 * if one is given, which must outlive the timer. Without a scheduler, they
+	 * run on the timer thread itself and must be short.
+	 */
+	class Timer
+	{
+	public:
+		typedef uint64_t Id;
+		static constexpr Id INVALID_ID = 0;
+
+		/**
+		 * \param pScheduler Scheduler running the callbacks, nullptr to run them
+		 *        on the timer thread.
+		 * \param resolutionMs Duration of a tick, the callbacks run at this precision.
+		 */
+		explicit Timer(ThreadPoolImpl::Scheduler* const pScheduler = nullptr, const uint64_t resolutionMs = 1);
+		~Timer();
+
+		Timer(const Timer&) = delete;
+		Timer& operator=(const Timer&) = delete;
+
+		/**
+		 * \brief Run a function once, after a delay
+		 */
+		Id once(const uint64_t delayMs, const std::function<void()>& fct);
+
+		/**
+		 * \brief Run a function periodically
+		 *
+		 * The runs are scheduled from the first one, they do not drift with the
+		 * time the callbacks take.
+		 *
+		 * \param delayMs Delay before the first run, a period if 0.
+		 */
+		Id every(const uint64_t periodMs, const std::function<void()>& fct, const uint64_t delayMs = 0);
+
+		/**
+		 * \brief Future set once a delay has elapsed
+		 *
+		 * Its continuations run on the scheduler of the timer. This is the
+		 * timer awaitable of the tasks, see IrStd::Task.
+		 */
+		Future<void> whenElapsed(const uint64_t delayMs);
+
+		/**
+		 * \brief Cancel a callback
+		 *
+		 * \note A callback already dispatched to the scheduler still runs. If it
+		 * is being dispatched, this waits until it is, so that no run is
+		 * dispatched once this returns (except when called from a callback
+		 * running on the timer thread).
+		 *
+		 * \return false if the callback ran already, or is unknown.
+		 */
+		bool cancel(const Id id);
+
+		/**
+		 * Number of callbacks scheduled
+		 */
+		size_t size() const;
+
+	private:
+		static constexpr size_t NB_LEVELS = 4;
+		// The first level has 256 slots, the others 64
+		static constexpr size_t LEVEL0_BITS = 8;
+		static constexpr size_t LEVEL_BITS = 6;
+		static constexpr uint64_t MAX_DELAY_TICKS = (1ull << (LEVEL0_BITS + (NB_LEVELS - 1) * LEVEL_BITS)) - 1;
+
+		/**
+		 * Circular list of entries, around a sentinel
+		 */
+		struct Slot
+		{
+			Slot() noexcept;
+			bool empty() const noexcept;
+			void push(TimerImpl::Entry* const pEntry) noexcept;
+			TimerImpl::Entry* pop() noexcept;
+			static void remove(TimerImpl::Entry* const pEntry) noexcept;
+
+			TimerImpl::Node m_sentinel;
+		};
+
+		Id schedule(const uint64_t delayMs, const uint64_t periodMs, const std::function<void()>& fct);
+
+		uint64_t getTick() const noexcept;
+		uint64_t toTicks(const uint64_t timeMs) const noexcept;
+
+		/**
+		 * Link an entry in the slot matching its expiry, the lock must be held
+		 */
+		void insert(TimerImpl::Entry* const pEntry) noexcept;
+
+		/**
+		 * Move the entries of a slot to the lower levels, the lock must be held
+		 */
+		void cascade(Slot& slot) noexcept;
+
+		/**
+		 * Move to the current tick at once if the wheel is empty, so that an idle
+		 * timer does not go through every tick elapsed. The lock must be held
+		 */
+		void skipIdleTicks() noexcept;
+
+		/**
+		 * Process the tick m_tick and move to the next one, the lock must be held
+		 */
+		void processTick(std::unique_lock<std::mutex>& lock);
+
+		/**
+		 * Next tick worth waking up for, the lock must be held
+		 */
+		uint64_t getNextTick() const noexcept;
+
+		void process();
+
+		ThreadPoolImpl::Scheduler* const m_pScheduler;
+		const std::chrono::milliseconds m_resolution;
+		const std::chrono::steady_clock::time_point m_start;
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_isStopping;
+		// Tick until which the timer thread sleeps
+		uint64_t m_wakeTick;
+
+		// Next tick to process
+		uint64_t m_tick;
+		Slot m_level0[1 << LEVEL0_BITS];
+		Slot m_levelList[NB_LEVELS - 1][1 << LEVEL_BITS];
+		std::unordered_map<Id, TimerImpl::Entry*> m_entryMap;
+		Id m_nextId;
+		// Entries being dispatched, used by the timer thread only
+		std::vector<TimerImpl::Entry*> m_expiredList;
+		// Set while the expired entries are dispatched without the lock
+		bool m_isDispatching;
+		std::condition_variable m_dispatchCondition;
+
+		std::thread::id m_threadId;
+	};
+}
@@ -0,0 +1,344 @@
+#include <limits>
+
+#include "../Timer.hpp"
+
+IRSTD_TOPIC_REGISTER(IrStd, Timer);
+IRSTD_TOPIC_USE_ALIAS(IrStdTimer, IrStd, Timer);
+
+namespace
+{
+	constexpr uint64_t NEVER = std::numeric_limits<uint64_t>::max();
+}
+
+// ---- IrStd::Timer::Slot ----------------------------------------------------
+
+IrStd::Timer::Slot::Slot() noexcept
+{
+	m_sentinel.m_pPrevious = &m_sentinel;
+	m_sentinel.m_pNext = &m_sentinel;
+}
+
+bool IrStd::Timer::Slot::empty() const noexcept
+{
+	return m_sentinel.m_pNext == &m_sentinel;
+}
+
+void IrStd::Timer::Slot::push(TimerImpl::Entry* const pEntry) noexcept
+{
+	pEntry->m_pPrevious = m_sentinel.m_pPrevious;
+	pEntry->m_pNext = &m_sentinel;
+	m_sentinel.m_pPrevious->m_pNext = pEntry;
+	m_sentinel.m_pPrevious = pEntry;
+}
+
+IrStd::TimerImpl::Entry* IrStd::Timer::Slot::pop() noexcept
+{
+	if (empty())
+	{
+		return nullptr;
+	}
+	auto pEntry = static_cast<TimerImpl::Entry*>(m_sentinel.m_pNext);
+	remove(pEntry);
+	return pEntry;
+}
+
+void IrStd::Timer::Slot::remove(TimerImpl::Entry* const pEntry) noexcept
+{
+	pEntry->m_pPrevious->m_pNext = pEntry->m_pNext;
+	pEntry->m_pNext->m_pPrevious = pEntry->m_pPrevious;
+	// Marks the entry as unlinked
+	pEntry->m_pPrevious = nullptr;
+	pEntry->m_pNext = nullptr;
+}
+
+// ---- IrStd::Timer ----------------------------------------------------------
+
+constexpr IrStd::Timer::Id IrStd::Timer::INVALID_ID;
+constexpr size_t IrStd::Timer::NB_LEVELS;
+constexpr size_t IrStd::Timer::LEVEL0_BITS;
+constexpr size_t IrStd::Timer::LEVEL_BITS;
+constexpr uint64_t IrStd::Timer::MAX_DELAY_TICKS;
+
+IrStd::Timer::Timer(ThreadPoolImpl::Scheduler* const pScheduler, const uint64_t resolutionMs)
+		: m_pScheduler(pScheduler)
+		, m_resolution((resolutionMs) ? resolutionMs : 1)
+		, m_start(std::chrono::steady_clock::now())
+		, m_isStopping(false)
+		, m_wakeTick(NEVER)
+		, m_tick(0)
+		, m_nextId(INVALID_ID + 1)
+		, m_isDispatching(false)
+{
+	m_threadId = IrStd::Threads::create("Timer", &Timer::process, this);
+}
+
+IrStd::Timer::~Timer()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_isStopping = true;
+	}
+	m_condition.notify_one();
+	IrStd::Threads::terminate(m_threadId);
+
+	// The remaining entries are all linked in a slot
+	for (auto& item : m_entryMap)
+	{
+		delete item.second;
+	}
+}
+
+uint64_t IrStd::Timer::getTick() const noexcept
+{
+	return static_cast<uint64_t>((std::chrono::steady_clock::now() - m_start) / m_resolution);
+}
+
+uint64_t IrStd::Timer::toTicks(const uint64_t timeMs) const noexcept
+{
+	const uint64_t resolutionMs = static_cast<uint64_t>(m_resolution.count());
+	return (timeMs + resolutionMs - 1) / resolutionMs;
+}
+
+IrStd::Timer::Id IrStd::Timer::once(const uint64_t delayMs, const std::function<void()>& fct)
+{
+	return schedule(delayMs, /*periodMs*/0, fct);
+}
+
+IrStd::Timer::Id IrStd::Timer::every(const uint64_t periodMs, const std::function<void()>& fct, const uint64_t delayMs)
+{
+	IRSTD_ASSERT(IrStdTimer, periodMs, "The period cannot be null");
+	return schedule((delayMs) ? delayMs : periodMs, periodMs, fct);
+}
+
+IrStd::Future<void> IrStd::Timer::whenElapsed(const uint64_t delayMs)
+{
+	Promise<void> promise(m_pScheduler);
+	Future<void> future = promise.getFuture();
+	once(delayMs, [promise]() mutable {
+		promise.setValue();
+	});
+	return future;
+}
+
+IrStd::Timer::Id IrStd::Timer::schedule(const uint64_t delayMs, const uint64_t periodMs, const std::function<void()>& fct)
+{
+	const uint64_t expiry = getTick() + toTicks(delayMs);
+	const uint64_t period = (periodMs) ? std::max<uint64_t>(toTicks(periodMs), 1) : 0;
+
+	bool isWakeUp = false;
+	Id id;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		skipIdleTicks();
+		id = m_nextId++;
+		auto pEntry = new TimerImpl::Entry(id, expiry, period, fct);
+		m_entryMap[id] = pEntry;
+		insert(pEntry);
+		// The timer thread sleeps past this entry
+		isWakeUp = (expiry < m_wakeTick);
+	}
+	if (isWakeUp)
+	{
+		m_condition.notify_one();
+	}
+	return id;
+}
+
+bool IrStd::Timer::cancel(const Id id)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	const auto it = m_entryMap.find(id);
+	if (it == m_entryMap.end())
+	{
+		return false;
+	}
+	auto pEntry = it->second;
+	m_entryMap.erase(it);
+
+	// Being dispatched, the timer thread releases it
+	if (!pEntry->m_pNext)
+	{
+		pEntry->m_isCancelled = true;
+		// A callback running inline on the timer thread would wait for itself
+		if (std::this_thread::get_id() != m_threadId)
+		{
+			m_dispatchCondition.wait(lock, [this]() { return !m_isDispatching; });
+		}
+		return true;
+	}
+	Slot::remove(pEntry);
+	delete pEntry;
+	return true;
+}
+
+size_t IrStd::Timer::size() const
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_entryMap.size();
+}
+
+void IrStd::Timer::insert(TimerImpl::Entry* const pEntry) noexcept
+{
+	// An entry already expired runs with the next tick
+	const uint64_t expiry = std::max(pEntry->m_expiry, m_tick);
+	const uint64_t delta = expiry - m_tick;
+
+	if (delta < (1ull << LEVEL0_BITS))
+	{
+		m_level0[expiry & ((1ull << LEVEL0_BITS) - 1)].push(pEntry);
+		return;
+	}
+
+	// Entries too far in the future are placed in the last slot, and placed again once reached
+	const uint64_t position = m_tick + std::min(delta, MAX_DELAY_TICKS);
+	size_t level = 1;
+	while (level < NB_LEVELS - 1 && delta >= (1ull << (LEVEL0_BITS + level * LEVEL_BITS)))
+	{
+		++level;
+	}
+	const size_t shift = LEVEL0_BITS + (level - 1) * LEVEL_BITS;
+	m_levelList[level - 1][(position >> shift) & ((1ull << LEVEL_BITS) - 1)].push(pEntry);
+}
+
+void IrStd::Timer::cascade(Slot& slot) noexcept
+{
+	while (auto pEntry = slot.pop())
+	{
+		insert(pEntry);
+	}
+}
+
+void IrStd::Timer::skipIdleTicks() noexcept
+{
+	// Nothing in the wheel, the ticks elapsed meanwhile have nothing to process
+	if (m_entryMap.empty())
+	{
+		m_tick = std::max(m_tick, getTick());
+	}
+}
+
+void IrStd::Timer::processTick(std::unique_lock<std::mutex>& lock)
+{
+	const uint64_t tick = m_tick;
+
+	// A turn of a level is complete, the next slot of the level above moves down
+	if (!(tick & ((1ull << LEVEL0_BITS) - 1)))
+	{
+		for (size_t level = 1; level < NB_LEVELS; ++level)
+		{
+			const size_t shift = LEVEL0_BITS + (level - 1) * LEVEL_BITS;
+			const size_t index = (tick >> shift) & ((1ull << LEVEL_BITS) - 1);
+			cascade(m_levelList[level - 1][index]);
+			if (index)
+			{
+				break;
+			}
+		}
+	}
+
+	// Collect the expired entries
+	auto& slot = m_level0[tick & ((1ull << LEVEL0_BITS) - 1)];
+	while (auto pEntry = slot.pop())
+	{
+		if (!pEntry->m_period)
+		{
+			m_entryMap.erase(pEntry->m_id);
+		}
+		m_expiredList.push_back(pEntry);
+	}
+	m_tick = tick + 1;
+	if (m_expiredList.empty())
+	{
+		return;
+	}
+
+	// Dispatch them without the lock, the callbacks can schedule or cancel
+	m_isDispatching = true;
+	lock.unlock();
+	for (auto pEntry : m_expiredList)
+	{
+		try
+		{
+			if (m_pScheduler)
+			{
+				m_pScheduler->addJob(pEntry->m_fct);
+			}
+			else
+			{
+				pEntry->m_fct();
+			}
+		}
+		catch (const std::exception& e)
+		{
+			IRSTD_LOG_ERROR(IrStdTimer, "Timer callback #" << pEntry->m_id << " failed: " << e.what());
+		}
+		catch (...)
+		{
+			IRSTD_LOG_ERROR(IrStdTimer, "Timer callback #" << pEntry->m_id << " failed with an unknown exception");
+		}
+	}
+	lock.lock();
+	m_isDispatching = false;
+	m_dispatchCondition.notify_all();
+
+	// Periodic entries are scheduled again, from their previous expiry
+	for (auto pEntry : m_expiredList)
+	{
+		if (!pEntry->m_period || pEntry->m_isCancelled)
+		{
+			delete pEntry;
+			continue;
+		}
+		pEntry->m_expiry += pEntry->m_period;
+		insert(pEntry);
+	}
+	m_expiredList.clear();
+}
+
+uint64_t IrStd::Timer::getNextTick() const noexcept
+{
+	if (m_entryMap.empty())
+	{
+		return NEVER;
+	}
+
+	// The first expiry within the current turn of the first level
+	const uint64_t mask = (1ull << LEVEL0_BITS) - 1;
+	const uint64_t turnEnd = (m_tick | mask) + 1;
+	for (uint64_t tick = m_tick; tick < turnEnd; ++tick)
+	{
+		if (!m_level0[tick & mask].empty())
+		{
+			return tick;
+		}
+	}
+	// Otherwise wake up for the next cascade
+	return turnEnd;
+}
+
+void IrStd::Timer::process()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_isStopping)
+	{
+		skipIdleTicks();
+
+		// Catch up with the time
+		if (m_tick <= getTick())
+		{
+			processTick(lock);
+			continue;
+		}
+
+		m_wakeTick = getNextTick();
+		if (m_wakeTick == NEVER)
+		{
+			m_condition.wait(lock);
+		}
+		else
+		{
+			m_condition.wait_until(lock, m_start + m_resolution * m_wakeTick);
+		}
+		m_wakeTick = NEVER;
+	}
+}
@@ -4,6 +4,7 @@
 #include <array>
 #include <atomic>
 
+#include "../Allocator.hpp"
 #include "../Assert.hpp"
 #include "../Topic.hpp"
 
@@ -15,9 +16,12 @@ namespace IrStd
 	{
 		/**
 		 * Lock free data structure
+		 *
+		 * When allocated dynamically, large buffers are placed on huge pages
+		 * (see \ref AllocatorLarge).
 		 */
 		template<class T, size_t N>
-		class RingBuffer
+		class RingBuffer : public IrStd::AllocatorImpl<IrStd::AllocatorLarge>
 		{
 		public:
 			RingBuffer()
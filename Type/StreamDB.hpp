@@ -5,6 +5,7 @@
 #pragma once
 
 #include "RingBufferSorted.hpp"
+#include "../Allocator.hpp"
 #include "../FileSystem.hpp"
 
 namespace IrStd
@@ -115,8 +116,12 @@ namespace IrStd
 			std::tuple<Types...> m_args;
 		};
 
+		/**
+		 * The cache is part of the object, when allocated dynamically it is placed
+		 * on huge pages (see \ref AllocatorLarge).
+		 */
 		template<class Entry, class EntryCache, size_t NB_DATA = 256, size_t CACHE = 1024 * 1024>
-		class StreamDB
+		class StreamDB : public IrStd::AllocatorImpl<IrStd::AllocatorLarge>
 		{
 		private:
 			static constexpr size_t NB_CACHE_ENTRIES = CACHE / sizeof(EntryCache) + 1;
@@ -0,0 +1,408 @@
+#include <thread>
+#include <vector>
+#include <map>
+
+#include "../Test.hpp"
+#include "../IrStd.hpp"
+
+class AllocatorTest : public IrStd::Test
+{
+public:
+	template<class A>
+	static uint64_t benchmark(const size_t nbThreads, const size_t nbLoops);
+};
+
+// ---- AllocatorTest::testPool -----------------------------------------------
+
+TEST_F(AllocatorTest, testPool)
+{
+	IrStd::AllocatorPool allocator;
+
+	// All the sizes must be aligned and usable
+	for (size_t size = 0; size <= IrStd::AllocatorPool::MAX_SIZE + 100; size += 7)
+	{
+		char* const ptr = static_cast<char*>(allocator.allocate(size));
+		ASSERT_TRUE(ptr != nullptr) << "size=" << size;
+		ASSERT_TRUE(reinterpret_cast<uintptr_t>(ptr) % IrStd::AllocatorPool::ALIGNMENT == 0)
+				<< "ptr=" << static_cast<void*>(ptr);
+		std::memset(ptr, 0xaa, size);
+		allocator.deallocate(ptr);
+	}
+
+	// Classes must be sorted
+	for (size_t i = 1; i < IrStd::AllocatorPool::getNbClasses(); ++i)
+	{
+		ASSERT_TRUE(IrStd::AllocatorPool::getClassSize(i - 1) < IrStd::AllocatorPool::getClassSize(i));
+	}
+
+	// Freed blocks must be re-used
+	{
+		void* const ptr1 = allocator.allocate(42);
+		allocator.deallocate(ptr1);
+		void* const ptr2 = allocator.allocate(42);
+		ASSERT_TRUE(ptr1 == ptr2) << "ptr1=" << ptr1 << ", ptr2=" << ptr2;
+		allocator.deallocate(ptr2);
+	}
+
+	ASSERT_TRUE(IrStd::AllocatorPool::getReservedMemory() >= IrStd::AllocatorPool::SLAB_SIZE);
+}
+
+// ---- AllocatorTest::testPoolContainer --------------------------------------
+
+class AllocatorTestPoolObject : public IrStd::AllocatorImpl<IrStd::AllocatorPool>
+{
+public:
+	AllocatorTestPoolObject(const int value)
+			: m_value(value)
+	{
+	}
+	int m_value;
+};
+
+TEST_F(AllocatorTest, testPoolContainer)
+{
+	{
+		std::vector<int, IrStd::AllocatorObj<int, IrStd::AllocatorPool>> vector;
+		for (int i = 0; i < 10000; ++i)
+		{
+			vector.push_back(i);
+		}
+		for (int i = 0; i < 10000; ++i)
+		{
+			ASSERT_TRUE(vector[static_cast<size_t>(i)] == i);
+		}
+	}
+
+	{
+		std::map<int, int, std::less<int>, IrStd::AllocatorObj<std::pair<const int, int>, IrStd::AllocatorPool>> map;
+		for (int i = 0; i < 1000; ++i)
+		{
+			map[i] = -i;
+		}
+		ASSERT_TRUE(map.size() == 1000);
+		ASSERT_TRUE(map[42] == -42);
+	}
+
+	{
+		auto pObject = new AllocatorTestPoolObject(12);
+		ASSERT_TRUE(pObject->m_value == 12);
+		delete pObject;
+	}
+}
+
+// ---- AllocatorTest::testPoolMultiThread ------------------------------------
+
+TEST_F(AllocatorTest, testPoolMultiThread)
+{
+	constexpr size_t NB_THREADS = 8;
+	constexpr size_t NB_ALLOCATIONS = 5000;
+	std::vector<void*> pointerList[NB_THREADS];
+	std::thread threadList[NB_THREADS];
+
+	// Allocate in some threads and release in others
+	for (size_t i = 0; i < NB_THREADS; ++i)
+	{
+		threadList[i] = std::thread([&pointerList, i]() {
+			IrStd::AllocatorPool allocator;
+			for (size_t j = 0; j < NB_ALLOCATIONS; ++j)
+			{
+				const size_t size = (j * 37) % (IrStd::AllocatorPool::MAX_SIZE / 4);
+				char* const ptr = static_cast<char*>(allocator.allocate(size));
+				std::memset(ptr, static_cast<int>(i), size);
+				pointerList[i].push_back(ptr);
+			}
+		});
+	}
+	for (size_t i = 0; i < NB_THREADS; ++i)
+	{
+		threadList[i].join();
+	}
+	for (size_t i = 0; i < NB_THREADS; ++i)
+	{
+		threadList[i] = std::thread([&pointerList, i]() {
+			IrStd::AllocatorPool allocator;
+			for (auto ptr : pointerList[(i + 1) % NB_THREADS])
+			{
+				allocator.deallocate(ptr);
+			}
+		});
+	}
+	for (size_t i = 0; i < NB_THREADS; ++i)
+	{
+		threadList[i].join();
+	}
+}
+
+// ---- AllocatorTest::benchmarkPool ------------------------------------------
+
+template<class A>
+uint64_t AllocatorTest::benchmark(const size_t nbThreads, const size_t nbLoops)
+{
+	constexpr size_t NB_LIVE = 64;
+	std::vector<std::thread> threadList;
+
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < nbThreads; ++i)
+	{
+		threadList.push_back(std::thread([nbLoops]() {
+			A allocator;
+			void* pointerList[NB_LIVE] = {nullptr};
+			for (size_t j = 0; j < nbLoops; ++j)
+			{
+				const size_t index = j % NB_LIVE;
+				allocator.deallocate(pointerList[index]);
+				pointerList[index] = allocator.allocate(16 + (j * 16) % 512);
+			}
+			for (size_t j = 0; j < NB_LIVE; ++j)
+			{
+				allocator.deallocate(pointerList[j]);
+			}
+		}));
+	}
+	for (auto& thread : threadList)
+	{
+		thread.join();
+	}
+	const auto duration = std::chrono::steady_clock::now() - start;
+
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()
+			/ static_cast<int64_t>(nbThreads * nbLoops));
+}
+
+TEST_F(AllocatorTest, benchmarkPool)
+{
+	constexpr size_t NB_LOOPS = 100000;
+	const size_t nbThreadsMax = std::max(static_cast<size_t>(2),
+			std::min(static_cast<size_t>(8), static_cast<size_t>(std::thread::hardware_concurrency())));
+
+	for (size_t nbThreads = 1; nbThreads <= nbThreadsMax; nbThreads *= 2)
+	{
+		const auto timeStd = benchmark<IrStd::AllocatorStd>(nbThreads, NB_LOOPS);
+		const auto timePool = benchmark<IrStd::AllocatorPool>(nbThreads, NB_LOOPS);
+		getStdout() << "threads=" << nbThreads << ", AllocatorStd=" << timeStd
+				<< "ns/op, AllocatorPool=" << timePool << "ns/op" << std::endl;
+	}
+}
+
+// ---- AllocatorTest::testArena ----------------------------------------------
+
+TEST_F(AllocatorTest, testArena)
+{
+	IrStd::AllocatorArena allocator;
+	const auto nbScopes = IrStd::Memory::getInstance().getArenaNbScopes();
+
+	// Without scope, the memory comes from the heap
+	{
+		ASSERT_TRUE(IrStd::ArenaScope::getCurrent() == nullptr);
+		void* const ptr = allocator.allocate(42);
+		ASSERT_TRUE(ptr != nullptr);
+		allocator.deallocate(ptr);
+	}
+
+	{
+		IrStd::ArenaScope scope(1024);
+		ASSERT_TRUE(IrStd::ArenaScope::getCurrent() == &scope);
+
+		for (size_t size = 0; size < 3000; size += 13)
+		{
+			char* const ptr = static_cast<char*>(allocator.allocate(size));
+			ASSERT_TRUE(ptr != nullptr) << "size=" << size;
+			ASSERT_TRUE(reinterpret_cast<uintptr_t>(ptr) % IrStd::AllocatorArena::ALIGNMENT == 0)
+					<< "ptr=" << static_cast<void*>(ptr);
+			std::memset(ptr, 0xaa, size);
+			allocator.deallocate(ptr);
+		}
+		ASSERT_TRUE(scope.getNbAllocations() == 231);
+		ASSERT_TRUE(scope.getReserved() >= scope.getAllocated());
+		ASSERT_TRUE(IrStd::Memory::getInstance().getArenaReserved() >= scope.getReserved());
+
+		// Nested scopes
+		{
+			IrStd::ArenaScope nestedScope;
+			ASSERT_TRUE(IrStd::ArenaScope::getCurrent() == &nestedScope);
+			IrStd::ArenaString str("Hello, this is a long string");
+			str.append(" World!");
+			ASSERT_TRUE(str == "Hello, this is a long string World!");
+			ASSERT_TRUE(nestedScope.getNbAllocations() > 0);
+		}
+		ASSERT_TRUE(IrStd::ArenaScope::getCurrent() == &scope);
+
+		// Only the last chunk must be kept
+		const auto reserved = scope.getReserved();
+		scope.reset();
+		ASSERT_TRUE(scope.getReserved() < reserved);
+		ASSERT_TRUE(allocator.allocate(10) != nullptr);
+	}
+
+	ASSERT_TRUE(IrStd::ArenaScope::getCurrent() == nullptr);
+	ASSERT_TRUE(IrStd::Memory::getInstance().getArenaNbScopes() == nbScopes + 2);
+	getStdout() << "Arena: reserved=" << IrStd::Memory::getInstance().getArenaReserved()
+			<< ", allocated=" << IrStd::Memory::getInstance().getArenaAllocated()
+			<< ", nb.allocations=" << IrStd::Memory::getInstance().getArenaNbAllocations() << std::endl;
+}
+
+// ---- AllocatorTest::testLarge ----------------------------------------------
+
+TEST_F(AllocatorTest, testLarge)
+{
+	IrStd::AllocatorLarge allocator;
+	const auto nbMappings = IrStd::AllocatorLarge::getNbMappings();
+	const auto mapped = IrStd::AllocatorLarge::getMapped();
+
+	for (const size_t size : {static_cast<size_t>(1), static_cast<size_t>(1000),
+			IrStd::AllocatorLarge::MMAP_THRESHOLD, IrStd::AllocatorLarge::HUGE_PAGE_SIZE,
+			3 * IrStd::AllocatorLarge::HUGE_PAGE_SIZE + 123})
+	{
+		char* const ptr = static_cast<char*>(allocator.allocate(size));
+		ASSERT_TRUE(ptr != nullptr) << "size=" << size;
+		ASSERT_TRUE(reinterpret_cast<uintptr_t>(ptr) % IrStd::AllocatorLarge::ALIGNMENT == 0)
+				<< "ptr=" << static_cast<void*>(ptr);
+		std::memset(ptr, 0xaa, size);
+
+		const bool isMapped = (size >= IrStd::AllocatorLarge::MMAP_THRESHOLD);
+		ASSERT_TRUE(IrStd::AllocatorLarge::getNbMappings() == nbMappings + ((isMapped) ? 1 : 0));
+		ASSERT_TRUE(IrStd::AllocatorLarge::getMapped() >= mapped + ((isMapped) ? size : 0));
+
+		allocator.deallocate(ptr);
+		ASSERT_TRUE(IrStd::AllocatorLarge::getNbMappings() == nbMappings);
+		ASSERT_TRUE(IrStd::AllocatorLarge::getMapped() == mapped);
+	}
+
+	// Accounted in the memory statistics
+	{
+		IrStd::Memory::StatisticsScope scope;
+		scope.startMonitoring();
+		void* const ptr = allocator.allocate(2 * IrStd::AllocatorLarge::HUGE_PAGE_SIZE);
+		ASSERT_TRUE(scope.getStatistics().getStatCurrentRaw() >= static_cast<int64_t>(2 * IrStd::AllocatorLarge::HUGE_PAGE_SIZE))
+				<< "current=" << scope.getStatistics().getStatCurrent();
+		allocator.deallocate(ptr);
+		scope.stopMonitoring();
+		ASSERT_TRUE(scope.getStatistics().getStatCurrentRaw() == 0) << "current=" << scope.getStatistics().getStatCurrent();
+	}
+
+	// Bind to the first node, this must work even if NUMA is not supported
+	{
+		IrStd::AllocatorLarge::setNode(0);
+		std::vector<uint64_t, IrStd::AllocatorObj<uint64_t, IrStd::AllocatorLarge>> data(1024 * 1024, 42);
+		ASSERT_TRUE(data[1024 * 1024 - 1] == 42);
+		IrStd::AllocatorLarge::setNode(-1);
+		getStdout() << "Mappings: " << IrStd::AllocatorLarge::getNbMappings() << " (huge pages: "
+				<< IrStd::AllocatorLarge::getNbHugeTLBMappings() << "), bind failure(s): "
+				<< IrStd::AllocatorLarge::getNbBindFailures() << std::endl;
+	}
+
+	// Large objects allocated dynamically
+	{
+		std::unique_ptr<IrStd::Type::RingBuffer<uint64_t, 64 * 1024>> pBuffer(new IrStd::Type::RingBuffer<uint64_t, 64 * 1024>());
+		ASSERT_TRUE(IrStd::AllocatorLarge::getNbMappings() == nbMappings + 1);
+		pBuffer->push(12);
+		ASSERT_TRUE(pBuffer->head() == 12);
+	}
+	ASSERT_TRUE(IrStd::AllocatorLarge::getNbMappings() == nbMappings);
+}
+
+// ---- AllocatorTest::testObjectPool -----------------------------------------
+
+namespace
+{
+	class PooledObject : public IrStd::AllocatorImpl<IrStd::AllocatorObjectPool<PooledObject>>
+	{
+	public:
+		explicit PooledObject(const size_t value)
+				: m_value(value)
+		{
+		}
+		size_t m_value;
+		char m_data[40];
+	};
+
+	class PooledObjectDerived : public PooledObject
+	{
+	public:
+		PooledObjectDerived()
+				: PooledObject(0)
+		{
+		}
+		char m_extra[100];
+	};
+}
+
+TEST_F(AllocatorTest, testObjectPool)
+{
+	auto& pool = IrStd::ObjectPool<PooledObject>::getInstance();
+	ASSERT_TRUE(std::string(pool.getName()).find("PooledObject") != std::string::npos) << pool.getName();
+	const auto stats = pool.getStatistics();
+	ASSERT_TRUE(stats.m_objectSize == sizeof(PooledObject));
+
+	// Memory is recycled by the same thread
+	{
+		PooledObject* const pObject1 = new PooledObject(1);
+		delete pObject1;
+		PooledObject* const pObject2 = new PooledObject(2);
+		ASSERT_TRUE(pObject1 == pObject2);
+		ASSERT_TRUE(pObject2->m_value == 2);
+		ASSERT_TRUE(reinterpret_cast<uintptr_t>(pObject2) % IrStd::ObjectPoolBase::ALIGNMENT == 0);
+		ASSERT_TRUE(pool.getStatistics().m_nbInUse == stats.m_nbInUse + 1);
+		delete pObject2;
+	}
+
+	// Larger objects come from the heap
+	{
+		std::unique_ptr<PooledObject> pObject(new PooledObjectDerived());
+		ASSERT_TRUE(pool.getStatistics().m_nbInUse == stats.m_nbInUse);
+	}
+
+	// Create through the pool directly
+	{
+		PooledObject* const pObject = pool.create(42);
+		ASSERT_TRUE(pObject->m_value == 42);
+		pool.destroy(pObject);
+	}
+
+	// Objects allocated and released by different threads
+	{
+		constexpr size_t NB_THREADS = 8;
+		constexpr size_t NB_OBJECTS = 10000;
+		std::vector<PooledObject*> objectList(NB_THREADS * NB_OBJECTS, nullptr);
+		std::thread threadList[NB_THREADS];
+		for (size_t i = 0; i < NB_THREADS; ++i)
+		{
+			threadList[i] = std::thread([&objectList, i]() {
+				for (size_t j = 0; j < NB_OBJECTS; ++j)
+				{
+					objectList[i * NB_OBJECTS + j] = new PooledObject(i * NB_OBJECTS + j);
+				}
+			});
+		}
+		for (auto& thread : threadList)
+		{
+			thread.join();
+		}
+		for (size_t i = 0; i < NB_THREADS; ++i)
+		{
+			threadList[i] = std::thread([&objectList, i]() {
+				// Release the objects of another thread
+				const size_t offset = ((i + 1) % NB_THREADS) * NB_OBJECTS;
+				for (size_t j = 0; j < NB_OBJECTS; ++j)
+				{
+					ASSERT_TRUE(objectList[offset + j]->m_value == offset + j);
+					delete objectList[offset + j];
+				}
+			});
+		}
+		for (auto& thread : threadList)
+		{
+			thread.join();
+		}
+	}
+
+	const auto statsEnd = pool.getStatistics();
+	ASSERT_TRUE(statsEnd.m_nbInUse == stats.m_nbInUse) << "nbInUse=" << statsEnd.m_nbInUse;
+	ASSERT_TRUE(statsEnd.m_nbAllocations == stats.m_nbAllocations + 3 + 8 * 10000);
+	// Only the allocations reserving a new slab are misses
+	ASSERT_TRUE(statsEnd.m_nbAllocations - statsEnd.m_nbHits == statsEnd.m_nbSlabs);
+
+	IrStd::Memory::getInstance().eachObjectPool([&](const char* const pName, const IrStd::Memory::ObjectPoolStatistics& poolStats) {
+		getStdout() << pName << ": " << IRSTD_OBJECTPOOL_STATISTICS_STREAM(poolStats) << std::endl;
+	});
+}
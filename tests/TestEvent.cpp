@@ -89,6 +89,80 @@ TEST_F(EventTest, testWaitForNexts)
 	}
 }
 
+// ---- testWaitForAny --------------------------------------------------------
+
+TEST_F(EventTest, testWaitForAny)
+{
+	IrStd::Event event1;
+	IrStd::Event event2;
+	IrStd::Event event3;
+
+	// Woken up by the first event triggered
+	{
+		std::thread t([&]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			event2.trigger();
+		});
+		const auto indexList = IrStd::Event::waitForAny(/*timeoutMs*/1000, event1, event2, event3);
+		t.join();
+		ASSERT_EQ(indexList.size(), 1u);
+		ASSERT_EQ(indexList[0], 1u);
+	}
+
+	// Reports all the events triggered at once
+	{
+		std::thread t([&]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			event1.trigger();
+			event3.trigger();
+		});
+		std::vector<IrStd::Event*> eventList{&event1, &event2, &event3};
+		std::vector<size_t> indexList;
+		while (indexList.size() < 2)
+		{
+			const auto firedList = IrStd::Event::waitForAny(/*timeoutMs*/1000, eventList);
+			ASSERT_FALSE(firedList.empty());
+			for (const auto index : firedList)
+			{
+				indexList.push_back(index);
+				eventList[index] = &event2;
+			}
+		}
+		t.join();
+		ASSERT_EQ(indexList.size(), 2u);
+		ASSERT_EQ(indexList[0], 0u);
+		ASSERT_EQ(indexList.back(), 2u);
+	}
+
+	// Timeout
+	{
+		ASSERT_TRUE(IrStd::Event::waitForAny(/*timeoutMs*/10, event1, event2).empty());
+		std::thread t([&]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			event1.trigger();
+		});
+		const auto* pEvent = IrStd::Event::waitForNexts(/*timeoutMs*/100, event1, event3);
+		t.join();
+		ASSERT_TRUE(pEvent == &event3);
+	}
+
+	// A reset ends the wait, the event is not reported as triggered
+	{
+		std::thread t([&]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			event2.reset();
+		});
+		const auto timeStart = std::chrono::steady_clock::now();
+		const auto* pEvent = IrStd::Event::waitForNexts(/*timeoutMs*/1000, event2);
+		t.join();
+		ASSERT_TRUE(pEvent == &event2);
+		ASSERT_LT(std::chrono::steady_clock::now() - timeStart, std::chrono::milliseconds(500));
+	}
+
+	// Nothing to wait for
+	ASSERT_TRUE(IrStd::Event::waitForAny(/*timeoutMs*/0, std::vector<IrStd::Event*>()).empty());
+}
+
 // ---- testWaitForAtLeast ----------------------------------------------------
 
 void EventTest::testWaitForAtLeastFctThread(IrStd::Event& event, const size_t nbThreads, bool& isBeforeWait)
@@ -126,3 +200,51 @@ TEST_F(EventTest, testWaitForAtLeast)
 		threadList[i].join();
 	}
 }
+
+// ---- testAdaptive ----------------------------------------------------------
+
+TEST_F(EventTest, testAdaptive)
+{
+	constexpr size_t NB_ROUNDS = 2000;
+
+	// Ping-pong between 2 threads, with and without spinning. The timings are
+	// informative only, spinning helps only when each thread has its own core.
+	for (const size_t maxSpins : {static_cast<size_t>(0), IrStd::Event::DEFAULT_MAX_SPINS})
+	{
+		IrStd::Event ping;
+		IrStd::Event pong;
+		ping.setAdaptive(maxSpins);
+		pong.setAdaptive(maxSpins);
+
+		std::thread t([&]() {
+			for (size_t i = 1; i <= NB_ROUNDS; ++i)
+			{
+				ping.waitForAtLeast(i);
+				pong.trigger();
+			}
+		});
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 1; i <= NB_ROUNDS; ++i)
+		{
+			ping.trigger();
+			pong.waitForAtLeast(i);
+		}
+		const auto duration = std::chrono::steady_clock::now() - start;
+		t.join();
+
+		ASSERT_EQ(ping.getCounter(), NB_ROUNDS);
+		ASSERT_EQ(pong.getCounter(), NB_ROUNDS);
+		getStdout() << "maxSpins=" << maxSpins << ", round-trip="
+				<< std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / NB_ROUNDS
+				<< "ns" << std::endl;
+	}
+
+	// Triggers without waiters still reach the callbacks
+	IrStd::Event event;
+	size_t counter = 0;
+	event.trigger();
+	event.onNext([&](const size_t value) { counter = value; });
+	event.trigger();
+	ASSERT_EQ(counter, 2u);
+}
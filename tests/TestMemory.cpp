@@ -51,3 +51,316 @@ TEST_F(MemoryTest, testRAM)
 	ASSERT_TRUE(used > current) << "used=" << used << ", current=" << current;
 	getStdout() << "RAM: total=" << total << ", used=" << used << ", current=" << current << std::endl;
 }
+
+TEST_F(MemoryTest, testMultiThread)
+{
+	constexpr size_t NB_THREADS = 8;
+	constexpr size_t NB_ALLOCATIONS = 10000;
+	std::thread threadList[NB_THREADS];
+
+	const size_t nbNew = IrStd::Memory::getInstance().getStatNbNew();
+	const size_t nbDelete = IrStd::Memory::getInstance().getStatNbDelete();
+
+	for (size_t i = 0; i < NB_THREADS; ++i)
+	{
+		threadList[i] = std::thread([]() {
+			std::vector<int*> pointerList(NB_ALLOCATIONS, nullptr);
+			for (size_t j = 0; j < NB_ALLOCATIONS; ++j)
+			{
+				pointerList[j] = new int(static_cast<int>(j));
+			}
+			for (size_t j = 0; j < NB_ALLOCATIONS; ++j)
+			{
+				ASSERT_TRUE(*pointerList[j] == static_cast<int>(j));
+				delete pointerList[j];
+			}
+		});
+	}
+	for (size_t i = 0; i < NB_THREADS; ++i)
+	{
+		threadList[i].join();
+	}
+
+	const size_t diffNew = IrStd::Memory::getInstance().getStatNbNew() - nbNew;
+	const size_t diffDelete = IrStd::Memory::getInstance().getStatNbDelete() - nbDelete;
+	ASSERT_TRUE(diffNew >= NB_THREADS * NB_ALLOCATIONS) << "diffNew=" << diffNew;
+	ASSERT_TRUE(diffNew == diffDelete) << "diffNew=" << diffNew << ", diffDelete=" << diffDelete;
+}
+
+TEST_F(MemoryTest, testThreadStatistics)
+{
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool isAllocated = false;
+	bool isDone = false;
+	std::thread::id threadId;
+	constexpr size_t SIZE = 4096;
+
+	std::thread thread([&]() {
+		char* const pBuffer = new char[SIZE];
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			threadId = std::this_thread::get_id();
+			isAllocated = true;
+			cv.notify_all();
+			cv.wait(lock, [&]() { return isDone; });
+		}
+		delete[] pBuffer;
+	});
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		cv.wait(lock, [&]() { return isAllocated; });
+	}
+
+	{
+		IrStd::Memory::Statistics stats;
+		ASSERT_TRUE(IrStd::Memory::getInstance().getThreadStatistics(threadId, stats));
+		ASSERT_TRUE(stats.getStatCurrent() >= SIZE) << "current=" << stats.getStatCurrent();
+		ASSERT_TRUE(stats.getStatNbNew() >= 1) << "nb.new=" << stats.getStatNbNew();
+	}
+
+	{
+		bool isFound = false;
+		IrStd::Memory::getInstance().eachThread([&](const std::thread::id id, const IrStd::Memory::Statistics& stats) {
+			if (id == threadId)
+			{
+				isFound = true;
+				ASSERT_TRUE(stats.getStatPeak() >= SIZE) << "peak=" << stats.getStatPeak();
+			}
+		});
+		ASSERT_TRUE(isFound);
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		isDone = true;
+		cv.notify_all();
+	}
+	thread.join();
+}
+
+TEST_F(MemoryTest, testHeapProfiler)
+{
+	if (!IrStd::Memory::getInstance().startProfiling(/*sampleInterval*/1))
+	{
+		getStdout() << "Heap profiler not available, skipping" << std::endl;
+		return;
+	}
+	ASSERT_TRUE(IrStd::Memory::getInstance().isProfiling());
+
+	// With an interval of 1 byte, all allocations are sampled
+	std::vector<char*> pointerList;
+	for (size_t i = 0; i < 100; ++i)
+	{
+		pointerList.push_back(new char[1000]);
+	}
+
+	{
+		std::stringstream stream;
+		IrStd::Memory::getInstance().dumpProfile(stream, IrStd::Memory::ProfileFormat::FLAMEGRAPH);
+		ASSERT_TRUE(stream.str().find("testHeapProfiler") != std::string::npos) << stream.str();
+	}
+
+	for (auto ptr : pointerList)
+	{
+		delete[] ptr;
+	}
+	pointerList.clear();
+	IrStd::Memory::getInstance().stopProfiling();
+	ASSERT_FALSE(IrStd::Memory::getInstance().isProfiling());
+
+	{
+		std::stringstream stream;
+		IrStd::Memory::getInstance().dumpProfile(stream, IrStd::Memory::ProfileFormat::PPROF);
+		const auto str = stream.str();
+		ASSERT_TRUE(str.find("heap profile: ") == 0) << str;
+		ASSERT_TRUE(str.find("heap_v2/1\n") != std::string::npos) << str;
+		ASSERT_TRUE(str.find("MAPPED_LIBRARIES:") != std::string::npos) << str;
+
+		// The blocks released must not be accounted anymore
+		size_t liveCount = 0;
+		size_t liveBytes = 0;
+		ASSERT_TRUE(std::sscanf(str.c_str(), "heap profile: %zu: %zu", &liveCount, &liveBytes) == 2) << str;
+		ASSERT_TRUE(liveBytes < 100 * 1000) << "liveBytes=" << liveBytes;
+	}
+}
+
+TEST_F(MemoryTest, testSnapshot)
+{
+	if (!IrStd::Memory::getInstance().startProfiling(/*sampleInterval*/1))
+	{
+		getStdout() << "Heap profiler not available, skipping" << std::endl;
+		return;
+	}
+
+	IrStd::Memory::Snapshot before;
+	IrStd::Memory::getInstance().takeSnapshot(before);
+
+	// Blocks of an unusual size to identify them
+	constexpr size_t SIZE = 12345;
+	std::vector<char*> pointerList;
+	pointerList.reserve(100);
+	for (size_t i = 0; i < 100; ++i)
+	{
+		pointerList.push_back(new char[SIZE]);
+	}
+
+	IrStd::Memory::Snapshot after;
+	IrStd::Memory::getInstance().takeSnapshot(after);
+	ASSERT_TRUE(after.getBytes() >= before.getBytes() + 100 * SIZE);
+
+	// All the blocks must be in the same group, with their call stack
+	{
+		bool isFound = false;
+		for (const auto& group : after.getGroupList())
+		{
+			if (group.m_size == SIZE)
+			{
+				ASSERT_EQ(group.m_count, 100u);
+				ASSERT_TRUE(group.m_depth > 0);
+				isFound = true;
+			}
+		}
+		ASSERT_TRUE(isFound);
+	}
+
+	// Only the blocks with a call stack are kept
+	{
+		IrStd::Memory::Snapshot traced;
+		IrStd::Memory::getInstance().takeSnapshot(traced);
+		traced.removeUntraced();
+		ASSERT_TRUE(traced.getBytes() >= 100 * SIZE);
+		for (const auto& group : traced.getGroupList())
+		{
+			ASSERT_TRUE(group.m_depth > 0);
+		}
+	}
+
+	{
+		std::stringstream stream;
+		IrStd::Memory::Snapshot::dumpDiff(stream, before, after);
+		const auto str = stream.str();
+		ASSERT_TRUE(str.find("+100 x 12345 byte(s)") != std::string::npos) << str;
+		ASSERT_TRUE(str.find("testSnapshot") != std::string::npos) << str;
+	}
+
+	for (auto ptr : pointerList)
+	{
+		delete[] ptr;
+	}
+	IrStd::Memory::getInstance().stopProfiling();
+
+	// Once released, the blocks are not reported anymore
+	{
+		std::stringstream stream;
+		IrStd::Memory::getInstance().dumpLeaks(stream);
+		ASSERT_TRUE(stream.str().find(" x 12345 byte(s)") == std::string::npos) << stream.str();
+	}
+}
+
+TEST_F(MemoryTest, testSampler)
+{
+	auto& memory = IrStd::Memory::getInstance();
+
+	// Within the interval, the sample must not change
+	memory.setSamplingInterval(/*intervalMs*/10000);
+	const auto sample1 = memory.getSample();
+	std::vector<char> buffer(10 * 1024 * 1024, 1);
+	const auto sample2 = memory.getSample();
+	ASSERT_TRUE(static_cast<uint64_t>(sample1.m_timestamp) == static_cast<uint64_t>(sample2.m_timestamp));
+	ASSERT_TRUE(static_cast<uint64_t>(sample1.m_ramCurrent) == static_cast<uint64_t>(sample2.m_ramCurrent));
+
+	// The resident memory is given in bytes
+	memory.setSamplingInterval(/*intervalMs*/0);
+	const auto sample3 = memory.getSample();
+	ASSERT_TRUE(static_cast<uint64_t>(sample3.m_ramCurrent) >= static_cast<uint64_t>(sample1.m_ramCurrent)
+			+ buffer.size() / 2) << "before=" << sample1.m_ramCurrent << ", after=" << sample3.m_ramCurrent;
+	ASSERT_TRUE(static_cast<uint64_t>(sample3.m_virtualMemoryCurrent) >= static_cast<uint64_t>(sample3.m_ramCurrent));
+
+	std::vector<IrStd::Memory::Sample> sampleList;
+	memory.getSampleHistory(sampleList);
+	ASSERT_TRUE(sampleList.size() >= 2);
+	ASSERT_TRUE(static_cast<uint64_t>(sampleList.back().m_ramCurrent) == static_cast<uint64_t>(sample3.m_ramCurrent));
+	for (size_t i = 1; i < sampleList.size(); ++i)
+	{
+		ASSERT_TRUE(static_cast<uint64_t>(sampleList[i - 1].m_timestamp) <= static_cast<uint64_t>(sampleList[i].m_timestamp));
+	}
+
+	memory.setSamplingInterval(IrStd::MemoryImpl::Sampler::DEFAULT_INTERVAL_MS);
+}
+
+TEST_F(MemoryTest, testBudget)
+{
+	IrStd::Memory::StatisticsScope scope;
+	scope.startMonitoring();
+	auto& budget = scope.getBudget();
+	std::vector<IrStd::Memory::Budget::Level> levelList;
+	const auto id = budget.addCallback([&](const IrStd::Memory::Budget::Level level, const IrStd::Type::Memory current) {
+		getStdout() << "Budget level=" << level << ", current=" << current << std::endl;
+		levelList.push_back(level);
+	});
+	levelList.reserve(16);
+
+	budget.set(1024 * 1024, 4 * 1024 * 1024);
+	ASSERT_TRUE(budget.getLevel() == IrStd::Memory::Budget::Level::NORMAL);
+
+	std::vector<std::vector<char>> bufferList;
+	bufferList.reserve(16);
+	// Above the soft limit
+	bufferList.emplace_back(2 * 1024 * 1024);
+	IrStd::Memory::getInstance().checkBudget();
+	ASSERT_TRUE(budget.getLevel() == IrStd::Memory::Budget::Level::SOFT) << "level=" << static_cast<int>(budget.getLevel());
+	// Above the hard limit
+	bufferList.emplace_back(3 * 1024 * 1024);
+	IrStd::Memory::getInstance().checkBudget();
+	ASSERT_TRUE(budget.getLevel() == IrStd::Memory::Budget::Level::HARD) << "level=" << static_cast<int>(budget.getLevel());
+	ASSERT_TRUE(IrStd::Memory::getInstance().getBudgetLevel() == IrStd::Memory::Budget::Level::HARD);
+	// Releases are large enough to re-evaluate the budget without explicit check
+	bufferList.pop_back();
+	ASSERT_TRUE(budget.getLevel() == IrStd::Memory::Budget::Level::SOFT) << "level=" << static_cast<int>(budget.getLevel());
+	bufferList.pop_back();
+	ASSERT_TRUE(budget.getLevel() == IrStd::Memory::Budget::Level::NORMAL) << "level=" << static_cast<int>(budget.getLevel());
+
+	ASSERT_TRUE(levelList.size() == 4) << "levelList.size()=" << levelList.size();
+	ASSERT_TRUE(levelList[0] == IrStd::Memory::Budget::Level::SOFT);
+	ASSERT_TRUE(levelList[1] == IrStd::Memory::Budget::Level::HARD);
+	ASSERT_TRUE(levelList[2] == IrStd::Memory::Budget::Level::SOFT);
+	ASSERT_TRUE(levelList[3] == IrStd::Memory::Budget::Level::NORMAL);
+
+	budget.removeCallback(id);
+	scope.stopMonitoring();
+}
+
+// ---- MemoryTest::testBudgetCallbackReentrant -------------------------------
+
+TEST_F(MemoryTest, testBudgetCallbackReentrant)
+{
+	IrStd::Memory::StatisticsScope scope;
+	scope.startMonitoring();
+	auto& budget = scope.getBudget();
+	size_t nbCalls = 0;
+	size_t nbCallsAdded = 0;
+	size_t id = 0;
+	// The callback replaces itself with another one
+	id = budget.addCallback([&](const IrStd::Memory::Budget::Level, const IrStd::Type::Memory) {
+		++nbCalls;
+		budget.removeCallback(id);
+		budget.addCallback([&](const IrStd::Memory::Budget::Level, const IrStd::Type::Memory) {
+			++nbCallsAdded;
+		});
+	});
+
+	budget.set(1024 * 1024, 0);
+	{
+		std::vector<char> buffer(2 * 1024 * 1024);
+		IrStd::Memory::getInstance().checkBudget();
+		ASSERT_TRUE(budget.getLevel() == IrStd::Memory::Budget::Level::SOFT);
+	}
+	IrStd::Memory::getInstance().checkBudget();
+	ASSERT_TRUE(budget.getLevel() == IrStd::Memory::Budget::Level::NORMAL);
+
+	ASSERT_EQ(nbCalls, 1u);
+	ASSERT_EQ(nbCallsAdded, 1u);
+	scope.stopMonitoring();
+}
@@ -1,3 +1,9 @@
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "../Test.hpp"
 #include "../IrStd.hpp"
 
@@ -6,6 +12,8 @@ class RWLockTest : public IrStd::Test
 public:
 	void threadRead(IrStd::RWLock& lock, std::string& data);
 	void threadWrite(IrStd::RWLock& lock, std::string& data, const char c);
+	template<class Lock, class Scope>
+	static uint64_t benchmark(const size_t nbThreads, const size_t nbLoops, Scope&& scope);
 };
 
 // ---- RWLockTest::testSimple ------------------------------------------------
@@ -87,3 +95,98 @@ TEST_F(RWLockTest, testMultiThread)
 		t[i].join();
 	}
 }
+
+// ---- RWLockTest::testWriterPreference --------------------------------------
+
+TEST_F(RWLockTest, testWriterPreference)
+{
+	IrStd::RWLock lock;
+	std::atomic<int> step(0);
+
+	auto readerScope = lock.readScope();
+
+	// The writer waits for the reader already in
+	std::thread writer([&]() {
+		auto scope = lock.writeScope();
+		step = 1;
+	});
+	while (!lock.isWriteScope())
+	{
+		std::this_thread::yield();
+	}
+
+	// New readers wait for the writer
+	std::thread reader([&]() {
+		auto scope = lock.readScope();
+		ASSERT_EQ(step.load(), 1);
+		step = 2;
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	ASSERT_EQ(step.load(), 0);
+
+	readerScope.release();
+	writer.join();
+	reader.join();
+	ASSERT_EQ(step.load(), 2);
+	ASSERT_EQ(lock.getCounter(), 0);
+}
+
+// ---- RWLockTest::benchmarkRead ---------------------------------------------
+
+template<class Lock, class Scope>
+uint64_t RWLockTest::benchmark(const size_t nbThreads, const size_t nbLoops, Scope&& scope)
+{
+	std::map<size_t, size_t> table;
+	for (size_t i = 0; i < 1024; ++i)
+	{
+		table[i] = i;
+	}
+	Lock lock;
+	std::atomic<size_t> sum(0);
+	std::vector<std::thread> threadList;
+
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < nbThreads; ++i)
+	{
+		threadList.push_back(std::thread([&, nbLoops]() {
+			size_t local = 0;
+			for (size_t j = 0; j < nbLoops; ++j)
+			{
+				auto guard = scope(lock);
+				local += table.find(j % 1024)->second;
+			}
+			sum += local;
+		}));
+	}
+	for (auto& thread : threadList)
+	{
+		thread.join();
+	}
+	const auto duration = std::chrono::steady_clock::now() - start;
+
+	IRSTD_ASSERT(sum.load() == nbThreads * (nbLoops / 1024 * (1023 * 1024 / 2)
+			+ (nbLoops % 1024) * (nbLoops % 1024 - 1) / 2));
+
+	// Throughput of all the threads together
+	return static_cast<uint64_t>(static_cast<int64_t>(nbThreads * nbLoops) * 1000000
+			/ std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count(), 1));
+}
+
+TEST_F(RWLockTest, benchmarkRead)
+{
+	constexpr size_t NB_LOOPS = 200000;
+	const size_t nbThreadsMax = std::max(static_cast<size_t>(2),
+			std::min(static_cast<size_t>(8), static_cast<size_t>(std::thread::hardware_concurrency())));
+
+	for (size_t nbThreads = 1; nbThreads <= nbThreadsMax; nbThreads *= 2)
+	{
+		const auto opsMutex = benchmark<std::mutex>(nbThreads, NB_LOOPS, [](std::mutex& lock) {
+			return std::unique_lock<std::mutex>(lock);
+		});
+		const auto opsRWLock = benchmark<IrStd::RWLock>(nbThreads, NB_LOOPS, [](IrStd::RWLock& lock) {
+			return lock.readScope();
+		});
+		getStdout() << "threads=" << nbThreads << ", std::mutex=" << opsMutex
+				<< "op/s, RWLock=" << opsRWLock << "op/s" << std::endl;
+	}
+}
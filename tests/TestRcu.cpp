@@ -0,0 +1,142 @@
+#include <atomic>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "../Test.hpp"
+#include "../IrStd.hpp"
+
+class RcuTest : public IrStd::Test
+{
+public:
+	// Count the live instances, to check that retired versions are deleted
+	struct Counted
+	{
+		Counted(const size_t value = 0)
+				: m_value(value)
+		{
+			++nbInstances;
+		}
+		Counted(const Counted& counted)
+				: m_value(counted.m_value)
+		{
+			++nbInstances;
+		}
+		~Counted()
+		{
+			--nbInstances;
+		}
+		size_t m_value;
+		static std::atomic<int> nbInstances;
+	};
+};
+
+std::atomic<int> RcuTest::Counted::nbInstances(0);
+
+// ---- RcuTest::testSimple ---------------------------------------------------
+
+TEST_F(RcuTest, testSimple)
+{
+	{
+		IrStd::Rcu<Counted> rcu(Counted(1));
+		ASSERT_EQ(rcu.read()->m_value, 1u);
+
+		// A reader keeps its version
+		{
+			auto scope = rcu.read();
+			rcu.publish(Counted(2));
+			ASSERT_EQ(scope->m_value, 1u);
+			ASSERT_EQ(rcu.read()->m_value, 2u);
+			ASSERT_EQ(rcu.getNbRetired(), 1u);
+		}
+
+		// Reclaimed once the reader is gone
+		rcu.update([](Counted& value) {
+			value.m_value += 40;
+		});
+		ASSERT_EQ(rcu.read()->m_value, 42u);
+		rcu.synchronize();
+		ASSERT_EQ(rcu.getNbRetired(), 0u);
+		ASSERT_EQ(Counted::nbInstances.load(), 1);
+	}
+	ASSERT_EQ(Counted::nbInstances.load(), 0);
+}
+
+// ---- RcuTest::testMove -----------------------------------------------------
+
+TEST_F(RcuTest, testMove)
+{
+	IrStd::Rcu<Counted> rcu(Counted(1));
+	{
+		auto scope = rcu.read();
+		// The moved scope releases the reading state once only
+		{
+			auto movedScope = std::move(scope);
+			auto nestedScope = rcu.read();
+			rcu.publish(Counted(2));
+			ASSERT_EQ(movedScope->m_value, 1u);
+		}
+		rcu.synchronize();
+		ASSERT_EQ(rcu.getNbRetired(), 0u);
+
+		// The reading state is back to idle, new scopes are tracked again
+		auto otherScope = rcu.read();
+		rcu.publish(Counted(3));
+		ASSERT_EQ(rcu.getNbRetired(), 1u);
+		otherScope.release();
+		rcu.synchronize();
+		ASSERT_EQ(rcu.getNbRetired(), 0u);
+	}
+	ASSERT_EQ(Counted::nbInstances.load(), 1);
+}
+
+// ---- RcuTest::testMultiThread ----------------------------------------------
+
+TEST_F(RcuTest, testMultiThread)
+{
+	constexpr size_t NB_READ_THREADS = 3;
+	constexpr size_t NB_UPDATES = 2000;
+	IrStd::Rcu<std::map<size_t, size_t>> rcu;
+	std::atomic<bool> isDone(false);
+	std::atomic<size_t> nbErrors(0);
+	std::vector<std::thread> threadList;
+
+	// Readers check that a version is consistent, every key maps to the size
+	for (size_t i = 0; i < NB_READ_THREADS; ++i)
+	{
+		threadList.push_back(std::thread([&]() {
+			while (!isDone)
+			{
+				const auto map = rcu.read();
+				for (const auto& item : *map)
+				{
+					if (item.second != map->size())
+					{
+						++nbErrors;
+					}
+				}
+			}
+		}));
+	}
+
+	for (size_t j = 1; j <= NB_UPDATES; ++j)
+	{
+		rcu.update([j](std::map<size_t, size_t>& map) {
+			map[j % 64] = 0;
+			for (auto& item : map)
+			{
+				item.second = map.size();
+			}
+		});
+	}
+	isDone = true;
+	for (auto& thread : threadList)
+	{
+		thread.join();
+	}
+
+	ASSERT_EQ(nbErrors.load(), 0u);
+	ASSERT_EQ(rcu.read()->size(), 64u);
+	rcu.synchronize();
+	ASSERT_EQ(rcu.getNbRetired(), 0u);
+}
@@ -0,0 +1,89 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../Test.hpp"
+#include "../IrStd.hpp"
+
+class SeqLockTest : public IrStd::Test
+{
+public:
+	// Fields are always written with the same value, a torn read would mix them
+	struct Snapshot
+	{
+		uint64_t m_a;
+		uint64_t m_b;
+		uint32_t m_c;
+	};
+};
+
+// ---- SeqLockTest::testSimple -----------------------------------------------
+
+TEST_F(SeqLockTest, testSimple)
+{
+	IrStd::SeqLock<Snapshot> lock(Snapshot{1, 1, 1});
+	{
+		const auto value = lock.load();
+		ASSERT_EQ(value.m_a, 1u);
+		ASSERT_EQ(value.m_c, 1u);
+	}
+	const auto sequence = lock.getSequence();
+	lock.store(Snapshot{2, 2, 2});
+	ASSERT_EQ(lock.getSequence(), sequence + 2);
+	ASSERT_EQ(lock.load().m_b, 2u);
+
+	lock.update([](Snapshot value) {
+		value.m_a += 40;
+		return value;
+	});
+	ASSERT_EQ(lock.load().m_a, 42u);
+	ASSERT_EQ(lock.load().m_b, 2u);
+}
+
+// ---- SeqLockTest::testMultiThread ------------------------------------------
+
+TEST_F(SeqLockTest, testMultiThread)
+{
+	constexpr size_t NB_READ_THREADS = 3;
+	constexpr size_t NB_WRITES = 20000;
+	IrStd::SeqLock<Snapshot> lock(Snapshot{0, 0, 0});
+	std::atomic<bool> isDone(false);
+	std::atomic<size_t> nbTorn(0);
+	std::vector<std::thread> threadList;
+
+	for (size_t i = 0; i < NB_READ_THREADS; ++i)
+	{
+		threadList.push_back(std::thread([&]() {
+			while (!isDone)
+			{
+				const auto value = lock.load();
+				if (value.m_a != value.m_b || value.m_a != value.m_c)
+				{
+					++nbTorn;
+				}
+			}
+		}));
+	}
+
+	// Two concurrent writers
+	auto writer = [&]() {
+		for (size_t j = 0; j < NB_WRITES; ++j)
+		{
+			lock.update([](Snapshot value) {
+				return Snapshot{value.m_a + 1, value.m_b + 1, value.m_c + 1};
+			});
+		}
+	};
+	std::thread writer1(writer);
+	std::thread writer2(writer);
+	writer1.join();
+	writer2.join();
+	isDone = true;
+	for (auto& thread : threadList)
+	{
+		thread.join();
+	}
+
+	ASSERT_EQ(nbTorn.load(), 0u);
+	ASSERT_EQ(lock.load().m_a, NB_WRITES * 2);
+}
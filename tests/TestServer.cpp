@@ -1,4 +1,8 @@
+#include <cstring>
 #include <thread>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include "../Test.hpp"
 #include "../IrStd.hpp"
@@ -407,3 +411,29 @@ TEST_F(ServerTest, testServerREST)
 
 	serverData.stop();
 }
+
+// ---- testStopIdleConnection ------------------------------------------------
+
+TEST_F(ServerTest, testStopIdleConnection)
+{
+	auto serverData = createServer<EchoHTTPServer>(/*port*/12345);
+	serverData.start();
+
+	// A client connected but not sending anything
+	const int sockFd = ::socket(AF_INET, SOCK_STREAM, 0);
+	ASSERT_TRUE(sockFd >= 0);
+	struct ::sockaddr_in addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(12345);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	ASSERT_EQ(::connect(sockFd, reinterpret_cast<struct ::sockaddr*>(&addr), sizeof(addr)), 0);
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	// The stop does not wait for the client timeout
+	const auto start = std::chrono::steady_clock::now();
+	serverData.stop();
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+	::close(sockFd);
+}
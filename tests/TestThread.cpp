@@ -1,3 +1,8 @@
+#include <array>
+#include <future>
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include "../Test.hpp"
 #include "../IrStd.hpp"
 
@@ -95,6 +100,125 @@ TEST_F(ThreadTest, testStatus)
 	}
 }
 
+// ---- testCurrent -----------------------------------------------------------
+
+TEST_F(ThreadTest, testCurrent)
+{
+	ASSERT_EQ(IrStd::Thread::getCurrent(), nullptr);
+
+	std::atomic<bool> isMatch(false);
+	std::atomic<bool> isDone(false);
+	const auto id = IrStd::Threads::create("testCurrent", [&]() {
+		auto pThread = IrStd::Thread::getCurrent();
+		isMatch = (pThread && pThread == IrStd::Threads::get().get()
+				&& pThread->getId() == std::this_thread::get_id()
+				&& IrStd::Threads::isRegistered() && !IrStd::Threads::isTerminated()
+				&& IrStd::Threads::setIdle() && IrStd::Threads::setActive());
+		isDone = true;
+	});
+	// Terminating the thread earlier would be seen by the thread itself
+	while (!isDone)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	IrStd::Threads::terminate(id);
+	ASSERT_TRUE(isMatch);
+}
+
+// ---- testAffinity ----------------------------------------------------------
+
+TEST_F(ThreadTest, testAffinity)
+{
+	const auto cpuList = IrStd::Thread::getCpuList();
+	ASSERT_FALSE(cpuList.empty());
+
+	std::vector<size_t> threadCpuList;
+	const auto id = IrStd::Threads::create("testAffinity", [&]() {
+		auto pThread = IrStd::Thread::getCurrent();
+		if (pThread->setAffinity({cpuList.back()}))
+		{
+			threadCpuList = IrStd::Thread::getCpuList();
+		}
+		pThread->setNice(5);
+		pThread->setPolicy(IrStd::Thread::Policy::BATCH);
+	});
+	IrStd::Threads::terminate(id);
+#if IRSTD_IS_PLATFORM(LINUX)
+	ASSERT_EQ(threadCpuList, std::vector<size_t>{cpuList.back()});
+#endif
+
+	// Pinned workers run on a single CPU each
+	IrStd::ThreadPool<2> pool("testAffinity");
+	pool.setPinned(true);
+	ASSERT_TRUE(pool.isPinned());
+	auto future = pool.submit([]() {
+		return IrStd::Thread::getCpuList().size();
+	});
+#if IRSTD_IS_PLATFORM(LINUX)
+	ASSERT_EQ(future.get(), 1u);
+#endif
+	pool.setPinned(false);
+	future = pool.submit([]() {
+		return IrStd::Thread::getCpuList().size();
+	});
+	future.wait();
+}
+
+// ---- testStatistics --------------------------------------------------------
+
+TEST_F(ThreadTest, testStatistics)
+{
+	auto thread = IrStd::Thread::create("testStatistics", []() {
+		// Busy for 30ms, then idle for 30ms
+		const auto timeEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(30);
+		while (std::chrono::steady_clock::now() < timeEnd)
+		{
+		}
+		IrStd::Thread::getCurrent()->sleep(30);
+	});
+	// Wait for the thread to exit by itself
+	while (!thread->isTerminated())
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	thread->terminate();
+
+	IrStd::Thread::Statistics stats;
+	thread->getStatistics(stats);
+	ASSERT_GE(stats.m_activeTimeNs, 25000000u);
+	ASSERT_GE(stats.m_idleTimeNs, 25000000u);
+	ASSERT_EQ(stats.m_nbJobs, 0u);
+#if IRSTD_IS_PLATFORM(LINUX)
+	ASSERT_GE(stats.m_cpuTimeNs, 10000000u);
+	ASSERT_LE(stats.m_cpuTimeNs, stats.m_activeTimeNs + stats.m_idleTimeNs);
+	ASSERT_GE(stats.m_nbVoluntarySwitches, 1u);
+#endif
+
+	// Jobs processed by the workers
+	{
+		IrStd::ThreadPool<2> pool("testStatistics");
+		for (size_t i=0; i<100; ++i)
+		{
+			pool.addJob([]() {});
+		}
+		pool.waitForAllJobsToBeCompleted();
+
+		uint64_t nbJobs = 0;
+		IrStd::Threads::each([&](const IrStd::Thread& worker) {
+			if (std::string(worker.getName()).find("testStatistics") == 0)
+			{
+				worker.getStatistics(stats);
+				nbJobs += stats.m_nbJobs;
+			}
+		});
+		ASSERT_EQ(nbJobs, 100u);
+
+		std::stringstream stream;
+		IrStd::Threads::toStream(stream);
+		ASSERT_NE(stream.str().find("jobs="), std::string::npos);
+	}
+}
+
 // ---- testConstructor -------------------------------------------------------
 
 static bool testConstructorFctStaticFlag = false;
@@ -207,3 +331,398 @@ TEST_F(ThreadTest, testPool)
 
 	ASSERT_TRUE(counter == 100) << "counter=" << counter;
 }
+
+TEST_F(ThreadTest, testPoolWorkStealing)
+{
+	constexpr size_t DEPTH = 14;
+	std::atomic<size_t> counter(0);
+	{
+		IrStd::ThreadPool<4> pool("testPoolWorkStealing");
+
+		// Each job adds two jobs from its worker, they are stolen by the others
+		std::function<void(size_t)> spawn = [&](const size_t depth) {
+			if (depth == DEPTH)
+			{
+				++counter;
+				return;
+			}
+			pool.addJob([&spawn, depth]() { spawn(depth + 1); });
+			pool.addJob([&spawn, depth]() { spawn(depth + 1); });
+		};
+		pool.addJob([&spawn]() { spawn(0); });
+
+		pool.waitForAllJobsToBeCompleted();
+		ASSERT_EQ(counter.load(), static_cast<size_t>(1) << DEPTH);
+		ASSERT_EQ(pool.getNbPendingJobs(), 0u);
+
+		// Workers must wake up again after sleeping
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		for (size_t i=0; i<1000; ++i)
+		{
+			pool.addJob([&]() { ++counter; });
+		}
+		pool.waitForAllJobsToBeCompleted();
+	}
+
+	ASSERT_EQ(counter.load(), (static_cast<size_t>(1) << DEPTH) + 1000);
+}
+
+TEST_F(ThreadTest, testPoolFuture)
+{
+	IrStd::ThreadPool<3> pool("testPoolFuture");
+
+	// Chain continuations
+	{
+		auto future = pool.submit([]() { return 20; })
+				.then([](const int value) { return value * 2; })
+				.then([](const int value) { return std::to_string(value + 2); });
+		ASSERT_EQ(future.get(), "42");
+	}
+
+	// Exceptions are forwarded through the continuations
+	{
+		bool isCalled = false;
+		auto future = pool.submit([]() -> int { throw std::runtime_error("error"); })
+				.then([&](const int) { isCalled = true; });
+		ASSERT_THROW(future.get(), std::runtime_error);
+		ASSERT_FALSE(isCalled);
+	}
+
+	// Wait for several jobs without blocking a worker
+	{
+		std::atomic<size_t> counter(0);
+		std::vector<IrStd::Future<size_t>> futureList;
+		for (size_t i=0; i<100; ++i)
+		{
+			futureList.push_back(pool.submit([&counter, i]() {
+				++counter;
+				return i;
+			}));
+		}
+		auto future = IrStd::whenAll(futureList).then([&]() {
+			size_t sum = 0;
+			for (const auto& item : futureList)
+			{
+				sum += item.get();
+			}
+			return sum;
+		});
+		ASSERT_EQ(future.get(), 99u * 100u / 2);
+		ASSERT_EQ(counter.load(), 100u);
+	}
+
+	// The first job to complete
+	{
+		IrStd::Promise<int> promise;
+		std::vector<IrStd::Future<int>> futureList{promise.getFuture(), pool.submit([]() { return 1; })};
+		ASSERT_EQ(IrStd::whenAny(futureList).get(), 1u);
+		promise.setValue(0);
+		ASSERT_TRUE(futureList[0].isReady());
+	}
+
+	// A promise destroyed without being set
+	{
+		IrStd::Future<int> future;
+		ASSERT_FALSE(future.isValid());
+		{
+			IrStd::Promise<int> promise;
+			future = promise.getFuture();
+		}
+		ASSERT_TRUE(future.isValid());
+		ASSERT_TRUE(future.isReady());
+		ASSERT_THROW(future.get(), std::future_error);
+
+		// No state once moved from
+		const auto movedFuture = std::move(future);
+		ASSERT_FALSE(future.isValid());
+		ASSERT_TRUE(movedFuture.isValid());
+	}
+
+	pool.waitForAllJobsToBeCompleted();
+}
+
+TEST_F(ThreadTest, testPoolDiscard)
+{
+	std::atomic<bool> isRelease(false);
+	IrStd::Future<int> future;
+	IrStd::Future<int> futureThen;
+	std::thread releaseThread;
+	{
+		IrStd::ThreadPool<1> pool("testPoolDiscard");
+		pool.submit([&]() {
+			while (!isRelease)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		});
+		// Still queued when the pool is destroyed, the worker being busy
+		future = pool.submit([]() { return 1; });
+		futureThen = future.then([](const int value) { return value + 1; });
+		releaseThread = std::thread([&]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+			isRelease = true;
+		});
+	}
+	releaseThread.join();
+
+	ASSERT_THROW(future.get(), std::future_error);
+	ASSERT_THROW(futureThen.get(), std::future_error);
+}
+
+TEST_F(ThreadTest, testPoolElastic)
+{
+	std::atomic<bool> isRelease(false);
+	std::atomic<size_t> counter(0);
+	IrStd::ThreadPool<> pool("testPoolElastic", /*maxWorkers*/4, /*minWorkers*/1, /*idleTimeoutMs*/50);
+	ASSERT_EQ(pool.getNbWorkers(), 1u);
+
+	// Release the jobs before the pool is destroyed, even if the test fails
+	struct Release
+	{
+		~Release()
+		{
+			m_isRelease = true;
+		}
+		std::atomic<bool>& m_isRelease;
+	} release{isRelease};
+
+	// Blocking jobs queue up, workers are added to handle them
+	for (size_t i=0; i<8; ++i)
+	{
+		pool.addJob([&]() {
+			while (!isRelease)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			++counter;
+		});
+	}
+	ASSERT_EQ(pool.getNbWorkers(), 4u);
+	isRelease = true;
+	pool.waitForAllJobsToBeCompleted();
+	ASSERT_EQ(counter.load(), 8u);
+
+	// Idle workers exit, down to the minimum
+	for (size_t i=0; i<100 && pool.getNbWorkers() > 1; ++i)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	ASSERT_EQ(pool.getNbWorkers(), 1u);
+
+	// And are added again when needed
+	isRelease = false;
+	for (size_t i=0; i<4; ++i)
+	{
+		pool.addJob([&]() {
+			while (!isRelease)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			++counter;
+		});
+	}
+	ASSERT_TRUE(pool.getNbWorkers() > 1);
+	isRelease = true;
+	pool.waitForAllJobsToBeCompleted();
+	ASSERT_EQ(counter.load(), 12u);
+}
+
+TEST_F(ThreadTest, testPoolPriority)
+{
+	typedef IrStd::ThreadPool<1>::Priority Priority;
+	IrStd::ThreadPool<1> pool("testPoolPriority");
+	std::vector<int> order;
+	std::atomic<bool> isStarted(false);
+	std::atomic<bool> isRelease(false);
+
+	// Keep the only worker busy while the jobs are added
+	const auto block = [&]() {
+		pool.addJob([&]() {
+			isStarted = true;
+			while (!isRelease)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		});
+		while (!isStarted)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	};
+
+	// By priority class, then deadlines first within a class, earliest first
+	block();
+	pool.addJob([&]() { order.push_back(6); }, Priority::LOW);
+	pool.addJob([&]() { order.push_back(4); }, Priority::NORMAL);
+	pool.addJob([&]() { order.push_back(1); }, Priority::HIGH);
+	pool.addJob([&]() { order.push_back(5); }, Priority::LOW, /*deadlineMs*/10);
+	pool.addJob([&]() { order.push_back(3); }, Priority::NORMAL, /*deadlineMs*/1000);
+	pool.addJob([&]() { order.push_back(2); }, Priority::NORMAL, /*deadlineMs*/10);
+	isRelease = true;
+	pool.waitForAllJobsToBeCompleted();
+	ASSERT_EQ(order, (std::vector<int>{1, 2, 3, 4, 5, 6}));
+
+	// A low priority job does not starve under a flow of high priority jobs
+	order.clear();
+	isStarted = false;
+	isRelease = false;
+	block();
+	pool.addJob([&]() { order.push_back(1); }, Priority::LOW);
+	for (size_t i=0; i<IrStd::ThreadPool<1>::STARVATION_PERIOD * 2; ++i)
+	{
+		pool.addJob([&]() { order.push_back(0); }, Priority::HIGH);
+	}
+	isRelease = true;
+	pool.waitForAllJobsToBeCompleted();
+	ASSERT_EQ(order.size(), IrStd::ThreadPool<1>::STARVATION_PERIOD * 2 + 1);
+	ASSERT_NE(order.back(), 1);
+}
+
+TEST_F(ThreadTest, testPoolBatch)
+{
+	IrStd::ThreadPool<4> pool("testPoolBatch");
+
+	// Batch of jobs
+	std::atomic<size_t> counter(0);
+	std::vector<std::function<void()>> jobList(1000, [&]() { ++counter; });
+	pool.addJobs(jobList.begin(), jobList.end());
+	pool.waitForAllJobsToBeCompleted();
+	ASSERT_EQ(counter.load(), 1000u);
+
+	// The jobs already created are released if one of them fails
+	{
+		struct Counted
+		{
+			Counted(int& nbInstances, int& nbCopiesLeft)
+					: m_pNbInstances(&nbInstances)
+					, m_pNbCopiesLeft(&nbCopiesLeft)
+			{
+				++*m_pNbInstances;
+			}
+			Counted(const Counted& counted)
+					: m_pNbInstances(counted.m_pNbInstances)
+					, m_pNbCopiesLeft(counted.m_pNbCopiesLeft)
+			{
+				if (!(*m_pNbCopiesLeft)--)
+				{
+					throw std::runtime_error("copy");
+				}
+				++*m_pNbInstances;
+			}
+			~Counted()
+			{
+				--*m_pNbInstances;
+			}
+			void operator()() const
+			{
+			}
+			int* m_pNbInstances;
+			int* m_pNbCopiesLeft;
+		};
+		int nbInstances = 0;
+		int nbCopiesLeft = 100;
+		std::vector<Counted> countedList(10, Counted(nbInstances, nbCopiesLeft));
+		ASSERT_EQ(nbInstances, 10);
+		nbCopiesLeft = 5;
+		ASSERT_THROW(pool.addJobs(countedList.begin(), countedList.end()), std::runtime_error);
+		ASSERT_EQ(nbInstances, 10);
+		ASSERT_EQ(pool.getNbPendingJobs(), 0u);
+	}
+
+	// Each index is processed exactly once
+	std::vector<std::atomic<int>> hitList(100003);
+	for (auto& hit : hitList)
+	{
+		hit = 0;
+	}
+	pool.parallelFor(0, hitList.size(), 1000, [&](const size_t i) {
+		++hitList[i];
+	});
+	for (const auto& hit : hitList)
+	{
+		ASSERT_EQ(hit.load(), 1);
+	}
+
+	// Nested in a job
+	std::atomic<uint64_t> sum(0);
+	auto future = pool.submit([&]() {
+		pool.parallelFor(10, 1010, 7, [&](const size_t i) {
+			sum += i;
+		});
+	});
+	future.get();
+	ASSERT_EQ(sum.load(), 10u * 1000 + 1000u * 999 / 2);
+
+	// Exceptions are forwarded to the caller
+	counter = 0;
+	ASSERT_THROW(pool.parallelFor(0, 100, 1, [&](const size_t i) {
+		++counter;
+		if (i == 50)
+		{
+			throw std::runtime_error("error");
+		}
+	}), std::runtime_error);
+	ASSERT_EQ(counter.load(), 100u);
+}
+
+// ---- testPoolTask ----------------------------------------------------------
+
+TEST_F(ThreadTest, testPoolTask)
+{
+	IrStd::ThreadPool<2> pool("testPoolTask");
+
+	// Wait for sockets without blocking a worker per socket
+	{
+		IrStd::Reactor reactor(&pool);
+		std::vector<std::array<int, 2>> socketList(50);
+		std::vector<IrStd::Future<char>> futureList;
+		for (auto& fds : socketList)
+		{
+			ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()), 0);
+			const int fd = fds[0];
+			futureList.push_back(reactor.whenReadable(fd).then([fd]() {
+				char c = 0;
+				return (::read(fd, &c, 1) == 1) ? c : '\0';
+			}));
+		}
+		for (size_t i=0; i<socketList.size(); ++i)
+		{
+			const char c = static_cast<char>('a' + (i % 26));
+			ASSERT_EQ(::write(socketList[i][1], &c, 1), 1);
+		}
+		for (size_t i=0; i<socketList.size(); ++i)
+		{
+			ASSERT_EQ(futureList[i].get(), static_cast<char>('a' + (i % 26)));
+		}
+
+		// Cancelled waits are set with an exception
+		auto future = reactor.whenReadable(socketList[0][0]);
+		reactor.cancel(socketList[0][0]);
+		ASSERT_ANY_THROW(future.get());
+
+		for (auto& fds : socketList)
+		{
+			::close(fds[0]);
+			::close(fds[1]);
+		}
+	}
+
+	// Event triggers
+	{
+		IrStd::Event event;
+		const size_t counter = event.getCounter();
+		auto future = IrStd::whenTriggered(event, &pool).then([](const size_t value) { return value * 2; });
+		event.trigger();
+		ASSERT_EQ(future.get(), (counter + 1) * 2);
+	}
+
+	// Timers
+	{
+		IrStd::Timer timer(&pool);
+		const auto start = std::chrono::steady_clock::now();
+		timer.whenElapsed(20).then([]() { return 1; }).get();
+		ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+	}
+
+	pool.waitForAllJobsToBeCompleted();
+}
@@ -0,0 +1,104 @@
+#include "../Test.hpp"
+#include "../IrStd.hpp"
+
+class TimerTest : public IrStd::Test
+{
+};
+
+// ---- TimerTest::testOnce ---------------------------------------------------
+
+TEST_F(TimerTest, testOnce)
+{
+	IrStd::Timer timer;
+	std::atomic<int> order(0);
+	std::atomic<int> first(0);
+	std::atomic<int> second(0);
+
+	timer.once(40, [&]() { second = ++order; });
+	timer.once(10, [&]() { first = ++order; });
+	const auto id = timer.once(20, [&]() { ++order; });
+	// Does not stop the timer thread
+	timer.once(30, []() { throw 42; });
+	ASSERT_EQ(timer.size(), 4u);
+	ASSERT_TRUE(timer.cancel(id));
+	ASSERT_FALSE(timer.cancel(id));
+
+	const auto timeStart = std::chrono::steady_clock::now();
+	while (!second && std::chrono::steady_clock::now() - timeStart < std::chrono::seconds(5))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	ASSERT_GE(std::chrono::steady_clock::now() - timeStart, std::chrono::milliseconds(35));
+	ASSERT_EQ(first.load(), 1);
+	ASSERT_EQ(second.load(), 2);
+	ASSERT_EQ(timer.size(), 0u);
+}
+
+// ---- TimerTest::testIdle ---------------------------------------------------
+
+TEST_F(TimerTest, testIdle)
+{
+	IrStd::Timer timer;
+	std::atomic<bool> isDone(false);
+
+	// The ticks elapsed while the timer is idle are skipped
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	const auto timeStart = std::chrono::steady_clock::now();
+	timer.once(30, [&]() { isDone = true; });
+	ASSERT_LT(std::chrono::steady_clock::now() - timeStart, std::chrono::milliseconds(20));
+
+	while (!isDone && std::chrono::steady_clock::now() - timeStart < std::chrono::seconds(5))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	const auto elapsed = std::chrono::steady_clock::now() - timeStart;
+	ASSERT_TRUE(isDone);
+	ASSERT_GE(elapsed, std::chrono::milliseconds(25));
+	ASSERT_LT(elapsed, std::chrono::milliseconds(250));
+}
+
+// ---- TimerTest::testEvery --------------------------------------------------
+
+TEST_F(TimerTest, testEvery)
+{
+	IrStd::ThreadPool<2> pool("testEvery");
+	IrStd::Timer timer(&pool);
+	std::atomic<size_t> counter(0);
+
+	const auto id = timer.every(5, [&]() { ++counter; });
+	while (counter < 10)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	ASSERT_TRUE(timer.cancel(id));
+	pool.waitForAllJobsToBeCompleted();
+	const size_t nbRuns = counter;
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	ASSERT_EQ(counter.load(), nbRuns);
+}
+
+// ---- TimerTest::testWheel --------------------------------------------------
+
+TEST_F(TimerTest, testWheel)
+{
+	// With 1 tick per ms the entries go through the upper levels of the wheel
+	IrStd::Timer timer;
+	std::atomic<size_t> counter(0);
+	std::vector<IrStd::Timer::Id> idList;
+	for (size_t i=0; i<200; ++i)
+	{
+		idList.push_back(timer.once(250 + i * 3, [&]() { ++counter; }));
+	}
+	// Far away, never reached
+	idList.push_back(timer.once(1000 * 60 * 60 * 24, [&]() { ++counter; }));
+	ASSERT_EQ(timer.size(), 201u);
+
+	const auto timeStart = std::chrono::steady_clock::now();
+	while (counter < 200 && std::chrono::steady_clock::now() - timeStart < std::chrono::seconds(10))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	ASSERT_EQ(counter.load(), 200u);
+	ASSERT_EQ(timer.size(), 1u);
+	ASSERT_TRUE(timer.cancel(idList.back()));
+}